@@ -0,0 +1,163 @@
+/*
+ * This file contains an implementation of an admission controller for the
+ * call queue.  It combines three checks, cheapest first:
+ *
+ *   - A hard limit on queue depth, so memory stays bounded whatever the
+ *     arrival rate.
+ *   - A token bucket, which admits calls at a sustained `rate` with bursts
+ *     of up to `burst` calls.
+ *   - An estimate of how long a new call would wait: the depth of the
+ *     queue divided by the recent service rate.  The service rate is an
+ *     exponentially weighted moving average of the time between answers,
+ *     sampled only while calls were waiting, since gaps when the agents
+ *     had nothing to do say nothing about how fast they work.
+ *
+ * Calls failing either of the first two are rejected.  Calls failing only
+ * the wait estimate are diverted to a callback, since the customer can be
+ * served once the backlog clears.  Time is passed in by the caller, in
+ * nanoseconds, so the controller works the same on the real clock and on
+ * a replayed trace.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "admission.h"
+
+#define ADMISSION_EWMA_WEIGHT 0.1
+
+/*
+ * This structure is used to represent an admission controller.
+ * `interval_ns` is the moving average of the time between answers, or 0
+ * until the first sample.
+ */
+struct admission {
+  struct admission_config cfg;
+  double tokens;
+  long long refilled;     // Time the bucket was last topped up
+  double interval_ns;
+  long long last_served;  // Time of the last answer, or -1
+  int backlogged;         // Calls were waiting after the last answer
+  long counts[3];         // Decisions made, by admit_decision
+};
+
+/*
+ * This function creates an admission controller with a full token bucket.
+ *
+ * Params:
+ *   cfg - the limits to apply.  Copied.  May not be NULL.
+ *   now - the current time in nanoseconds.
+ *
+ * Return:
+ *   Returns a pointer to the new admission controller.
+ */
+struct admission* admission_create(const struct admission_config* cfg,
+    long long now) {
+  assert(cfg);
+  struct admission* ac = calloc(1, sizeof(struct admission));
+  assert(ac);
+  ac->cfg = *cfg;
+  if (ac->cfg.burst < 1) {
+    ac->cfg.burst = 1;
+  }
+  ac->tokens = ac->cfg.burst;
+  ac->refilled = now;
+  ac->last_served = -1;
+  return ac;
+}
+
+/*
+ * This function frees an admission controller.
+ *
+ * Params:
+ *   ac - the admission controller to free.  May not be NULL.
+ */
+void admission_free(struct admission* ac) {
+  assert(ac);
+  free(ac);
+}
+
+/*
+ * This function decides what to do with a new call.  An accepted call uses
+ * up a token.
+ *
+ * Params:
+ *   ac - the admission controller.  May not be NULL.
+ *   depth - the number of calls waiting now.
+ *   now - the current time in nanoseconds.  Must not go backwards.
+ *
+ * Return:
+ *   Returns the decision.
+ */
+enum admit_decision admission_check(struct admission* ac, int depth,
+    long long now) {
+  enum admit_decision d = ADMIT_ACCEPT;
+
+  if (ac->cfg.rate > 0) {
+    ac->tokens += (now - ac->refilled) * ac->cfg.rate / 1e9;
+    if (ac->tokens > ac->cfg.burst) {
+      ac->tokens = ac->cfg.burst;
+    }
+    ac->refilled = now;
+  }
+
+  if (ac->cfg.max_depth > 0 && depth >= ac->cfg.max_depth) {
+    d = ADMIT_REJECT;
+  } else if (ac->cfg.rate > 0 && ac->tokens < 1) {
+    d = ADMIT_REJECT;
+  } else if (ac->cfg.max_wait_s > 0 &&
+      admission_estimated_wait(ac, depth) > ac->cfg.max_wait_s) {
+    d = ADMIT_CALLBACK;
+  } else if (ac->cfg.rate > 0) {
+    ac->tokens -= 1;
+  }
+
+  ac->counts[d]++;
+  return d;
+}
+
+/*
+ * This function tells the admission controller that a call was answered,
+ * so it can track how fast calls are being served.
+ *
+ * Params:
+ *   ac - the admission controller.  May not be NULL.
+ *   depth - the number of calls still waiting after this one.
+ *   now - the current time in nanoseconds.
+ */
+void admission_served(struct admission* ac, int depth, long long now) {
+  if (ac->last_served >= 0 && ac->backlogged) {
+    double gap = now - ac->last_served;
+    ac->interval_ns = ac->interval_ns == 0 ? gap :
+      ADMISSION_EWMA_WEIGHT * gap + (1 - ADMISSION_EWMA_WEIGHT) * ac->interval_ns;
+  }
+  ac->last_served = now;
+  ac->backlogged = depth > 0;
+}
+
+/*
+ * This function estimates how long a call joining the back of the queue
+ * would wait, from the recent service rate.
+ *
+ * Params:
+ *   ac - the admission controller.  May not be NULL.
+ *   depth - the number of calls waiting ahead of it.
+ *
+ * Return:
+ *   Returns the estimated wait in seconds, or 0 until the service rate
+ *   has been measured.
+ */
+double admission_estimated_wait(struct admission* ac, int depth) {
+  return depth * ac->interval_ns / 1e9;
+}
+
+/*
+ * This function returns how many calls have been given a decision.
+ *
+ * Params:
+ *   ac - the admission controller.  May not be NULL.
+ *   d - the decision to count.
+ */
+long admission_count(struct admission* ac, enum admit_decision d) {
+  return ac->counts[d];
+}
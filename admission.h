@@ -0,0 +1,48 @@
+/*
+ * This file contains the definition of the interface for the admission
+ * controller that decides whether a new call may join the queue.  You can
+ * find descriptions of the admission functions, including their parameters
+ * and their return values, in admission.c.
+ */
+
+#ifndef __ADMISSION_H
+#define __ADMISSION_H
+
+/*
+ * Limits applied to new calls.  A limit of 0 is not applied.
+ */
+struct admission_config {
+  double rate;        // Calls per second admitted in the long run
+  double burst;       // Calls that may be admitted at once above `rate`
+  int max_depth;      // Calls waiting above which new calls are rejected
+  double max_wait_s;  // Estimated wait above which calls become callbacks
+};
+
+/*
+ * What to do with a new call.
+ */
+enum admit_decision {
+  ADMIT_ACCEPT,       // Queue the call
+  ADMIT_CALLBACK,     // Don't queue it; call the customer back later
+  ADMIT_REJECT        // Turn the call away
+};
+
+/*
+ * Structure used to represent an admission controller.
+ */
+struct admission;
+
+/*
+ * Admission interface function prototypes.  Refer to admission.c for
+ * documentation about each of these functions.
+ */
+struct admission* admission_create(const struct admission_config* cfg,
+  long long now);
+void admission_free(struct admission* ac);
+enum admit_decision admission_check(struct admission* ac, int depth,
+  long long now);
+void admission_served(struct admission* ac, int depth, long long now);
+double admission_estimated_wait(struct admission* ac, int depth);
+long admission_count(struct admission* ac, enum admit_decision d);
+
+#endif
@@ -0,0 +1,280 @@
+/*
+ * This file contains a multithreaded simulation of a call center.  A single
+ * dispatcher thread generates calls and a configurable number of agent
+ * threads answer them, either from one shared blocking queue or from one
+ * work-stealing deque per agent.  See the documentation below for more
+ * information on the individual functions in this implementation.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "agent_sim.h"
+#include "bqueue.h"
+#include "call.h"
+#include "coro_sim.h"
+#include "metrics.h"
+#include "queue.h"
+#include "stack.h"
+#include "timeutil.h"
+#include "wsdeque.h"
+
+/*
+ * This structure is used to represent the state of a single agent thread.
+ * In DISPATCH_STEAL mode the dispatcher deals calls into `inbox`, since only
+ * the agent itself may push onto its deque; the agent moves them across
+ * whenever its deque runs dry.
+ */
+struct agent {
+  int index;
+  struct sim* sim;
+  pthread_t thread;
+  struct stack* answered;
+  pthread_mutex_t inbox_lock;
+  struct queue* inbox;
+  struct wsdeque* deque;
+  long handled;
+  long steals;
+  unsigned int seed;
+  struct metrics_thread* counters; // This agent's metrics slot, or NULL
+};
+
+/*
+ * This structure is used to represent the state shared by every thread in
+ * one simulation run.
+ */
+struct sim {
+  const struct sim_config* cfg;
+  struct agent* agents;
+  struct bqueue* shared;
+  long long* wait_ns;
+  long answered;
+};
+
+const char* sim_mode_name(enum dispatch_mode mode) {
+  return mode == DISPATCH_STEAL ? "steal" :
+    mode == DISPATCH_CORO ? "coro" : "shared";
+}
+
+/*
+ * Auxilliary function to simulate an agent handling a call: record how long
+ * the call waited, stay busy for the configured handling time, then push the
+ * call onto the agent's answered stack.
+ */
+static void _handle_call(struct agent* agent, Call* call) {
+  struct sim* sim = agent->sim;
+  long long start = now_ns();
+  sim->wait_ns[call->id - 1] = start - call->received_ns;
+  while (now_ns() - start < sim->cfg->work_ns) {}
+  stack_push(agent->answered, call);
+  agent->handled++;
+  if (agent->counters) {
+    metrics_inc(&agent->counters->dequeues);
+    metrics_inc(&agent->counters->pushes);
+  }
+  __atomic_add_fetch(&sim->answered, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Auxilliary function to test whether every call has been answered.
+ */
+static int _sim_done(struct sim* sim) {
+  return __atomic_load_n(&sim->answered, __ATOMIC_ACQUIRE) >= sim->cfg->calls;
+}
+
+/*
+ * Auxilliary function to find work for an agent in DISPATCH_STEAL mode: pop
+ * the agent's own deque, refill it from the inbox, and finally try stealing
+ * from the other agents starting at a random victim.
+ */
+static Call* _find_call(struct agent* agent) {
+  Call* call = wsdeque_pop(agent->deque);
+  if (call) {
+    return call;
+  }
+
+  pthread_mutex_lock(&agent->inbox_lock);
+  while (!queue_isempty(agent->inbox)) {
+    wsdeque_push(agent->deque, queue_dequeue(agent->inbox));
+  }
+  pthread_mutex_unlock(&agent->inbox_lock);
+  call = wsdeque_pop(agent->deque);
+  if (call) {
+    return call;
+  }
+
+  int n = agent->sim->cfg->agents;
+  int start = rand_r(&agent->seed) % n;
+  for (int i = 0; i < n; i++) {
+    struct agent* victim = &agent->sim->agents[(start + i) % n];
+    if (victim == agent) {
+      continue;
+    }
+    call = wsdeque_steal(victim->deque);
+    if (call) {
+      agent->steals++;
+      return call;
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Thread body of an agent.  In DISPATCH_SHARED mode an idle agent sleeps in
+ * bqueue_dequeue_wait() until the dispatcher closes the queue.
+ */
+static void* _agent_main(void* arg) {
+  struct agent* agent = arg;
+  struct sim* sim = agent->sim;
+
+  if (sim->cfg->mode == DISPATCH_SHARED) {
+    Call* call;
+    while ((call = bqueue_dequeue_wait(sim->shared, -1)) != NULL) {
+      _handle_call(agent, call);
+    }
+    return NULL;
+  }
+
+  while (!_sim_done(sim)) {
+    Call* call = _find_call(agent);
+    if (call) {
+      _handle_call(agent, call);
+    } else {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+/*
+ * This function runs one simulation and reports its results.  The calling
+ * thread acts as the dispatcher: it creates `cfg->calls` calls and deals them
+ * to the agents, then waits for every call to be answered.
+ *
+ * In DISPATCH_CORO mode the whole run is handed to coro_sim_run() instead.
+ *
+ * If `cfg->metrics` is set, the dispatcher counts its enqueues in thread
+ * slot 0 and keeps the queue gauge, and agent i counts its calls in slot
+ * i + 1.  Agents beyond the last slot aren't counted.
+ *
+ * Params:
+ *   cfg - the simulation parameters.  May not be NULL.
+ *   res - filled in with the results of the run.  May not be NULL.
+ */
+void sim_run(const struct sim_config* cfg, struct sim_result* res) {
+  assert(cfg && res && cfg->agents > 0 && cfg->calls > 0);
+  if (cfg->mode == DISPATCH_CORO) {
+    coro_sim_run(cfg, res);
+    return;
+  }
+  res->switches = 0;
+  res->simulated_s = 0;
+  res->answered = 0;
+
+  struct sim sim;
+  sim.cfg = cfg;
+  sim.answered = 0;
+  sim.shared = bqueue_create();
+  sim.wait_ns = calloc(cfg->calls, sizeof(long long));
+  sim.agents = calloc(cfg->agents, sizeof(struct agent));
+  assert(sim.wait_ns && sim.agents);
+
+  for (int i = 0; i < cfg->agents; i++) {
+    struct agent* agent = &sim.agents[i];
+    agent->index = i;
+    agent->sim = &sim;
+    agent->answered = stack_create();
+    pthread_mutex_init(&agent->inbox_lock, NULL);
+    agent->inbox = queue_create();
+    agent->deque = wsdeque_create();
+    agent->seed = 0x9e3779b9u * (i + 1);
+    agent->counters = NULL;
+    if (cfg->metrics && i + 1 < METRICS_MAX_THREADS) {
+      agent->counters = &cfg->metrics->threads[i + 1];
+    }
+  }
+  if (cfg->metrics) {
+    int slots = cfg->agents + 1;
+    cfg->metrics->n_threads =
+      slots < METRICS_MAX_THREADS ? slots : METRICS_MAX_THREADS;
+  }
+
+  long long start = now_ns();
+  for (int i = 0; i < cfg->agents; i++) {
+    pthread_create(&sim.agents[i].thread, NULL, _agent_main, &sim.agents[i]);
+  }
+
+  /*
+   * Dispatch calls, round-robin across inboxes in DISPATCH_STEAL mode.
+   */
+  long long next_arrival = now_ns();
+  for (int i = 0; i < cfg->calls; i++) {
+    if (cfg->arrival_ns > 0) {
+      while (now_ns() < next_arrival) {}
+      next_arrival += cfg->arrival_ns;
+    }
+
+    Call* call = malloc(sizeof(Call));
+    call->id = i + 1;
+    snprintf(call->caller_name, sizeof(call->caller_name), "caller%d", i + 1);
+    strcpy(call->call_reason, "simulated");
+    call->received_ns = now_ns();
+
+    if (cfg->mode == DISPATCH_STEAL) {
+      struct agent* agent = &sim.agents[i % cfg->agents];
+      pthread_mutex_lock(&agent->inbox_lock);
+      queue_enqueue(agent->inbox, call);
+      pthread_mutex_unlock(&agent->inbox_lock);
+    } else {
+      bqueue_enqueue(sim.shared, call);
+    }
+    if (cfg->metrics) {
+      metrics_inc(&cfg->metrics->threads[0].enqueues);
+      metrics_gauge(&cfg->metrics->queue,
+        i + 1 - __atomic_load_n(&sim.answered, __ATOMIC_RELAXED), 0);
+    }
+  }
+  bqueue_close(sim.shared);
+
+  for (int i = 0; i < cfg->agents; i++) {
+    pthread_join(sim.agents[i].thread, NULL);
+  }
+  long long elapsed = now_ns() - start;
+
+  /*
+   * Summarize wait times and how evenly the calls were spread over agents.
+   */
+  double sum = 0, sum_sq = 0, wait_sum = 0;
+  res->steals = 0;
+  for (int i = 0; i < cfg->agents; i++) {
+    struct agent* agent = &sim.agents[i];
+    sum += agent->handled;
+    sum_sq += (double)agent->handled * agent->handled;
+    res->steals += agent->steals;
+    stack_free(agent->answered);
+    queue_free(agent->inbox);
+    wsdeque_free(agent->deque);
+    pthread_mutex_destroy(&agent->inbox_lock);
+  }
+  for (int i = 0; i < cfg->calls; i++) {
+    wait_sum += sim.wait_ns[i];
+  }
+  qsort(sim.wait_ns, cfg->calls, sizeof(long long), cmp_ll);
+
+  res->elapsed_s = elapsed / 1e9;
+  res->calls_per_s = cfg->calls / res->elapsed_s;
+  res->mean_wait_us = wait_sum / cfg->calls / 1e3;
+  res->p99_wait_us = sim.wait_ns[(long)(cfg->calls * 0.99)] / 1e3;
+  res->max_wait_us = sim.wait_ns[cfg->calls - 1] / 1e3;
+  res->fairness = sum_sq > 0 ? sum * sum / (cfg->agents * sum_sq) : 1.0;
+
+  bqueue_free(sim.shared);
+  free(sim.wait_ns);
+  free(sim.agents);
+}
@@ -0,0 +1,52 @@
+/*
+ * This file contains the definition of the interface for the multithreaded
+ * agent simulation.  You can find descriptions of the simulation functions,
+ * including their parameters and their return values, in agent_sim.c.
+ */
+
+#ifndef __AGENT_SIM_H
+#define __AGENT_SIM_H
+
+#include "metrics.h"
+
+/*
+ * How calls get from the dispatcher to the agents.
+ */
+enum dispatch_mode {
+  DISPATCH_SHARED, // One blocking queue that every agent dequeues from
+  DISPATCH_STEAL,  // One work-stealing deque per agent
+  DISPATCH_CORO    // One coroutine per agent, all on one thread (coro_sim.c)
+};
+
+/*
+ * Parameters of a single simulation run.
+ */
+struct sim_config {
+  int agents;              // Number of agent threads
+  int calls;               // Number of calls the dispatcher generates
+  enum dispatch_mode mode;
+  long long work_ns;       // Time an agent spends handling each call
+  long long arrival_ns;    // Gap between arrivals (0 = as fast as possible)
+  struct metrics* metrics; // Segment to publish counters in, or NULL
+};
+
+/*
+ * Results of a single simulation run.
+ */
+struct sim_result {
+  double elapsed_s;
+  double calls_per_s;
+  double mean_wait_us;
+  double p99_wait_us;
+  double max_wait_us;
+  double fairness;         // Jain's index over calls handled per agent
+  long steals;
+  long long switches;      // Coroutine resumes, in DISPATCH_CORO mode
+  double simulated_s;      // Simulated time taken, in DISPATCH_CORO mode
+  long answered;           // Calls answered, in DISPATCH_CORO mode
+};
+
+void sim_run(const struct sim_config* cfg, struct sim_result* res);
+const char* sim_mode_name(enum dispatch_mode mode);
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * This file contains executable code for measuring admission control.  It
+ * first times admission_check() and admission_served() per admitted call.
+ * It then writes a trace in which calls arrive at 10 times the rate agents
+ * answer them for a minute, followed by a minute of agents catching up,
+ * and replays it through ./callcenter with and without admission control
+ * to show how the queue and waits behave under overload.
+ *
+ * Usage: ./bench_admission [answers_per_s]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "admission.h"
+#include "timeutil.h"
+
+#define OVERHEAD_CALLS 10000000
+#define TRACE_PATH "/tmp/bench_admission.trace"
+
+/*
+ * Times admission control in a steady state where the depth stays small
+ * and every call is admitted.
+ */
+void overhead() {
+  struct admission_config cfg = { 1e9, 1e6, 1000000, 60 };
+  struct admission* ac = admission_create(&cfg, 0);
+  long long t = 0, start = now_ns();
+  long admitted = 0;
+  for (int i = 0; i < OVERHEAD_CALLS; i++) {
+    t += 1000;
+    admitted += admission_check(ac, i & 7, t) == ADMIT_ACCEPT;
+    admission_served(ac, i & 7, t + 500);
+  }
+  long long elapsed = now_ns() - start;
+  printf("Overhead per admitted call (check + served): %.1f ns (%ld admitted)\n",
+    (double)elapsed / OVERHEAD_CALLS, admitted);
+  admission_free(ac);
+}
+
+/*
+ * Writes the overload trace: `rate` answers per second for two minutes,
+ * and 10 * `rate` calls per second for the first minute.
+ */
+void write_trace(int rate) {
+  FILE* f = fopen(TRACE_PATH, "w");
+  if (!f) {
+    perror(TRACE_PATH);
+    exit(1);
+  }
+  fprintf(f, "# 10x overload for 60 s, then 60 s to catch up\n");
+  long long call_gap_us = 1000000 / (10 * rate);
+  long long answer_gap_us = 1000000 / rate;
+  long long next_call = 0, next_answer = answer_gap_us;
+  int n = 0;
+  while (next_answer <= 120000000LL) {
+    if (next_call < 60000000LL && next_call <= next_answer) {
+      fprintf(f, "%lld call caller%d overload test\n", next_call / 1000, ++n);
+      next_call += call_gap_us;
+    } else {
+      fprintf(f, "%lld answer\n", next_answer / 1000);
+      next_answer += answer_gap_us;
+    }
+  }
+  fclose(f);
+}
+
+int main(int argc, char** argv) {
+  int rate = argc > 1 ? atoi(argv[1]) : 100;
+  char cmd[256];
+  const char* configs[] = {
+    "",
+    "--max-depth=1000",
+    "--admit-rate=110",
+    "--max-wait=5 --max-depth=2000",
+  };
+
+  overhead();
+  write_trace(rate);
+  for (int i = 0; i < (int)(sizeof(configs) / sizeof(configs[0])); i++) {
+    printf("\n== ./callcenter --replay %s\n", configs[i]);
+    fflush(stdout);
+    snprintf(cmd, sizeof(cmd), "./callcenter --replay=%s --history=1 %s",
+      TRACE_PATH, configs[i]);
+    if (system(cmd) != 0) {
+      printf("Replay failed\n");
+    }
+  }
+  remove(TRACE_PATH);
+  return 0;
+}
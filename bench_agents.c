@@ -0,0 +1,30 @@
+/*
+ * This file contains executable code for comparing the shared-queue and
+ * work-stealing dispatch modes of the agent simulation at 4 to 64 agents.
+ *
+ * Usage: ./bench_agents [calls] [work_ns]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "agent_sim.h"
+
+int main(int argc, char** argv) {
+  int calls = argc > 1 ? atoi(argv[1]) : 200000;
+  long long work_ns = argc > 2 ? atoll(argv[2]) : 500;
+
+  printf("%-7s %6s %12s %12s %12s %12s %9s %9s\n", "mode", "agents",
+    "calls/s", "mean_us", "p99_us", "max_us", "fairness", "steals");
+  for (int agents = 4; agents <= 64; agents *= 2) {
+    for (int m = DISPATCH_SHARED; m <= DISPATCH_STEAL; m++) {
+      struct sim_config cfg = { agents, calls, m, work_ns, 0, NULL };
+      struct sim_result res;
+      sim_run(&cfg, &res);
+      printf("%-7s %6d %12.0f %12.1f %12.1f %12.1f %9.3f %9ld\n",
+        sim_mode_name(cfg.mode), agents, res.calls_per_s, res.mean_wait_us,
+        res.p99_wait_us, res.max_wait_us, res.fairness, res.steals);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * This file contains executable code for comparing an unbounded answered-
+ * calls stack (every Call kept in the linked list) with a bounded stack that
+ * keeps only the most recent calls and frees the rest as they are evicted.
+ * Each run happens in its own child process so their RSS figures don't mix.
+ *
+ * Usage: ./bench_bounded [calls] [bound]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "call.h"
+#include "stack.h"
+#include "timeutil.h"
+
+/*
+ * Returns the resident set size of this process in MB, or -1 if unknown.
+ */
+double rss_mb() {
+  long pages = -1, resident = -1;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (!f) {
+    return -1;
+  }
+  if (fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+    resident = -1;
+  }
+  fclose(f);
+  return resident < 0 ? -1 : resident * (double)sysconf(_SC_PAGESIZE) / 1e6;
+}
+
+void run(int calls, int bound) {
+  struct stack* s = bound ? stack_create_bounded(bound) : stack_create();
+  long long start = now_ns();
+
+  for (int i = 0; i < calls; i++) {
+    Call* c = malloc(sizeof(Call));
+    c->id = i + 1;
+    strcpy(c->caller_name, "caller");
+    strcpy(c->call_reason, "reason");
+    stack_push(s, c);
+    if ((i + 1) % (calls / 4) == 0) {
+      printf("%-10s %10d %10d %12.1f %10.1f\n", bound ? "bounded" : "unbounded",
+        i + 1, stack_size(s), (double)(now_ns() - start) / (i + 1), rss_mb());
+    }
+  }
+  stack_free(s);
+}
+
+int main(int argc, char** argv) {
+  int calls = argc > 1 ? atoi(argv[1]) : 4000000;
+  int bound = argc > 2 ? atoi(argv[2]) : 1000;
+
+  printf("%-10s %10s %10s %12s %10s\n", "stack", "pushed", "kept",
+    "ns_per_push", "rss_MB");
+  for (int b = 0; b <= 1; b++) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+      run(calls, b ? bound : 0);
+      return 0;
+    }
+    waitpid(pid, NULL, 0);
+  }
+  return 0;
+}
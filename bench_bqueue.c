@@ -0,0 +1,129 @@
+/*
+ * This file contains executable code for measuring how quickly idle agents
+ * wake up when a call arrives and how much CPU they burn while idle, for the
+ * blocking queue in bqueue.c versus polling a locked queue.
+ *
+ * Usage: ./bench_bqueue [agents] [samples] [gap_us]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "bqueue.h"
+#include "queue.h"
+#include "timeutil.h"
+
+struct bench {
+  int polling;
+  struct bqueue* bq;
+  pthread_mutex_t lock;
+  struct queue* q;
+  int stop;
+  long long* sent;
+  long long* latency;
+};
+
+/*
+ * Thread body of an idle agent.  Each value is a pointer to the time at which
+ * the producer sent it.
+ */
+void* agent(void* arg) {
+  struct bench* b = arg;
+  for (;;) {
+    long long* sent;
+    if (b->polling) {
+      pthread_mutex_lock(&b->lock);
+      sent = queue_dequeue(b->q);
+      pthread_mutex_unlock(&b->lock);
+      if (!sent) {
+        if (__atomic_load_n(&b->stop, __ATOMIC_ACQUIRE)) {
+          return NULL;
+        }
+        sched_yield();
+        continue;
+      }
+    } else {
+      sent = bqueue_dequeue_wait(b->bq, -1);
+      if (!sent) {
+        return NULL;
+      }
+    }
+    b->latency[sent - b->sent] = now_ns() - *sent;
+  }
+}
+
+double cpu_seconds() {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+    ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+void run(int polling, int agents, int samples, long gap_us) {
+  struct bench b;
+  pthread_t* threads = malloc(agents * sizeof(pthread_t));
+  struct timespec gap = { gap_us / 1000000, (gap_us % 1000000) * 1000 };
+
+  b.polling = polling;
+  b.bq = bqueue_create();
+  pthread_mutex_init(&b.lock, NULL);
+  b.q = queue_create();
+  b.stop = 0;
+  b.sent = malloc(samples * sizeof(long long));
+  b.latency = malloc(samples * sizeof(long long));
+
+  double cpu0 = cpu_seconds();
+  long long t0 = now_ns();
+  for (int i = 0; i < agents; i++) {
+    pthread_create(&threads[i], NULL, agent, &b);
+  }
+  for (int i = 0; i < samples; i++) {
+    nanosleep(&gap, NULL);
+    b.sent[i] = now_ns();
+    if (polling) {
+      pthread_mutex_lock(&b.lock);
+      queue_enqueue(b.q, &b.sent[i]);
+      pthread_mutex_unlock(&b.lock);
+    } else {
+      bqueue_enqueue(b.bq, &b.sent[i]);
+    }
+  }
+  __atomic_store_n(&b.stop, 1, __ATOMIC_RELEASE);
+  bqueue_close(b.bq);
+  for (int i = 0; i < agents; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  double wall = (now_ns() - t0) / 1e9;
+  double cpu = cpu_seconds() - cpu0;
+
+  qsort(b.latency, samples, sizeof(long long), cmp_ll);
+  printf("%-8s %6d %10.1f %10.1f %10.1f %12.1f%%\n",
+    polling ? "polling" : "bqueue", agents, b.latency[samples / 2] / 1e3,
+    b.latency[(int)(samples * 0.99)] / 1e3, b.latency[samples - 1] / 1e3,
+    100.0 * cpu / wall);
+
+  queue_free(b.q);
+  bqueue_free(b.bq);
+  pthread_mutex_destroy(&b.lock);
+  free(b.sent);
+  free(b.latency);
+  free(threads);
+}
+
+int main(int argc, char** argv) {
+  int agents = argc > 1 ? atoi(argv[1]) : 8;
+  int samples = argc > 2 ? atoi(argv[2]) : 1000;
+  long gap_us = argc > 3 ? atol(argv[3]) : 1000;
+
+  printf("%-8s %6s %10s %10s %10s %13s\n", "mode", "agents", "p50_us",
+    "p99_us", "max_us", "cpu/wall");
+  run(1, agents, samples, gap_us);
+  run(0, agents, samples, gap_us);
+  return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * This file contains executable code for comparing the intrusive stack with
+ * the stack of pointers on the callcenter's answered-call path.  The calls
+ * are allocated up front, so only the stacks themselves are timed:
+ *
+ *   - pushing every call and popping them all again, on an unbounded stack
+ *     (a list node per call for the pointer stack, nothing for the
+ *     intrusive one);
+ *   - pushing every call onto a stack bounded to the --history size, each
+ *     push past the bound evicting the oldest call;
+ *   - unlinking calls from random places in a full stack, which the pointer
+ *     stack can't do at all.
+ *
+ * As on the real path, each call is written just before it is pushed, and
+ * read when it is popped or evicted, so the intrusive stack isn't charged
+ * for cache misses on the calls that the callcenter would take anyway.
+ *
+ * Usage: ./bench_istack [calls] [bound]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "call.h"
+#include "istack.h"
+#include "stack.h"
+#include "timeutil.h"
+
+long evictions = 0;
+long long checksum = 0;
+
+void evict(void* val, void* ctx) {
+  checksum += ((Call*)val)->id;
+  evictions++;
+}
+
+void ievict(struct ilink* link, void* ctx) {
+  checksum += CALL_OF_LINK(link)->id;
+  evictions++;
+}
+
+/*
+ * Prints one row of results.
+ */
+void report(const char* stack, const char* op, long long elapsed, int ops,
+    long allocs) {
+  printf("%-10s %-12s %10.1f %12ld\n", stack, op, (double)elapsed / ops,
+    allocs);
+}
+
+int main(int argc, char** argv) {
+  int calls = argc > 1 ? atoi(argv[1]) : 4000000;
+  int bound = argc > 2 ? atoi(argv[2]) : 1000;
+  Call* pool = malloc(calls * sizeof(Call));
+  struct mem_stats m;
+  long long start;
+
+  for (int i = 0; i < calls; i++) {
+    pool[i].id = i + 1;
+  }
+  printf("%-10s %-12s %10s %12s\n", "stack", "op", "ns_per_op", "allocations");
+
+  /*
+   * Unbounded: push everything, then pop everything.
+   */
+  struct stack* s = stack_create();
+  stack_mem_stats(s, &m);
+  long allocs = m.allocs;
+  start = now_ns();
+  for (int i = 0; i < calls; i++) {
+    pool[i].answered_ns = i;
+    stack_push(s, &pool[i]);
+  }
+  long long push = now_ns() - start;
+  stack_mem_stats(s, &m);
+  report("pointer", "push", push, calls, m.allocs - allocs);
+  allocs = m.allocs;
+  start = now_ns();
+  for (Call* c; (c = stack_pop(s));) {
+    checksum += c->id;
+  }
+  long long pop = now_ns() - start;
+  stack_mem_stats(s, &m);
+  report("pointer", "pop", pop, calls, m.allocs - allocs);
+  stack_free(s);
+
+  struct istack* is = istack_create(0);
+  start = now_ns();
+  for (int i = 0; i < calls; i++) {
+    pool[i].answered_ns = i;
+    istack_push(is, &pool[i].link);
+  }
+  push = now_ns() - start;
+  start = now_ns();
+  for (struct ilink* l; (l = istack_pop(is));) {
+    checksum += CALL_OF_LINK(l)->id;
+  }
+  pop = now_ns() - start;
+  report("intrusive", "push", push, calls, 0);
+  report("intrusive", "pop", pop, calls, 0);
+  istack_free(is);
+
+  /*
+   * Bounded: the answered-call history with --history=bound.
+   */
+  s = stack_create_bounded(bound);
+  stack_set_evict(s, evict, NULL);
+  stack_mem_stats(s, &m);
+  allocs = m.allocs;
+  start = now_ns();
+  for (int i = 0; i < calls; i++) {
+    pool[i].answered_ns = i;
+    stack_push(s, &pool[i]);
+  }
+  push = now_ns() - start;
+  stack_mem_stats(s, &m);
+  report("pointer", "push_bounded", push, calls, m.allocs - allocs);
+  while (stack_pop(s)) {
+  }
+  stack_free(s);
+
+  is = istack_create(bound);
+  istack_set_evict(is, ievict, NULL);
+  start = now_ns();
+  for (int i = 0; i < calls; i++) {
+    pool[i].answered_ns = i;
+    istack_push(is, &pool[i].link);
+  }
+  push = now_ns() - start;
+  report("intrusive", "push_bounded", push, calls, 0);
+  istack_clear(is, NULL, NULL);
+  istack_free(is);
+
+  /*
+   * Unlink a random half of a full stack, given only the calls.
+   */
+  is = istack_create(0);
+  for (int i = 0; i < calls; i++) {
+    pool[i].answered_ns = i;
+    istack_push(is, &pool[i].link);
+  }
+  unsigned int seed = 12345;
+  int removed = 0;
+  start = now_ns();
+  for (int i = 0; i < calls; i++) {
+    seed = seed * 1103515245u + 12345u;
+    if (seed >> 31) {
+      istack_remove(is, &pool[i].link);
+      removed++;
+    }
+  }
+  report("intrusive", "unlink", now_ns() - start, removed, 0);
+  printf("(%ld evictions each; the pointer stack has no unlink; checksum %lld)\n",
+    evictions / 2, checksum);
+  istack_clear(is, NULL, NULL);
+  istack_free(is);
+
+  free(pool);
+  return 0;
+}
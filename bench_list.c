@@ -0,0 +1,74 @@
+/*
+ * This file contains executable code for timing the linked list operations
+ * that walk the list: traversal (list_position), removal (list_remove),
+ * reversal (list_reverse) and emptying it.  It is built twice, against the
+ * node-per-element list (bench_list) and the unrolled list
+ * (bench_list_unrolled), so the two can be compared.
+ *
+ * Usage: ./bench_list [n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "list.h"
+#include "timeutil.h"
+
+int cmp_int(void* a, void* b) {
+  return *(int*)a != *(int*)b;
+}
+
+int main(int argc, char** argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 1000000;
+  int* data = malloc(n * sizeof(int));
+  int missing = -1;
+  long long start;
+
+  for (int i = 0; i < n; i++) {
+    data[i] = i;
+  }
+
+  start = now_ns();
+  struct list* list = list_create();
+  for (int i = 0; i < n; i++) {
+    list_insert(list, &data[i]);
+  }
+  printf("insert:    %8.2f ns/element\n", (double)(now_ns() - start) / n);
+
+  /*
+   * Searching for a value that isn't there walks the entire list.
+   */
+  int passes = 10;
+  start = now_ns();
+  for (int p = 0; p < passes; p++) {
+    list_position(list, &missing, cmp_int);
+  }
+  printf("traverse:  %8.2f ns/element\n",
+    (double)(now_ns() - start) / ((long long)n * passes));
+
+  /*
+   * Remove values spread evenly through the list (each removal walks to the
+   * value first).
+   */
+  int removals = 200;
+  start = now_ns();
+  for (int r = 0; r < removals; r++) {
+    list_remove(list, &data[(long long)r * n / removals], cmp_int);
+  }
+  printf("remove:    %8.2f us/removal\n",
+    (double)(now_ns() - start) / removals / 1e3);
+
+  start = now_ns();
+  list_reverse(list);
+  printf("reverse:   %8.2f ns/element\n", (double)(now_ns() - start) / n);
+
+  start = now_ns();
+  while (!list_isempty(list)) {
+    pop_value(list);
+  }
+  printf("pop all:   %8.2f ns/element\n", (double)(now_ns() - start) / n);
+
+  list_free(list);
+  free(data);
+  return 0;
+}
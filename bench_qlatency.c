@@ -0,0 +1,54 @@
+/*
+ * This file contains executable code for measuring the tail latency of
+ * individual enqueue and dequeue operations.  It is built twice, against
+ * the dynamic-array queue (bench_qlatency) and the segmented queue
+ * (bench_qlatency_segmented), so the resize stalls of the former can be
+ * compared with the latter.
+ *
+ * Usage: ./bench_qlatency [n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "queue.h"
+#include "timeutil.h"
+
+int cmp_int(const void* a, const void* b) {
+  int x = *(const int*)a, y = *(const int*)b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Sorts `lat` and prints its percentiles.
+ */
+void report(const char* what, int* lat, int n) {
+  qsort(lat, n, sizeof(int), cmp_int);
+  printf("%-8s p50 %6d ns  p99 %6d ns  p99.9 %7d ns  max %9d ns\n", what,
+    lat[n / 2], lat[(int)(n * 0.99)], lat[(int)(n * 0.999)], lat[n - 1]);
+}
+
+int main(int argc, char** argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 4000000;
+  int* lat = malloc(n * sizeof(int));
+  int token;
+  struct queue* q = queue_create();
+
+  for (int i = 0; i < n; i++) {
+    long long start = now_ns();
+    queue_enqueue(q, &token);
+    lat[i] = (int)(now_ns() - start);
+  }
+  report("enqueue", lat, n);
+
+  for (int i = 0; i < n; i++) {
+    long long start = now_ns();
+    queue_dequeue(q);
+    lat[i] = (int)(now_ns() - start);
+  }
+  report("dequeue", lat, n);
+
+  queue_free(q);
+  free(lat);
+  return 0;
+}
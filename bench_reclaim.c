@@ -0,0 +1,117 @@
+/*
+ * This file contains executable code for measuring how long clearing a
+ * large queue or stack of calls keeps the caller waiting.  For each
+ * container it fills it with call-sized values and times freeing it the
+ * ordinary way, then fills it again and times queue_clear_async() or
+ * stack_clear_async() returning, and the reclaimer finishing behind it.
+ * Last, it forks processes holding a full queue and times them exiting
+ * with and without freeing it first.
+ *
+ * Usage: ./bench_reclaim [values]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "call.h"
+#include "queue.h"
+#include "reclaim.h"
+#include "stack.h"
+#include "timeutil.h"
+
+int n;
+
+/*
+ * Returns a new call-sized value.
+ */
+void* call() {
+  Call* c = malloc(sizeof(Call));
+  memset(c, 0, sizeof(Call));
+  return c;
+}
+
+struct queue* full_queue() {
+  struct queue* queue = queue_create();
+  for (int i = 0; i < n; i++) {
+    queue_enqueue(queue, call());
+  }
+  return queue;
+}
+
+struct stack* full_stack() {
+  struct stack* stack = stack_create();
+  for (int i = 0; i < n; i++) {
+    stack_push(stack, call());
+  }
+  return stack;
+}
+
+/*
+ * Prints a line of results, in milliseconds.
+ */
+void report(const char* name, long long sync_ns, long long async_ns,
+    long long reclaim_ns) {
+  printf("%-6s free: %8.1f ms   clear_async returns: %8.4f ms   "
+    "reclaimed after: %8.1f ms\n", name, sync_ns / 1e6, async_ns / 1e6,
+    reclaim_ns / 1e6);
+}
+
+/*
+ * Times a child process that holds a full queue from fork to exit, freeing
+ * the queue first if `clean` is set.
+ */
+long long exit_ns(struct queue* queue, int clean) {
+  long long start = now_ns();
+  pid_t pid = fork();
+  if (pid == 0) {
+    if (clean) {
+      queue_free(queue);
+    }
+    _Exit(0);
+  }
+  waitpid(pid, NULL, 0);
+  return now_ns() - start;
+}
+
+int main(int argc, char** argv) {
+  n = argc > 1 ? atoi(argv[1]) : 10000000;
+  long long start, sync_ns, async_ns;
+  printf("%d values of %zu bytes\n", n, sizeof(Call));
+
+  struct queue* queue = full_queue();
+  start = now_ns();
+  queue_free(queue);
+  sync_ns = now_ns() - start;
+  queue = full_queue();
+  start = now_ns();
+  queue_clear_async(queue);
+  async_ns = now_ns() - start;
+  reclaim_wait();
+  report("queue", sync_ns, async_ns, now_ns() - start);
+  queue_free(queue);
+
+  struct stack* stack = full_stack();
+  start = now_ns();
+  stack_free(stack);
+  sync_ns = now_ns() - start;
+  stack = full_stack();
+  start = now_ns();
+  stack_clear_async(stack);
+  async_ns = now_ns() - start;
+  reclaim_wait();
+  report("stack", sync_ns, async_ns, now_ns() - start);
+  stack_free(stack);
+
+  queue = full_queue();
+  long long clean = exit_ns(queue, 1);
+  long long fast = exit_ns(queue, 0);
+  printf("Process exit with a full queue: %.1f ms freeing it, %.1f ms "
+    "without\n", clean / 1e6, fast / 1e6);
+  queue_free(queue);
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * This file contains executable code for reporting the memory held by a call
+ * queue over a simulated day: quiet overnight, a large spike in the morning,
+ * then a long quiet afternoon.  The day is run once with the default
+ * shrink-on-drain behavior and once with the queue reserved for the peak up
+ * front.  Each run happens in its own child process so their RSS figures
+ * don't mix.
+ *
+ * Usage: ./bench_rss [peak]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "queue.h"
+#include "timeutil.h"
+
+/*
+ * Backlog at the end of each hour, as a fraction of the peak.
+ */
+double profile[24] = {
+  0.0002, 0.0002, 0.0002, 0.0002, 0.0002, 0.0002, 0.0002, 0.001,
+  0.25, 1.0, 0.5, 0.05, 0.001, 0.001, 0.001, 0.001,
+  0.001, 0.001, 0.001, 0.0005, 0.0002, 0.0002, 0.0002, 0.0002
+};
+
+/*
+ * Returns the resident set size of this process in MB, or -1 if unknown.
+ */
+double rss_mb() {
+  long pages = -1, resident = -1;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (!f) {
+    return -1;
+  }
+  if (fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+    resident = -1;
+  }
+  fclose(f);
+  return resident < 0 ? -1 : resident * (double)sysconf(_SC_PAGESIZE) / 1e6;
+}
+
+void run_day(int reserve, int peak) {
+  static int call;
+  struct queue* q = queue_create();
+  long long max_stall = 0;
+
+  if (reserve) {
+    queue_reserve(q, peak);
+  }
+  printf("\n== %s\n", reserve ? "Reserved for peak" : "Shrink on drain");
+  printf("%4s %10s %10s %10s %10s %12s\n", "hour", "size", "capacity",
+    "buffer_MB", "rss_MB", "max_op_us");
+
+  for (int hour = 0; hour < 24; hour++) {
+    int target = (int)(profile[hour] * peak);
+
+    /*
+     * Steady churn through the hour, then move the backlog to its target.
+     */
+    for (int i = 0; i < 100000; i++) {
+      if (!queue_isempty(q)) {
+        queue_dequeue(q);
+      }
+      queue_enqueue(q, &call);
+    }
+    while (queue_size(q) != target) {
+      long long start = now_ns();
+      if (queue_size(q) < target) {
+        queue_enqueue(q, &call);
+      } else {
+        queue_dequeue(q);
+      }
+      long long op = now_ns() - start;
+      if (op > max_stall) {
+        max_stall = op;
+      }
+    }
+
+    printf("%4d %10d %10d %10.1f %10.1f %12.1f\n", hour, queue_size(q),
+      queue_capacity(q), queue_capacity(q) * sizeof(void*) / 1e6, rss_mb(),
+      max_stall / 1e3);
+    max_stall = 0;
+  }
+
+  while (!queue_isempty(q)) {
+    queue_dequeue(q);
+  }
+  queue_free(q);
+}
+
+int main(int argc, char** argv) {
+  int peak = argc > 1 ? atoi(argv[1]) : 8000000;
+
+  for (int reserve = 0; reserve <= 1; reserve++) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+      run_day(reserve, peak);
+      return 0;
+    }
+    waitpid(pid, NULL, 0);
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * This file contains executable code for comparing the sharded queue with a
+ * single queue behind one lock, at 1 to 64 threads.  Each thread performs
+ * enqueue/dequeue pairs on the shared structure.
+ *
+ * Usage: ./bench_shardq [ops_per_thread]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "queue.h"
+#include "shardq.h"
+#include "timeutil.h"
+
+int ops;
+int sharded;
+struct shardq* sq;
+struct queue* q;
+pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+int go = 0;
+
+void* worker(void* arg) {
+  int token;
+  while (!__atomic_load_n(&go, __ATOMIC_ACQUIRE)) {}
+  for (int i = 0; i < ops; i++) {
+    if (sharded) {
+      shardq_enqueue(sq, &token);
+      shardq_dequeue(sq);
+    } else {
+      pthread_mutex_lock(&lock);
+      queue_enqueue(q, &token);
+      pthread_mutex_unlock(&lock);
+      pthread_mutex_lock(&lock);
+      queue_dequeue(q);
+      pthread_mutex_unlock(&lock);
+    }
+  }
+  return NULL;
+}
+
+double run(int threads) {
+  pthread_t* t = malloc(threads * sizeof(pthread_t));
+  go = 0;
+  for (int i = 0; i < threads; i++) {
+    pthread_create(&t[i], NULL, worker, NULL);
+  }
+  long long start = now_ns();
+  __atomic_store_n(&go, 1, __ATOMIC_RELEASE);
+  for (int i = 0; i < threads; i++) {
+    pthread_join(t[i], NULL);
+  }
+  long long elapsed = now_ns() - start;
+  free(t);
+  return 2.0 * ops * threads / (elapsed / 1e9) / 1e6;
+}
+
+int main(int argc, char** argv) {
+  ops = argc > 1 ? atoi(argv[1]) : 200000;
+
+  printf("%7s %14s %14s\n", "threads", "locked_Mops", "sharded_Mops");
+  for (int threads = 1; threads <= 64; threads *= 2) {
+    q = queue_create();
+    sq = shardq_create(threads);
+    sharded = 0;
+    double locked = run(threads);
+    sharded = 1;
+    double shard = run(threads);
+    printf("%7d %14.2f %14.2f\n", threads, locked, shard);
+    queue_free(q);
+    shardq_free(sq);
+  }
+  return 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * This file contains executable code for measuring the shared-memory call
+ * ring between processes: one intake process queues calls and one or more
+ * agent processes answer them.  Each run reports calls per second and the
+ * latency from enqueue to dequeue, both flat out and with calls arriving
+ * at a fixed rate (where latency isn't dominated by time spent queued).
+ *
+ * Usage: ./bench_shmring [calls] [arrival_ns]
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "shmring.h"
+#include "timeutil.h"
+
+char name[64];
+long long* latency; // Shared with the agents; indexed by call ID - 1
+
+/*
+ * Body of an agent process.
+ */
+void agent() {
+  struct shmring* r = shmring_attach(name);
+  Call call;
+  if (!r) {
+    _exit(1);
+  }
+  while (shmring_dequeue(r, &call, -1)) {
+    latency[call.id - 1] = now_ns() - call.received_ns;
+  }
+  shmring_detach(r);
+  _exit(0);
+}
+
+void run(int agents, int calls, long long arrival_ns) {
+  struct shmring* r = shmring_create(name, 1024);
+  Call call = { 0 };
+  if (!r) {
+    printf("Could not create ring\n");
+    exit(1);
+  }
+  pid_t* pids = malloc(agents * sizeof(pid_t));
+  for (int i = 0; i < agents; i++) {
+    if ((pids[i] = fork()) == 0) {
+      agent();
+    }
+  }
+
+  long long start = now_ns(), next = start;
+  for (int i = 0; i < calls; i++) {
+    if (arrival_ns > 0) {
+      while (now_ns() < next) {}
+      next += arrival_ns;
+    }
+    call.id = i + 1;
+    call.received_ns = now_ns();
+    shmring_enqueue(r, &call, -1);
+  }
+  shmring_close(r);
+  for (int i = 0; i < agents; i++) {
+    waitpid(pids[i], NULL, 0);
+  }
+  long long elapsed = now_ns() - start;
+
+  qsort(latency, calls, sizeof(long long), cmp_ll);
+  printf("%6d %10lld %12.0f %10.1f %10.1f %10.1f\n", agents, arrival_ns,
+    calls / (elapsed / 1e9), latency[calls / 2] / 1e3,
+    latency[(long)(calls * 0.99)] / 1e3, latency[calls - 1] / 1e3);
+  shmring_destroy(r, name);
+  free(pids);
+}
+
+int main(int argc, char** argv) {
+  int calls = argc > 1 ? atoi(argv[1]) : 1000000;
+  long long arrival_ns = argc > 2 ? atoll(argv[2]) : 2000;
+
+  snprintf(name, sizeof(name), "/bench_shmring.%d", (int)getpid());
+  latency = mmap(NULL, calls * sizeof(long long), PROT_READ | PROT_WRITE,
+    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (latency == MAP_FAILED) {
+    return 1;
+  }
+
+  printf("%6s %10s %12s %10s %10s %10s\n", "agents", "arrival_ns", "calls/s",
+    "p50_us", "p99_us", "max_us");
+  for (int a = 1; a <= 4; a *= 2) {
+    run(a, calls, 0);
+  }
+  for (int a = 1; a <= 4; a *= 2) {
+    run(a, calls / 10, arrival_ns);
+  }
+  munmap(latency, calls * sizeof(long long));
+  return 0;
+}
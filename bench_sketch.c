@@ -0,0 +1,121 @@
+/*
+ * This file contains executable code for measuring repeat-caller detection
+ * with the Bloom filter and the count-min sketch on synthetic traffic: a day
+ * of calls from a population of callers where a few call very often and
+ * most call once or twice.  It reports throughput, the Bloom filter's false
+ * positive rate, how far the count estimates are off, how many first calls
+ * are wrongly flagged as repeats, and memory compared with a hash set of
+ * names.
+ *
+ * Usage: ./bench_sketch [calls] [callers]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sketch.h"
+#include "timeutil.h"
+
+volatile uint64_t sink; // Keeps the hashing-only loop from being optimized out
+
+int main(int argc, char** argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 2000000;
+  int callers = argc > 2 ? atoi(argv[2]) : 1000000;
+  int* who = malloc(n * sizeof(int));
+  char (*names)[30] = malloc((size_t)callers * 30);
+  int* exact = calloc(callers, sizeof(int));
+  struct bloom* b = bloom_create(callers, 0.01);
+  struct cms* c = cms_create(3e-6, 0.05); // As sized in callcenter.c
+
+  /*
+   * Skewed traffic: caller u^3 * callers for uniform u, so low-numbered
+   * callers call far more often.
+   */
+  srand(11);
+  for (int i = 0; i < callers; i++) {
+    snprintf(names[i], 30, "caller%07d", i);
+  }
+  for (int i = 0; i < n; i++) {
+    double u = (double)rand() / RAND_MAX;
+    who[i] = (int)(u * u * u * (callers - 1));
+  }
+
+  /*
+   * Reading the names and hashing them alone, for comparison.
+   */
+  uint64_t sum = 0;
+  long long start = now_ns();
+  for (int i = 0; i < n; i++) {
+    sum += sketch_hash(names[who[i]], strlen(names[who[i]]));
+  }
+  double hash_ns = (double)(now_ns() - start) / n;
+  sink = sum;
+
+  long flagged = 0, false_flags = 0;
+  start = now_ns();
+  for (int i = 0; i < n; i++) {
+    const char* name = names[who[i]];
+    uint64_t h = sketch_hash(name, strlen(name));
+    int seen = bloom_add(b, h);
+    uint32_t count = cms_add(c, h);
+    if (seen && count > 1) {
+      flagged++;
+    }
+  }
+  long long elapsed = now_ns() - start;
+  printf("Throughput: %.1f ns per call (hash + filter + sketch), %.1f M calls/s\n",
+    (double)elapsed / n, n / (elapsed / 1e3));
+  printf("  of which reading the name and hashing it: %.1f ns\n", hash_ns);
+
+  /*
+   * Replay the same traffic against exact counts to score it.
+   */
+  int distinct = 0;
+  long repeats = 0;
+  for (int i = 0; i < n; i++) {
+    if (exact[who[i]]++ == 0) {
+      distinct++;
+    } else {
+      repeats++;
+    }
+  }
+  false_flags = flagged - repeats; // Every true repeat is flagged
+  long over = 0, exact_est = 0;
+  uint32_t max_over = 0;
+  for (int i = 0; i < callers; i++) {
+    if (exact[i] > 0) {
+      uint32_t est = cms_estimate(c, sketch_hash(names[i], strlen(names[i])));
+      uint32_t diff = est - exact[i];
+      over += diff;
+      exact_est += diff == 0;
+      max_over = diff > max_over ? diff : max_over;
+    }
+  }
+
+  long fp = 0, probes = 1000000;
+  char name[30];
+  for (long i = 0; i < probes; i++) {
+    snprintf(name, sizeof(name), "stranger%07ld", i);
+    fp += bloom_contains(b, sketch_hash(name, strlen(name)));
+  }
+
+  printf("Calls: %d from %d distinct callers, %ld repeat calls\n", n,
+    distinct, repeats);
+  printf("Bloom filter false positives: %.2f%% of callers never seen\n",
+    100.0 * fp / probes);
+  printf("First calls wrongly flagged as repeats: %ld (%.3f%% of first calls)\n",
+    false_flags, 100.0 * false_flags / distinct);
+  printf("Count estimates: %.1f%% exact, mean overestimate %.3f, max %u\n",
+    100.0 * exact_est / distinct, (double)over / distinct, max_over);
+  printf("Memory: filter %zu KB + sketch %zu KB, against about %zu KB for a "
+    "hash set of names\n", bloom_bytes(b) / 1024, cms_bytes(c) / 1024,
+    (size_t)distinct * (30 + 2 * sizeof(void*)) / 1024);
+
+  bloom_free(b);
+  cms_free(c);
+  free(who);
+  free(names);
+  free(exact);
+  return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * This file contains executable code for comparing a lookup by call ID in
+ * the skip list index with the linear search list_position() does over the
+ * list behind the answered stack.  Both hold the same calls, inserted newest
+ * first as the stack pushes them.  It also times a range query by answer
+ * time and a full in-order walk of the index.
+ *
+ * Usage: ./bench_skiplist [calls]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "call.h"
+#include "list.h"
+#include "skiplist.h"
+#include "timeutil.h"
+
+#define LIST_LOOKUPS 200
+#define INDEX_LOOKUPS 1000000
+
+/*
+ * Function used by list_position() to compare calls by ID.
+ */
+int cmp_id(void* a, void* b) {
+  return ((Call*)a)->id != ((Call*)b)->id;
+}
+
+int main(int argc, char** argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 1000000;
+  Call* calls = malloc(n * sizeof(Call));
+  struct list* list = list_create();
+  struct skiplist* by_id = skiplist_create();
+  struct skiplist* by_time = skiplist_create();
+  Call probe;
+  long found = 0;
+
+  long long start = now_ns();
+  for (int i = 0; i < n; i++) {
+    calls[i].id = i + 1;
+    calls[i].answered_ns = i * 1000000LL; // One answer a millisecond
+    list_insert(list, &calls[i]);
+  }
+  long long list_build = now_ns() - start;
+  start = now_ns();
+  for (int i = 0; i < n; i++) {
+    skiplist_insert(by_id, calls[i].id, &calls[i]);
+    skiplist_insert(by_time, calls[i].answered_ns, &calls[i]);
+  }
+  long long index_build = now_ns() - start;
+  printf("Build, %d calls: list %.1f ns/call, both indexes %.1f ns/call\n", n,
+    (double)list_build / n, (double)index_build / n);
+
+  srand(3);
+  start = now_ns();
+  for (int i = 0; i < LIST_LOOKUPS; i++) {
+    probe.id = 1 + rand() % n;
+    found += list_position(list, &probe, cmp_id) >= 0;
+  }
+  double list_ns = (double)(now_ns() - start) / LIST_LOOKUPS;
+  start = now_ns();
+  for (int i = 0; i < INDEX_LOOKUPS; i++) {
+    found += skiplist_find(by_id, 1 + rand() % n) != NULL;
+  }
+  double index_ns = (double)(now_ns() - start) / INDEX_LOOKUPS;
+  printf("Lookup by ID: list_position %.0f ns, skip list %.0f ns "
+    "(%.0fx faster, %ld found)\n", list_ns, index_ns, list_ns / index_ns,
+    found);
+
+  /*
+   * Five minutes of answers starting at random points.
+   */
+  long in_range = 0;
+  int ranges = 1000;
+  long long span = 300000LL * 1000000;
+  start = now_ns();
+  for (int i = 0; i < ranges; i++) {
+    long long lo = (long long)(rand() % n) * 1000000;
+    struct skipnode* node = skiplist_seek(by_time, lo);
+    for (; node && skiplist_key(node) < lo + span; node = skiplist_next(node)) {
+      in_range++;
+    }
+  }
+  printf("Range query, 5 minutes: %.1f us (%.0f calls each)\n",
+    (now_ns() - start) / 1e3 / ranges, (double)in_range / ranges);
+
+  start = now_ns();
+  long walked = 0;
+  for (struct skipnode* node = skiplist_first(by_id); node;
+      node = skiplist_next(node)) {
+    walked += ((Call*)skiplist_value(node))->id > 0;
+  }
+  printf("In-order walk: %.1f ns per call (%ld calls)\n",
+    (double)(now_ns() - start) / walked, walked);
+
+  skiplist_free(by_id);
+  skiplist_free(by_time);
+  while (!list_isempty(list)) {
+    pop_value(list); // The calls aren't the list's to free
+  }
+  list_free(list);
+  free(calls);
+  return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * This file contains executable code for measuring what many small queues
+ * and stacks cost, as when the process hosts a call center per tenant and
+ * most of them hold only a few calls.  For 0 to 5 values each it creates a
+ * large number of queues and stacks, and reports the time to create and
+ * fill one, the bytes each one accounts for (see queue_mem_stats()) and
+ * the resident memory each one adds, allocator overhead included.
+ *
+ * Usage: ./bench_small [containers]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "queue.h"
+#include "stack.h"
+#include "timeutil.h"
+
+/*
+ * Returns the resident set size of this process in bytes, or -1 if unknown.
+ */
+double rss_bytes() {
+  long pages = -1, resident = -1;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (!f) {
+    return -1;
+  }
+  if (fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+    resident = -1;
+  }
+  fclose(f);
+  return resident < 0 ? -1 : resident * (double)sysconf(_SC_PAGESIZE);
+}
+
+/*
+ * Creates `n` queues and `n` stacks holding `k` values each and prints a
+ * line of results.
+ */
+void run(int n, int k) {
+  struct queue** queues = malloc(n * sizeof(struct queue*));
+  struct stack** stacks = malloc(n * sizeof(struct stack*));
+  struct mem_stats m;
+  static int value; // Containers only hold pointers to it
+
+  double rss = rss_bytes();
+  long long start = now_ns();
+  for (int i = 0; i < n; i++) {
+    queues[i] = queue_create();
+    for (int j = 0; j < k; j++) {
+      queue_enqueue(queues[i], &value);
+    }
+  }
+  double queue_ns = (double)(now_ns() - start) / n;
+  double queue_rss = (rss_bytes() - rss) / n;
+  queue_mem_stats(queues[0], &m);
+  size_t queue_bytes = m.reserved;
+
+  rss = rss_bytes();
+  start = now_ns();
+  for (int i = 0; i < n; i++) {
+    stacks[i] = stack_create();
+    for (int j = 0; j < k; j++) {
+      stack_push(stacks[i], &value);
+    }
+  }
+  double stack_ns = (double)(now_ns() - start) / n;
+  double stack_rss = (rss_bytes() - rss) / n;
+  stack_mem_stats(stacks[0], &m);
+
+  printf("%6d %12.1f %12zu %12.0f %12.1f %12zu %12.0f\n", k, queue_ns,
+    queue_bytes, queue_rss, stack_ns, m.reserved, stack_rss);
+}
+
+int main(int argc, char** argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 100000;
+
+  printf("%d containers of each kind\n", n);
+  printf("%6s %12s %12s %12s %12s %12s %12s\n", "values", "queue ns",
+    "queue bytes", "queue RSS", "stack ns", "stack bytes", "stack RSS");
+  fflush(stdout);
+  for (int k = 0; k <= 5; k++) {
+    // Each run in its own process, so memory freed by one isn't reused
+    if (fork() == 0) {
+      run(n, k);
+      exit(0);
+    }
+    wait(NULL);
+  }
+  return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * This file contains executable code for measuring how much supervisor
+ * readers slow down the writer.  The writer answers calls (dequeue, then
+ * push onto a bounded answered stack), receives a new one for each, and
+ * publishes a summary after every operation and a full snapshot every
+ * SNAPSHOT_EVERY operations.  Readers spin reading the summary and walking
+ * the snapshot.
+ *
+ * Usage: ./bench_snapshot [ops] [waiting_calls]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "snapshot.h"
+#include "timeutil.h"
+
+#define SNAPSHOT_EVERY 1000
+
+struct board* b;
+int done;
+long reads;
+
+void* reader(void* arg) {
+  int me = board_reader_register(b);
+  long n = 0, sink = 0;
+  while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+    struct cc_summary sum;
+    board_read_summary(b, &sum);
+    const struct cc_snapshot* snap = board_snapshot_enter(b, me);
+    if (snap) {
+      for (int i = 0; i < snap->n_waiting; i++) {
+        sink += snap->waiting[i].id;
+      }
+    }
+    board_snapshot_exit(b, me);
+    n++;
+  }
+  __atomic_add_fetch(&reads, n + (sink & 0), __ATOMIC_RELAXED);
+  return NULL;
+}
+
+/*
+ * Frees an answered call as it leaves the stack.
+ */
+void free_call(struct ilink* link, void* ctx) {
+  free(CALL_OF_LINK(link));
+}
+
+void run(int n_readers, int ops, int waiting) {
+  pthread_t* threads = malloc((n_readers + 1) * sizeof(pthread_t));
+  struct queue* q = queue_create();
+  struct istack* s = istack_create(100);
+  struct cc_summary sum = { 0 };
+  int next_id = 1;
+
+  istack_set_evict(s, free_call, NULL);
+  b = board_create(n_readers + 1);
+  done = 0;
+  reads = 0;
+  for (int i = 0; i < waiting; i++) {
+    Call* c = malloc(sizeof(Call));
+    c->id = next_id++;
+    queue_enqueue(q, c);
+  }
+  for (int i = 0; i < n_readers; i++) {
+    pthread_create(&threads[i], NULL, reader, NULL);
+  }
+
+  long long start = now_ns();
+  for (int i = 0; i < ops; i++) {
+    istack_push(s, &((Call*)queue_dequeue(q))->link);
+    Call* c = malloc(sizeof(Call));
+    c->id = next_id++;
+    queue_enqueue(q, c);
+
+    sum.queue_size = queue_size(q);
+    sum.stack_size = istack_size(s);
+    sum.has_front = sum.has_top = 1;
+    sum.front = *(Call*)queue_front(q);
+    sum.top = *CALL_OF_LINK(istack_top(s));
+    sum.received = next_id - 1;
+    sum.answered = i + 1;
+    board_publish_summary(b, &sum);
+    if (i % SNAPSHOT_EVERY == 0) {
+      board_publish_snapshot(b, snapshot_build(q, s, 10));
+    }
+  }
+  long long elapsed = now_ns() - start;
+  __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+  for (int i = 0; i < n_readers; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  printf("%7d %14.2f %14.2f\n", n_readers, ops / (elapsed / 1e9) / 1e6,
+    reads / (elapsed / 1e9) / 1e6);
+  board_free(b);
+  queue_free(q);
+  istack_clear(s, free_call, NULL);
+  istack_free(s);
+  free(threads);
+}
+
+int main(int argc, char** argv) {
+  int ops = argc > 1 ? atoi(argv[1]) : 2000000;
+  int waiting = argc > 2 ? atoi(argv[2]) : 100;
+
+  printf("%7s %14s %14s\n", "readers", "writer_Mops", "reader_Mreads");
+  for (int r = 0; r <= 16; r = r ? r * 2 : 1) {
+    run(r, ops, waiting);
+  }
+  return 0;
+}
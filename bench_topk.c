@@ -0,0 +1,144 @@
+/*
+ * This file contains executable code for comparing the Space-Saving
+ * heavy-hitter tracker with exact counting of call reasons.  Reasons are
+ * drawn from a Zipf distribution over a vocabulary.  Exact counting keeps a
+ * hash table with an entry per distinct reason and sorts all of them to
+ * find the top 10; the tracker uses a fixed number of counters.  It reports
+ * throughput for both and how well the tracker's top 10 matches.
+ *
+ * Usage: ./bench_topk [calls] [reasons] [counters]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sketch.h"
+#include "timeutil.h"
+#include "topk.h"
+
+#define TOP 10
+
+/*
+ * An entry of the exact counting table.
+ */
+struct entry {
+  const char* key;
+  long count;
+};
+
+/*
+ * Function used to sort entries by count, highest first, with qsort().
+ */
+int cmp_count(const void* a, const void* b) {
+  long x = ((const struct entry*)a)->count, y = ((const struct entry*)b)->count;
+  return (x < y) - (x > y);
+}
+
+int main(int argc, char** argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 5000000;
+  int vocab = argc > 2 ? atoi(argv[2]) : 100000;
+  int counters = argc > 3 ? atoi(argv[3]) : 1000;
+  char (*reasons)[40] = malloc((size_t)vocab * 40);
+  double* cdf = malloc(vocab * sizeof(double));
+  int* stream = malloc(n * sizeof(int));
+
+  /*
+   * Zipf with exponent 1.1: reason i has weight 1 / (i + 1)^1.1.
+   */
+  double sum = 0;
+  for (int i = 0; i < vocab; i++) {
+    snprintf(reasons[i], 40, "reason for calling #%d", i);
+    sum += pow(i + 1, -1.1);
+    cdf[i] = sum;
+  }
+  srand(9);
+  for (int i = 0; i < n; i++) {
+    double u = (double)rand() / RAND_MAX * sum;
+    int lo = 0, hi = vocab - 1;
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (cdf[mid] < u) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    stream[i] = lo;
+  }
+
+  /*
+   * Exact counting: a linear-probing table sized for the whole vocabulary.
+   */
+  uint64_t size = 1;
+  while (size < 2 * (uint64_t)vocab) {
+    size *= 2;
+  }
+  struct entry* table = calloc(size, sizeof(struct entry));
+  long long start = now_ns();
+  for (int i = 0; i < n; i++) {
+    const char* key = reasons[stream[i]];
+    uint64_t j = sketch_hash(key, strlen(key)) & (size - 1);
+    while (table[j].key && strcmp(table[j].key, key) != 0) {
+      j = (j + 1) & (size - 1);
+    }
+    table[j].key = key;
+    table[j].count++;
+  }
+  double exact_ns = (double)(now_ns() - start) / n;
+  start = now_ns();
+  int distinct = 0;
+  for (uint64_t j = 0; j < size; j++) {
+    if (table[j].key) {
+      table[distinct++] = table[j];
+    }
+  }
+  qsort(table, distinct, sizeof(struct entry), cmp_count);
+  double sort_ms = (now_ns() - start) / 1e6;
+
+  struct topk* t = topk_create(counters);
+  struct topk_item top[TOP];
+  start = now_ns();
+  for (int i = 0; i < n; i++) {
+    topk_add(t, reasons[stream[i]]);
+  }
+  double topk_ns = (double)(now_ns() - start) / n;
+  start = now_ns();
+  int k = topk_top(t, TOP, top);
+  double top_us = (now_ns() - start) / 1e3;
+
+  /*
+   * Score the tracker's top 10 against the exact one.
+   */
+  int hits = 0;
+  double worst = 0;
+  for (int i = 0; i < k; i++) {
+    for (int j = 0; j < TOP; j++) {
+      if (strcmp(top[i].key, table[j].key) == 0) {
+        hits++;
+        double err = (double)(top[i].count - table[j].count) / table[j].count;
+        worst = err > worst ? err : worst;
+      }
+    }
+  }
+
+  printf("%d calls, %d distinct reasons, %d counters\n", n, distinct, counters);
+  printf("Exact counting: %.1f ns per call, top 10 by sorting %.1f ms, "
+    "%zu KB\n", exact_ns, sort_ms, size * sizeof(struct entry) / 1024);
+  printf("Space-Saving:   %.1f ns per call, top 10 in %.1f us, %zu KB\n",
+    topk_ns, top_us, (size_t)counters * (TOPK_KEY_MAX + 64) / 1024);
+  printf("Top 10 recall: %d / 10, worst count overestimate %.3f%%\n", hits,
+    100 * worst);
+  for (int i = 0; i < k; i++) {
+    printf("  %2d. %-28s %8ld (-%ld)   exact #%d: %8ld\n", i + 1, top[i].key,
+      top[i].count, top[i].error, i + 1, table[i].count);
+  }
+
+  topk_free(t);
+  free(table);
+  free(reasons);
+  free(cdf);
+  free(stream);
+  return 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * This file contains executable code for comparing the typed queue and stack
+ * generated by DEFINE_QUEUE()/DEFINE_STACK() with the void* queue and stack,
+ * for int and Call elements.  For the void* containers every element is
+ * allocated with malloc(), as callcenter.c does for calls.
+ *
+ * Usage: ./bench_typed [n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "call.h"
+#include "queue.h"
+#include "stack.h"
+#include "timeutil.h"
+#include "typed_queue.h"
+#include "typed_stack.h"
+
+DEFINE_QUEUE(int_queue, int)
+DEFINE_QUEUE(call_queue, Call)
+DEFINE_STACK(int_stack, int)
+DEFINE_STACK(call_stack, Call)
+
+volatile long sink;
+
+void report(const char* what, long long ns, int n) {
+  printf("%-28s %8.2f ns/element\n", what, (double)ns / n);
+}
+
+int main(int argc, char** argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 4000000;
+  long long start;
+  long sum;
+
+  /*
+   * Queue of ints: enqueue n, then dequeue n summing the values.
+   */
+  start = now_ns();
+  struct queue* q = queue_create();
+  for (int i = 0; i < n; i++) {
+    int* v = malloc(sizeof(int));
+    *v = i;
+    queue_enqueue(q, v);
+  }
+  sum = 0;
+  while (!queue_isempty(q)) {
+    int* v = queue_dequeue(q);
+    sum += *v;
+    free(v);
+  }
+  queue_free(q);
+  sink = sum;
+  report("void* queue, int", now_ns() - start, n);
+
+  start = now_ns();
+  struct int_queue* iq = int_queue_create();
+  for (int i = 0; i < n; i++) {
+    int_queue_enqueue(iq, i);
+  }
+  sum = 0;
+  while (!int_queue_isempty(iq)) {
+    sum += int_queue_dequeue(iq);
+  }
+  int_queue_free(iq);
+  sink = sum;
+  report("typed queue, int", now_ns() - start, n);
+
+  /*
+   * Queue of Calls.
+   */
+  start = now_ns();
+  q = queue_create();
+  for (int i = 0; i < n; i++) {
+    Call* c = malloc(sizeof(Call));
+    c->id = i;
+    queue_enqueue(q, c);
+  }
+  sum = 0;
+  while (!queue_isempty(q)) {
+    Call* c = queue_dequeue(q);
+    sum += c->id;
+    free(c);
+  }
+  queue_free(q);
+  sink = sum;
+  report("void* queue, Call", now_ns() - start, n);
+
+  start = now_ns();
+  struct call_queue* cq = call_queue_create();
+  for (int i = 0; i < n; i++) {
+    Call c;
+    c.id = i;
+    call_queue_enqueue(cq, c);
+  }
+  sum = 0;
+  while (!call_queue_isempty(cq)) {
+    sum += call_queue_get(cq, 0)->id;
+    call_queue_dequeue(cq);
+  }
+  call_queue_free(cq);
+  sink = sum;
+  report("typed queue, Call", now_ns() - start, n);
+
+  /*
+   * Stack of ints: push n, then pop n summing the values.
+   */
+  start = now_ns();
+  struct stack* s = stack_create();
+  for (int i = 0; i < n; i++) {
+    int* v = malloc(sizeof(int));
+    *v = i;
+    stack_push(s, v);
+  }
+  sum = 0;
+  while (!stack_isempty(s)) {
+    int* v = stack_pop(s);
+    sum += *v;
+    free(v);
+  }
+  stack_free(s);
+  sink = sum;
+  report("void* stack, int", now_ns() - start, n);
+
+  start = now_ns();
+  struct int_stack* is = int_stack_create();
+  for (int i = 0; i < n; i++) {
+    int_stack_push(is, i);
+  }
+  sum = 0;
+  while (!int_stack_isempty(is)) {
+    sum += int_stack_pop(is);
+  }
+  int_stack_free(is);
+  sink = sum;
+  report("typed stack, int", now_ns() - start, n);
+
+  /*
+   * Stack of Calls.
+   */
+  start = now_ns();
+  s = stack_create();
+  for (int i = 0; i < n; i++) {
+    Call* c = malloc(sizeof(Call));
+    c->id = i;
+    stack_push(s, c);
+  }
+  sum = 0;
+  while (!stack_isempty(s)) {
+    Call* c = stack_pop(s);
+    sum += c->id;
+    free(c);
+  }
+  stack_free(s);
+  sink = sum;
+  report("void* stack, Call", now_ns() - start, n);
+
+  start = now_ns();
+  struct call_stack* cs = call_stack_create();
+  for (int i = 0; i < n; i++) {
+    Call c;
+    c.id = i;
+    call_stack_push(cs, c);
+  }
+  sum = 0;
+  while (!call_stack_isempty(cs)) {
+    sum += call_stack_get(cs, 0)->id;
+    call_stack_pop(cs);
+  }
+  call_stack_free(cs);
+  sink = sum;
+  report("typed stack, Call", now_ns() - start, n);
+
+  /*
+   * Summing a full typed queue in place is a straight loop over the buffer.
+   */
+  iq = int_queue_create();
+  for (int i = 0; i < n; i++) {
+    int_queue_enqueue(iq, i);
+  }
+  start = now_ns();
+  sum = 0;
+  for (int i = 0; i < int_queue_size(iq); i++) {
+    sum += *int_queue_get(iq, i);
+  }
+  sink = sum;
+  report("typed queue, int, scan", now_ns() - start, n);
+  int_queue_free(iq);
+  return 0;
+}
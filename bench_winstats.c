@@ -0,0 +1,49 @@
+/*
+ * This file contains executable code for measuring the cost of counting
+ * events in the sliding-window statistics, and of reading a window.
+ *
+ * Usage: ./bench_winstats [events]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "timeutil.h"
+#include "winstats.h"
+
+int main(int argc, char** argv) {
+  long n = argc > 1 ? atol(argv[1]) : 20000000;
+  struct winstats* ws = winstats_create(20000000000LL, 0);
+  struct winstats_window w;
+
+  /*
+   * Events 10 us apart on a simulated clock, so they spread over many
+   * buckets and the ring wraps; every other event is an answer.
+   */
+  long long start = now_ns();
+  for (long i = 0; i < n; i++) {
+    long long t = i * 10000LL;
+    if (i & 1) {
+      winstats_answered(ws, (i & 0xffff) * 1000000LL, t);
+    } else {
+      winstats_received(ws, t);
+    }
+  }
+  long long elapsed = now_ns() - start;
+  printf("Per event: %.1f ns over %ld events (%.0f s simulated)\n",
+    (double)elapsed / n, n, n * 1e-5);
+
+  int reads = 10000;
+  long sum = 0;
+  start = now_ns();
+  for (int i = 0; i < reads; i++) {
+    winstats_window(ws, WINSTATS_SECONDS, n * 10000LL, &w);
+    sum += w.received;
+  }
+  elapsed = now_ns() - start;
+  printf("Per 15-minute window read: %.1f ns (%ld received)\n",
+    (double)elapsed / reads, sum / reads);
+
+  winstats_free(ws);
+  return 0;
+}
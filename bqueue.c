@@ -0,0 +1,247 @@
+/*
+ * This file contains an implementation of a blocking queue.  Values are kept
+ * in an ordinary queue (see queue.c) guarded by a mutex.  A consumer that
+ * finds the queue empty first spins for a short, adaptively sized period in
+ * case a value is about to arrive, and then parks on a condition variable.
+ * Producers only signal when some consumer is actually parked, so the
+ * enqueue path makes no system call while consumers are busy.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "bqueue.h"
+#include "queue.h"
+
+#define BQUEUE_SPIN_MIN 16
+#define BQUEUE_SPIN_MAX 4096
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define CPU_RELAX() __asm__ __volatile__("" ::: "memory")
+#endif
+
+#if defined(__APPLE__)
+#define BQUEUE_CLOCK CLOCK_REALTIME
+#else
+#define BQUEUE_CLOCK CLOCK_MONOTONIC
+#endif
+
+/*
+ * This structure is used to represent a blocking queue.  `size` mirrors the
+ * size of `queue` so spinning consumers can poll it without taking the lock.
+ */
+struct bqueue {
+  pthread_mutex_t lock;
+  pthread_cond_t nonempty;
+  struct queue* queue;
+  int size;
+  int waiters;
+  int closed;
+  int spin_limit;
+};
+
+/*
+ * This function allocates and initializes a new, empty blocking queue and
+ * returns a pointer to it.
+ */
+struct bqueue* bqueue_create() {
+  struct bqueue* bq = malloc(sizeof(struct bqueue));
+  assert(bq);
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+#if !defined(__APPLE__)
+  pthread_condattr_setclock(&attr, BQUEUE_CLOCK);
+#endif
+  pthread_cond_init(&bq->nonempty, &attr);
+  pthread_condattr_destroy(&attr);
+  pthread_mutex_init(&bq->lock, NULL);
+
+  bq->queue = queue_create();
+  bq->size = 0;
+  bq->waiters = 0;
+  bq->closed = 0;
+  bq->spin_limit = BQUEUE_SPIN_MIN;
+  return bq;
+}
+
+/*
+ * This function frees the memory associated with a blocking queue, freeing
+ * any values still stored in it just as queue_free() does.  No thread may be
+ * waiting on the queue when it is freed.
+ *
+ * Params:
+ *   bq - the blocking queue to be destroyed.  May not be NULL.
+ */
+void bqueue_free(struct bqueue* bq) {
+  assert(bq);
+  queue_free(bq->queue);
+  pthread_cond_destroy(&bq->nonempty);
+  pthread_mutex_destroy(&bq->lock);
+  free(bq);
+}
+
+/*
+ * This function enqueues a new value into a blocking queue, waking one
+ * parked consumer if there is one.
+ *
+ * Params:
+ *   bq - the blocking queue into which to enqueue a value.  May not be NULL.
+ *   val - the value to be enqueued.
+ */
+void bqueue_enqueue(struct bqueue* bq, void* val) {
+  assert(bq);
+  pthread_mutex_lock(&bq->lock);
+  queue_enqueue(bq->queue, val);
+  __atomic_store_n(&bq->size, bq->size + 1, __ATOMIC_RELEASE);
+  int wake = bq->waiters > 0;
+  pthread_mutex_unlock(&bq->lock);
+
+  if (wake) {
+    pthread_cond_signal(&bq->nonempty);
+  }
+}
+
+/*
+ * This function enqueues several values into a blocking queue under a single
+ * lock acquisition, then wakes as many parked consumers as there are new
+ * values (all of them if there are at least as many values as waiters).
+ *
+ * Params:
+ *   bq - the blocking queue into which to enqueue values.  May not be NULL.
+ *   vals - the values to be enqueued, in order.
+ *   n - the number of values in `vals`.
+ */
+void bqueue_enqueue_batch(struct bqueue* bq, void** vals, int n) {
+  assert(bq && n >= 0);
+  pthread_mutex_lock(&bq->lock);
+  for (int i = 0; i < n; i++) {
+    queue_enqueue(bq->queue, vals[i]);
+  }
+  __atomic_store_n(&bq->size, bq->size + n, __ATOMIC_RELEASE);
+  int waiters = bq->waiters;
+  pthread_mutex_unlock(&bq->lock);
+
+  if (n >= waiters) {
+    if (waiters > 0) {
+      pthread_cond_broadcast(&bq->nonempty);
+    }
+  } else {
+    for (int i = 0; i < n; i++) {
+      pthread_cond_signal(&bq->nonempty);
+    }
+  }
+}
+
+/*
+ * Auxilliary function to spin briefly waiting for a blocking queue to become
+ * non-empty.  The spin budget doubles each time spinning pays off and halves
+ * each time the caller ends up parking anyway.
+ *
+ * Return:
+ *   Returns 1 if a value appeared while spinning, 0 otherwise.
+ */
+static int _bqueue_spin(struct bqueue* bq) {
+  int limit = __atomic_load_n(&bq->spin_limit, __ATOMIC_RELAXED);
+  for (int i = 0; i < limit; i++) {
+    if (__atomic_load_n(&bq->size, __ATOMIC_ACQUIRE) > 0 ||
+        __atomic_load_n(&bq->closed, __ATOMIC_RELAXED)) {
+      if (limit < BQUEUE_SPIN_MAX) {
+        __atomic_store_n(&bq->spin_limit, limit * 2, __ATOMIC_RELAXED);
+      }
+      return 1;
+    }
+    CPU_RELAX();
+  }
+  if (limit > BQUEUE_SPIN_MIN) {
+    __atomic_store_n(&bq->spin_limit, limit / 2, __ATOMIC_RELAXED);
+  }
+  return 0;
+}
+
+/*
+ * This function dequeues a value from a blocking queue, waiting for one to
+ * arrive if the queue is empty.
+ *
+ * Params:
+ *   bq - the blocking queue from which to dequeue a value.  May not be NULL.
+ *   timeout_ns - the longest time to wait, in nanoseconds.  A value of 0
+ *     never waits and a negative value waits indefinitely.
+ *
+ * Return:
+ *   Returns the dequeued value, or NULL if the timeout expired or the queue
+ *   was closed while empty.
+ */
+void* bqueue_dequeue_wait(struct bqueue* bq, long long timeout_ns) {
+  assert(bq);
+  if (timeout_ns != 0 && __atomic_load_n(&bq->size, __ATOMIC_ACQUIRE) == 0) {
+    _bqueue_spin(bq);
+  }
+
+  struct timespec deadline;
+  if (timeout_ns > 0) {
+    clock_gettime(BQUEUE_CLOCK, &deadline);
+    deadline.tv_sec += timeout_ns / 1000000000LL;
+    deadline.tv_nsec += timeout_ns % 1000000000LL;
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+  }
+
+  pthread_mutex_lock(&bq->lock);
+  while (bq->size == 0 && !bq->closed && timeout_ns != 0) {
+    int rc = 0;
+    bq->waiters++;
+    if (timeout_ns > 0) {
+      rc = pthread_cond_timedwait(&bq->nonempty, &bq->lock, &deadline);
+    } else {
+      pthread_cond_wait(&bq->nonempty, &bq->lock);
+    }
+    bq->waiters--;
+    if (rc == ETIMEDOUT) {
+      break;
+    }
+  }
+
+  void* val = NULL;
+  if (bq->size > 0) {
+    val = queue_dequeue(bq->queue);
+    __atomic_store_n(&bq->size, bq->size - 1, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&bq->lock);
+  return val;
+}
+
+/*
+ * This function closes a blocking queue, waking every parked consumer.
+ * Values already in the queue can still be dequeued; once it is empty,
+ * bqueue_dequeue_wait() returns NULL immediately.
+ *
+ * Params:
+ *   bq - the blocking queue to be closed.  May not be NULL.
+ */
+void bqueue_close(struct bqueue* bq) {
+  assert(bq);
+  pthread_mutex_lock(&bq->lock);
+  __atomic_store_n(&bq->closed, 1, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&bq->lock);
+  pthread_cond_broadcast(&bq->nonempty);
+}
+
+/*
+ * This function returns the number of values currently in a blocking queue.
+ */
+int bqueue_size(struct bqueue* bq) {
+  assert(bq);
+  return __atomic_load_n(&bq->size, __ATOMIC_ACQUIRE);
+}
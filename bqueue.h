@@ -0,0 +1,29 @@
+/*
+ * This file contains the definition of the interface for a blocking queue, a
+ * thread-safe layer over the queue in queue.h that lets consumers sleep
+ * until a value arrives.  You can find descriptions of the blocking queue
+ * functions, including their parameters and their return values, in
+ * bqueue.c.
+ */
+
+#ifndef __BQUEUE_H
+#define __BQUEUE_H
+
+/*
+ * Structure used to represent a blocking queue.
+ */
+struct bqueue;
+
+/*
+ * Blocking queue interface function prototypes.  Refer to bqueue.c for
+ * documentation about each of these functions.
+ */
+struct bqueue* bqueue_create();
+void bqueue_free(struct bqueue* bq);
+void bqueue_enqueue(struct bqueue* bq, void* val);
+void bqueue_enqueue_batch(struct bqueue* bq, void** vals, int n);
+void* bqueue_dequeue_wait(struct bqueue* bq, long long timeout_ns);
+void bqueue_close(struct bqueue* bq);
+int bqueue_size(struct bqueue* bq);
+
+#endif
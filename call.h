@@ -0,0 +1,39 @@
+/*
+ * This file contains the definition of the Call record shared by the call
+ * center program and the modules that simulate or measure it.
+ */
+
+#ifndef __CALL_H
+#define __CALL_H
+
+#include <stddef.h>
+
+#include "istack.h"
+#include "timerwheel.h"
+
+/*
+ * Structure used to represent a single call.
+ */
+typedef struct {
+    int id;                // Call ID
+    char caller_name[30];  // Caller’s name
+    char call_reason[100]; // Call reason
+    long long received_ns; // Time the call was received (see timeutil.h)
+    struct timer timer;    // Callback time, or timeout while waiting
+    int abandoned;         // Set when the caller hung up while waiting
+    long long answered_ns; // Time the call was answered, once it has been
+    int calls_today;       // Calls from this caller today, this one included (estimate)
+    struct ilink link;     // Place in the stack of answered calls, once answered
+} Call;
+
+/*
+ * Returns the Call that embeds the given timer.
+ */
+#define CALL_OF_TIMER(t) ((Call*)((char*)(t) - offsetof(Call, timer)))
+
+/*
+ * Returns the Call that embeds the given stack link.
+ */
+#define CALL_OF_LINK(l) ((Call*)((char*)(l) - offsetof(Call, link)))
+
+#endif
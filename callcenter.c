@@ -1,31 +1,249 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "admission.h"
+#include "agent_sim.h"
+#include "call.h"
+#include "intake_proto.h"
+#include "intake_server.h"
+#include "istack.h"
+#include "metrics.h"
 #include "queue.h"
-#include "stack.h"
+#include "shmring.h"
+#include "sketch.h"
+#include "skiplist.h"
+#include "timerwheel.h"
+#include "timeutil.h"
+#include "topk.h"
+#include "trace.h"
+#include "winstats.h"
 
+/*
+ * With fewer calls than this held, quitting frees everything, which takes
+ * well under a second and keeps leak checkers useful.  With more, quitting
+ * skips freeing them one by one unless --clean-exit was given.
+ */
+#define FAST_EXIT_MIN_CALLS 100000
 
 /*
- * Define your call struct here.
+ * What-if estimates give up on clearing the calls waiting after this many
+ * seconds, and report the service level over at most this many of the
+ * most recent answers.
  */
-typedef struct {
-    int id;               // Call ID
-    char caller_name[30]; // Caller’s name
-    char call_reason[100]; // Call reason
-} Call;
+#define WHAT_IF_HORIZON_S 86400
+#define WHAT_IF_RECENT 1000
+
 
 // Function prototypes
 void receive_call(struct queue* queue);
-void answer_call(struct queue* queue, struct stack* stack);
-void display_stack(struct stack* stack);
+void answer_call(struct queue* queue, struct istack* stack);
+void display_stack(struct istack* stack);
 void display_queue(struct queue* queue);
+void display_stats();
+void display_memory(struct queue* queue, struct istack* stack);
+void find_answered();
+void list_answered();
+void display_top_reasons();
+void what_if(struct queue* queue, struct istack* stack);
+void forget_answered(struct ilink* link, void* ctx);
+void dispose_answered(struct ilink* link, void* ctx);
+void schedule_callback(struct queue* queue);
+void enqueue_call(struct queue* queue, Call* call);
+enum admit_decision admit_call(struct queue* queue, Call* call);
+int count_caller(const char* name);
+int submit_call(struct queue* queue, Call* call);
+void schedule_call(struct queue* queue, Call* call, unsigned long long delay_ms,
+    void (*due)(struct timer* t, void* ctx));
+Call* take_call(struct queue* queue, struct istack* stack);
+void drop_abandoned(struct queue* queue);
+void callback_due(struct timer* t, void* ctx);
+void diverted_callback_due(struct timer* t, void* ctx);
+void call_timed_out(struct timer* t, void* ctx);
+void dispose_timer(struct timer* t, void* ctx);
+unsigned long long current_tick();
+long long clock_ns();
 void clear_input_buffer(); // Function to clear input buffer after reading string
+int run_simulation(int argc, char const *argv[]);
+int run_role(int argc, char const *argv[]);
+int run_intake(struct shmring* ring);
+int run_agent(struct shmring* ring);
+int run_menu(struct queue* call_queue, struct istack* answered_calls,
+    struct intake_server* server);
+int run_replay(const char* path, struct queue* queue, struct istack* stack);
+
+int last_call_id = 0; // ID given to the most recent call to join the queue
+int total_answered = 0; // Calls answered so far, including any no longer kept
+int abandoned_waiting = 0; // Abandoned calls not yet removed from the queue
+int callbacks_promised = 0; // Calls diverted to callbacks that aren't due yet
+int wait_timeout_s = 0; // Seconds a call may wait before it's dropped (0 = forever)
+struct timerwheel* wheel; // Callbacks and wait timeouts, in millisecond ticks
+long long start_ns; // Time the program started; tick 0 of `wheel`
+struct metrics* metrics = NULL; // Shared-memory counters, if --metrics was given
+struct admission* admission = NULL; // Admission control for new calls, if enabled
+long long replay_clock = -1; // Trace time while replaying a trace, otherwise -1
+long long* answer_waits = NULL; // While replaying, how long each answered call waited
+int n_answer_waits = 0, cap_answer_waits = 0;
+struct winstats* stats; // Calls received and answered over the last 15 minutes
+int target_s = 20; // Service-level target: seconds within which to answer calls
+struct skiplist* answered_by_id; // Calls in the answered stack, by call ID
+struct skiplist* answered_by_time; // The same calls, by time answered
+struct bloom* callers_seen; // Callers who have called today
+struct cms* caller_counts; // How many times each caller has called today
+long long callers_day = 0; // Day the two above are for, counted from the start
+long repeat_calls = 0; // Calls flagged as coming from repeat callers
+struct topk* top_reasons; // The most frequent call reasons
 
 
 int main(int argc, char const *argv[]) {
+    int history = 0; // Number of answered calls to keep (0 = keep all)
+    const char* metrics_name = NULL; // Shared-memory name for counters, if any
+    const char* listen_path = NULL; // Socket to accept calls on, if any
+    struct intake_server* server = NULL;
+    const char* replay_path = NULL; // Trace to replay instead of the menu, if any
+    struct admission_config admit = { 0, 0, 0, 0 }; // No limits by default
+    int clean_exit = 0; // Free everything before exiting, however much there is
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--agents=", 9) == 0) {
+            return run_simulation(argc, argv);
+        }
+        if (strncmp(argv[i], "--role=", 7) == 0) {
+            return run_role(argc, argv);
+        }
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--history=", 10) == 0) {
+            history = atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--timeout=", 10) == 0) {
+            wait_timeout_s = atoi(argv[i] + 10);
+        } else if (strcmp(argv[i], "--metrics") == 0) {
+            metrics_name = METRICS_NAME;
+        } else if (strncmp(argv[i], "--metrics=", 10) == 0) {
+            metrics_name = argv[i] + 10;
+        } else if (strcmp(argv[i], "--listen") == 0) {
+            listen_path = INTAKE_PATH;
+        } else if (strncmp(argv[i], "--listen=", 9) == 0) {
+            listen_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--replay=", 9) == 0) {
+            replay_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--admit-rate=", 13) == 0) {
+            admit.rate = atof(argv[i] + 13);
+        } else if (strncmp(argv[i], "--admit-burst=", 14) == 0) {
+            admit.burst = atof(argv[i] + 14);
+        } else if (strncmp(argv[i], "--max-depth=", 12) == 0) {
+            admit.max_depth = atoi(argv[i] + 12);
+        } else if (strncmp(argv[i], "--max-wait=", 11) == 0) {
+            admit.max_wait_s = atof(argv[i] + 11);
+        } else if (strncmp(argv[i], "--target=", 9) == 0) {
+            target_s = atoi(argv[i] + 9);
+        } else if (strcmp(argv[i], "--clean-exit") == 0) {
+            clean_exit = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--history=N] [--timeout=SECONDS] "
+                "[--metrics[=NAME]] [--listen[=PATH]]\n", argv[0]);
+            fprintf(stderr, "       [--admit-rate=CALLS_PER_S] [--admit-burst=CALLS] "
+                "[--max-depth=N] [--max-wait=SECONDS]\n");
+            fprintf(stderr, "       [--target=SECONDS] [--replay=TRACE] [--clean-exit]\n");
+            fprintf(stderr, "       %s --agents=N [simulation options]\n", argv[0]);
+            fprintf(stderr, "       %s --role=intake|agent [--ring=NAME]\n", argv[0]);
+            return 1;
+        }
+    }
+
 	struct queue* call_queue = queue_create(); // Create a new queue for incoming calls
-    struct stack* answered_calls = stack_create(); // Create a new stack for answered calls
+    // Stack of answered calls, newest on top, keeping only the last `history`
+    // if given; calls link themselves in, so pushing never allocates
+    struct istack* answered_calls = istack_create(history > 0 ? history : 0);
+    answered_by_id = skiplist_create();
+    answered_by_time = skiplist_create();
+    istack_set_evict(answered_calls, forget_answered, NULL); // Keep them in step
+    if (replay_path) {
+        replay_clock = 0; // Trace times count from 0
+    }
+    start_ns = clock_ns();
+    wheel = timerwheel_create(0);
+    stats = winstats_create(target_s * 1000000000LL, start_ns);
+    callers_seen = bloom_create(1000000, 0.01); // A million callers a day
+    caller_counts = cms_create(3e-6, 0.05); // A column per caller, 3 rows
+    top_reasons = topk_create(1000);
+    if (admit.rate > 0 || admit.max_depth > 0 || admit.max_wait_s > 0) {
+        if (admit.rate > 0 && admit.burst <= 0) {
+            admit.burst = admit.rate; // Allow up to a second's worth at once
+        }
+        admission = admission_create(&admit, clock_ns());
+    }
+    if (metrics_name) {
+        metrics = metrics_create(metrics_name);
+        if (!metrics) {
+            fprintf(stderr, "Could not create metrics segment %s\n", metrics_name);
+        }
+    }
+    if (listen_path) {
+        // Accept calls from clients on a socket while waiting for the menu
+        server = intake_server_create(listen_path, call_queue, submit_call);
+        if (!server || !intake_server_watch(server, STDIN_FILENO)) {
+            fprintf(stderr, "Could not listen on %s\n", listen_path);
+            return 1;
+        }
+        // The server waits until stdin is readable, which it can't see if
+        // stdio has already read ahead into its buffer, so read byte by byte
+        setvbuf(stdin, NULL, _IONBF, 0);
+    }
+    int status;
+    if (replay_path) {
+        status = run_replay(replay_path, call_queue, answered_calls);
+    } else {
+        status = run_menu(call_queue, answered_calls, server);
+    }
+
+    // Cleanup
+    if (server) {
+        intake_server_free(server);
+    }
+    if (metrics) {
+        metrics_destroy(metrics, metrics_name);
+    }
+    if (!clean_exit && skiplist_size(answered_by_id) + queue_size(call_queue) +
+            timerwheel_count(wheel) >= FAST_EXIT_MIN_CALLS) {
+        // Freeing millions of calls one by one takes seconds, and the
+        // system takes the memory back at exit anyway
+        fflush(NULL);
+        _Exit(status);
+    }
+    timerwheel_clear(wheel, dispose_timer, NULL);
+    timerwheel_free(wheel);
+    queue_free(call_queue);
+    istack_clear(answered_calls, dispose_answered, NULL);
+    istack_free(answered_calls);
+    skiplist_free(answered_by_id);
+    skiplist_free(answered_by_time);
+    if (admission) {
+        admission_free(admission);
+    }
+    free(answer_waits);
+    winstats_free(stats);
+    bloom_free(callers_seen);
+    cms_free(caller_counts);
+    topk_free(top_reasons);
+    return status;
+}
+
+/*
+ * This function runs the interactive menu until the user quits.  If an
+ * intake server is running, it serves clients while waiting for input.
+ *
+ * Params:
+ *   call_queue - the queue of calls waiting to be answered. It may not be NULL.
+ *   answered_calls - the stack of answered calls. It may not be NULL.
+ *   server - the intake server, or NULL.
+ *
+ * Return:
+ *   Returns the program's exit status.
+ */
+int run_menu(struct queue* call_queue, struct istack* answered_calls,
+        struct intake_server* server) {
     int option;
 
     do {
@@ -34,10 +252,28 @@ int main(int argc, char const *argv[]) {
         printf("3. Current state of the stack   answered calls\n");
         printf("4. Current state of the queue   calls to be answered\n");
         printf("5. Quit\n");
+        printf("6. Schedule a callback\n");
+        printf("7. Calls per second and service level, last 1/5/15 minutes\n");
+        printf("8. Memory used by the queue and the stack\n");
+        printf("9. Find an answered call by ID\n");
+        printf("10. Calls answered in a time range\n");
+        printf("11. Top 10 call reasons\n");
+        printf("12. What if more agents were answering\n");
         printf("Choose an option: ");
-        scanf("%d", &option);
+        if (server) {
+            fflush(stdout);
+            while (!intake_server_run(server, 100)) {
+                timerwheel_advance(wheel, current_tick());
+            }
+        }
+        if (scanf("%d", &option) == EOF) {
+            option = 5; // End of input: quit rather than spin on the menu
+        }
         clear_input_buffer(); // Clear the input buffer after reading an integer
 
+        // Bring due callbacks into the queue and drop calls that timed out
+        timerwheel_advance(wheel, current_tick());
+
         switch (option) {
             case 1:
                 receive_call(call_queue);
@@ -54,14 +290,31 @@ int main(int argc, char const *argv[]) {
             case 5:
                 printf("Quitting the program.\n");
                 break;
+            case 6:
+                schedule_callback(call_queue);
+                break;
+            case 7:
+                display_stats();
+                break;
+            case 8:
+                display_memory(call_queue, answered_calls);
+                break;
+            case 9:
+                find_answered();
+                break;
+            case 10:
+                list_answered();
+                break;
+            case 11:
+                display_top_reasons();
+                break;
+            case 12:
+                what_if(call_queue, answered_calls);
+                break;
             default:
                 printf("Invalid option. Please choose again.\n");
         }
     } while (option != 5);
-
-    // Cleanup
-    queue_free(call_queue);
-    stack_free(answered_calls);
     return 0;
 }
 
@@ -70,8 +323,8 @@ int main(int argc, char const *argv[]) {
  *
  * This prompts the user to enter the caller's name and the reason,
  * stores this information in a new `Call` structure, and enqueues the call
- * into the specified queue. The function also sets a unique ID based on
- * the current size of the queue.
+ * into the specified queue. The call gets the next unique ID when it
+ * joins the queue.
  *
  * Params:
  *   queue - the queue to which the new call will be added. It may not be NULL.
@@ -87,10 +340,256 @@ void receive_call(struct queue* queue) {
     fgets(new_call->call_reason, sizeof(new_call->call_reason), stdin);
     strtok(new_call->call_reason, "\n"); // Remove trailing newline
 
-    new_call->id = queue_size(queue) + 1; // Set call ID based on queue size *note start from 1
+    switch (admit_call(queue, new_call)) { // Add call to the queue, if allowed
+        case ADMIT_ACCEPT:
+            printf("The call has been successfully added to the queue!\n");
+            break;
+        case ADMIT_CALLBACK:
+            printf("The wait is too long; the caller will be called back.\n");
+            break;
+        case ADMIT_REJECT:
+            printf("The call center is too busy; the call was turned away.\n");
+            break;
+    }
+}
+
+/*
+ * This function passes a new call through admission control, if it is
+ * enabled, and then deals with it as decided: the call joins the queue, is
+ * turned into a callback for when the queue is expected to have cleared,
+ * or is turned away and freed.
+ *
+ * Params:
+ *   queue - the queue the call would join. It may not be NULL.
+ *   call - the new call. The queue or the timing wheel takes it over, or
+ *     it is freed. It may not be NULL.
+ *
+ * Return:
+ *   Returns the decision made.
+ */
+enum admit_decision admit_call(struct queue* queue, Call* call) {
+    enum admit_decision decision = ADMIT_ACCEPT;
+    // Calls already promised a callback will be back, so count them as waiting
+    int waiting = queue_size(queue) - abandoned_waiting + callbacks_promised;
 
-    queue_enqueue(queue, (void*)new_call); // Add call to the queue
-    printf("The call has been successfully added to the queue!\n");
+    winstats_received(stats, clock_ns());
+    call->calls_today = count_caller(call->caller_name);
+    topk_add(top_reasons, call->call_reason);
+    if (call->calls_today > 1) {
+        repeat_calls++;
+        if (replay_clock < 0) {
+            printf("Repeat caller: %s has called %d times today.\n",
+                call->caller_name, call->calls_today);
+        }
+    }
+    if (admission) {
+        decision = admission_check(admission, waiting, clock_ns());
+    }
+    if (decision == ADMIT_ACCEPT) {
+        enqueue_call(queue, call);
+    } else if (decision == ADMIT_CALLBACK) {
+        // Call back once everyone ahead, callbacks included, should be served
+        schedule_call(queue, call,
+            (unsigned long long)(admission_estimated_wait(admission, waiting) * 1000),
+            diverted_callback_due);
+        callbacks_promised++;
+    } else {
+        free(call);
+    }
+    return decision;
+}
+
+/*
+ * This function counts a call from a caller and returns about how many
+ * times that caller has called today, this call included.  Callers are
+ * tracked in a Bloom filter and a count-min sketch of fixed size rather
+ * than a set of names: the filter tells a first call for certain, and the
+ * sketch estimates the count for callers seen before, never too low and
+ * rarely too high.  Both are cleared every 24 hours from the start.
+ *
+ * Params:
+ *   name - the caller's name. It may not be NULL.
+ */
+int count_caller(const char* name) {
+    long long day = (clock_ns() - start_ns) / (86400 * 1000000000LL);
+    if (day != callers_day) {
+        bloom_clear(callers_seen);
+        cms_clear(caller_counts);
+        callers_day = day;
+    }
+
+    uint64_t hash = sketch_hash(name, strlen(name));
+    int seen = bloom_add(callers_seen, hash);
+    uint32_t count = cms_add(caller_counts, hash);
+    return seen ? (int)count : 1;
+}
+
+/*
+ * Function used by the intake server to add a submitted call: the call
+ * passes through admit_call() like any other new call.
+ *
+ * Return:
+ *   Returns 1 if the call joined the queue, or 0 if it didn't.
+ */
+int submit_call(struct queue* queue, Call* call) {
+    return admit_call(queue, call) == ADMIT_ACCEPT;
+}
+
+/*
+ * This function adds a call to the queue of calls waiting to be answered.
+ *
+ * It gives the call the next ID, so IDs increase from the front of the
+ * queue to the back, and records when the call started waiting.  If a wait
+ * timeout is configured, the call's timer is set so the call is dropped if
+ * it isn't answered in time.
+ *
+ * Params:
+ *   queue - the queue to which the call will be added. It may not be NULL.
+ *   call - the call to add. It may not be NULL.
+ */
+void enqueue_call(struct queue* queue, Call* call) {
+    call->id = ++last_call_id; // IDs start from 1
+    call->received_ns = clock_ns();
+    call->abandoned = 0;
+    timer_init(&call->timer, call_timed_out, queue);
+    if (wait_timeout_s > 0) {
+        timerwheel_schedule(wheel, &call->timer,
+            current_tick() + 1000ULL * wait_timeout_s);
+    }
+
+    queue_enqueue(queue, (void*)call);
+    if (metrics) {
+        metrics_inc(&metrics->threads[0].enqueues);
+        metrics_gauge(&metrics->queue, queue_size(queue), queue_capacity(queue));
+    }
+}
+
+/*
+ * This function schedules a callback requested by a customer.
+ *
+ * It prompts the user for the caller's name, the reason and how many seconds
+ * from now the callback should happen.  When that time comes, the call is
+ * added to the queue like a newly received call.
+ *
+ * Params:
+ *   queue - the queue the call will be added to when due. It may not be NULL.
+ */
+void schedule_callback(struct queue* queue) {
+    Call* new_call = (Call*)malloc(sizeof(Call));
+    int delay_s = 0;
+
+    printf("Enter caller's name: ");
+    fgets(new_call->caller_name, sizeof(new_call->caller_name), stdin);
+    strtok(new_call->caller_name, "\n"); // Remove trailing newline
+
+    printf("Enter call reason: ");
+    fgets(new_call->call_reason, sizeof(new_call->call_reason), stdin);
+    strtok(new_call->call_reason, "\n"); // Remove trailing newline
+
+    printf("Call back in how many seconds? ");
+    scanf("%d", &delay_s);
+    clear_input_buffer();
+
+    schedule_call(queue, new_call, 1000ULL * (delay_s > 0 ? delay_s : 0),
+        callback_due);
+    printf("The callback has been scheduled!\n");
+}
+
+/*
+ * This function sets a call up to join the queue after a delay, as a
+ * callback.
+ *
+ * Params:
+ *   queue - the queue the call will be added to when due. It may not be NULL.
+ *   call - the call. The timing wheel holds it until it is due. It may not
+ *     be NULL.
+ *   delay_ms - how many milliseconds from now the call is due.
+ *   due - the timer function that adds the call to the queue when due.
+ */
+void schedule_call(struct queue* queue, Call* call, unsigned long long delay_ms,
+        void (*due)(struct timer* t, void* ctx)) {
+    call->id = 0; // Assigned when the call enters the queue
+    call->abandoned = 0;
+    timer_init(&call->timer, due, queue);
+    timerwheel_schedule(wheel, &call->timer, current_tick() + delay_ms);
+}
+
+/*
+ * Timer function for a scheduled callback that has come due: the call joins
+ * the queue.
+ */
+void callback_due(struct timer* t, void* ctx) {
+    Call* call = CALL_OF_TIMER(t);
+    enqueue_call((struct queue*)ctx, call);
+    if (replay_clock < 0) {
+        printf("Scheduled callback for %s is now waiting in the queue.\n",
+            call->caller_name);
+    }
+}
+
+/*
+ * Timer function for a callback promised by admission control that has come
+ * due.
+ */
+void diverted_callback_due(struct timer* t, void* ctx) {
+    callbacks_promised--;
+    callback_due(t, ctx);
+}
+
+/*
+ * Timer function for a call that has waited too long: the caller hangs up.
+ * The call stays in the queue, marked abandoned, until it reaches the front
+ * and drop_abandoned() removes it.
+ */
+void call_timed_out(struct timer* t, void* ctx) {
+    Call* call = CALL_OF_TIMER(t);
+    call->abandoned = 1;
+    abandoned_waiting++;
+}
+
+/*
+ * This function removes abandoned calls from the front of the queue and
+ * frees them, so the front of the queue is always a call still waiting.
+ *
+ * Params:
+ *   queue - the queue of waiting calls. It may not be NULL.
+ */
+void drop_abandoned(struct queue* queue) {
+    while (!queue_isempty(queue) && ((Call*)queue_front(queue))->abandoned) {
+        free(queue_dequeue(queue));
+        abandoned_waiting--;
+        if (metrics) {
+            metrics_inc(&metrics->threads[0].dequeues);
+            metrics_gauge(&metrics->queue, queue_size(queue), queue_capacity(queue));
+        }
+    }
+}
+
+/*
+ * Function used when quitting to dispose of timers that never fired.  Calls
+ * whose callback was still pending aren't in the queue, so they are freed
+ * here; calls with a pending wait timeout are freed with the queue.
+ */
+void dispose_timer(struct timer* t, void* ctx) {
+    if (t->fn == callback_due || t->fn == diverted_callback_due) {
+        free(CALL_OF_TIMER(t));
+    }
+}
+
+/*
+ * This function returns the current tick of the timing wheel: the number of
+ * milliseconds since the program started.
+ */
+unsigned long long current_tick() {
+    return (unsigned long long)((clock_ns() - start_ns) / 1000000);
+}
+
+/*
+ * This function returns the current time in nanoseconds: the time in the
+ * trace while one is being replayed, otherwise the monotonic clock.
+ */
+long long clock_ns() {
+    return replay_clock >= 0 ? replay_clock : now_ns();
 }
 
 /*
@@ -106,15 +605,13 @@ void receive_call(struct queue* queue) {
  *   queue - the queue from which the call will be answered. It may not be NULL.
  *   stack - the stack where the answered call will be stored. It may not be NULL.
  */
-void answer_call(struct queue* queue, struct stack* stack) {
-    if (queue_isempty(queue)) {
+void answer_call(struct queue* queue, struct istack* stack) {
+    Call* answered_call = take_call(queue, stack);
+    if (!answered_call) {
         printf("No more calls need to be answered at the moment!\n");
         return;
     }
 
-    Call* answered_call = (Call*)queue_dequeue(queue); // Get the first call from the queue
-    stack_push(stack, (void*)answered_call); // Push it onto the stack
-
     printf("The following call has been answered and added to the stack!\n");
     printf("Call ID: %d\n", answered_call->id);
     printf("Caller’s name: %s\n", answered_call->caller_name);
@@ -122,6 +619,53 @@ void answer_call(struct queue* queue, struct stack* stack) {
 
 }
 
+/*
+ * This function takes the first call still waiting off the queue and pushes
+ * it onto the stack of answered calls, keeping the call center's counters
+ * up to date.
+ *
+ * Params:
+ *   queue - the queue of waiting calls. It may not be NULL.
+ *   stack - the stack of answered calls. It may not be NULL.
+ *
+ * Return:
+ *   Returns the answered call, or NULL if no call was waiting.
+ */
+Call* take_call(struct queue* queue, struct istack* stack) {
+    drop_abandoned(queue);
+    if (queue_isempty(queue)) {
+        return NULL;
+    }
+
+    Call* answered_call = (Call*)queue_dequeue(queue); // Get the first call from the queue
+    timerwheel_cancel(wheel, &answered_call->timer); // It can no longer time out
+    if (replay_clock >= 0) {
+        // Record the wait now; with --history the call may soon be evicted
+        if (n_answer_waits == cap_answer_waits) {
+            cap_answer_waits = cap_answer_waits ? 2 * cap_answer_waits : 1024;
+            answer_waits = realloc(answer_waits, cap_answer_waits * sizeof(long long));
+        }
+        answer_waits[n_answer_waits++] = clock_ns() - answered_call->received_ns;
+    }
+    answered_call->answered_ns = clock_ns();
+    skiplist_insert(answered_by_id, answered_call->id, answered_call);
+    skiplist_insert(answered_by_time, answered_call->answered_ns, answered_call);
+    istack_push(stack, &answered_call->link); // Push it onto the stack
+    total_answered++;
+    winstats_answered(stats, clock_ns() - answered_call->received_ns, clock_ns());
+    if (admission) {
+        admission_served(admission, queue_size(queue) - abandoned_waiting,
+            clock_ns());
+    }
+    if (metrics) {
+        metrics_inc(&metrics->threads[0].dequeues);
+        metrics_inc(&metrics->threads[0].pushes);
+        metrics_gauge(&metrics->queue, queue_size(queue), queue_capacity(queue));
+        metrics_gauge(&metrics->stack, istack_size(stack), 0);
+    }
+    return answered_call;
+}
+
 /*  
  * This function displays the current state of the stack, which includes 
  * information about the calls that have been answered.
@@ -135,14 +679,17 @@ void answer_call(struct queue* queue, struct stack* stack) {
  * Params:
  *   stack - the stack containing the answered calls. It may not be NULL.
  */
-void display_stack(struct stack* stack) {
-    if (stack_isempty(stack)) {
+void display_stack(struct istack* stack) {
+    if (istack_isempty(stack)) {
         printf("No calls have been answered yet!\n");
         return;
     }
 
-    Call* last_call = (Call*)stack_top(stack); // Get the last answered call
-    printf("Number of calls answered: %d\n", stack_size(stack));
+    Call* last_call = CALL_OF_LINK(istack_top(stack)); // Get the last answered call
+    printf("Number of calls answered: %d\n", total_answered);
+    if (istack_size(stack) < total_answered) {
+        printf("Most recent calls kept: %d\n", istack_size(stack));
+    }
     printf("Details of the last call answered:\n");
     printf("Call ID: %d\n", last_call->id);
     printf("Caller’s name: %s\n", last_call->caller_name);
@@ -163,13 +710,15 @@ void display_stack(struct stack* stack) {
  *   queue - the queue containing the calls to be answered. It may not be NULL.
  */
 void display_queue(struct queue* queue) {
+    drop_abandoned(queue);
     if (queue_isempty(queue)) {
         printf("Number of calls to be answered: 0\n");
         return;
     }
 
     Call* first_call = (Call*)queue_front(queue); // Get the first call in the queue
-    printf("Number of calls to be answered: %d\n", queue_size(queue));
+    printf("Number of calls to be answered: %d\n",
+        queue_size(queue) - abandoned_waiting);
     printf("Details of the first call to be answered:\n");
     printf("Call ID: %d\n", first_call->id);
     printf("Caller’s name: %s\n", first_call->caller_name);
@@ -191,8 +740,568 @@ void display_queue(struct queue* queue) {
  */
 void clear_input_buffer() {
     int c;
-    while ((c = getchar()) != '\n') {}
+    while ((c = getchar()) != '\n' && c != EOF) {}
+}
+
+/*
+ * This function runs the multithreaded agent simulation instead of the
+ * interactive menu.  It is selected by passing options on the command line:
+ *
+ *   --agents=N           number of agent threads (required)
+ *   --dispatch=MODE      "shared" for one locked queue (default), "steal"
+ *                        for one work-stealing deque per agent, or "coro"
+ *                        for one coroutine per agent, all on one thread
+ *   --calls=N            number of calls to simulate (default 100000)
+ *   --work-ns=N          time spent handling each call (default 1000)
+ *   --arrival-ns=N       gap between call arrivals (default 0)
+ *   --metrics[=NAME]     publish counters in shared memory (default name
+ *                        /callcenter) for callcenter_stat to read
+ *
+ * Params:
+ *   argc, argv - the program's command line arguments.
+ *
+ * Return:
+ *   Returns the program's exit status.
+ */
+int run_simulation(int argc, char const *argv[]) {
+    struct sim_config cfg = { 0, 100000, DISPATCH_SHARED, 1000, 0, NULL };
+    const char* metrics_name = NULL;
+    struct sim_result res;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--agents=", 9) == 0) {
+            cfg.agents = atoi(argv[i] + 9);
+        } else if (strcmp(argv[i], "--dispatch=shared") == 0) {
+            cfg.mode = DISPATCH_SHARED;
+        } else if (strcmp(argv[i], "--dispatch=steal") == 0) {
+            cfg.mode = DISPATCH_STEAL;
+        } else if (strcmp(argv[i], "--dispatch=coro") == 0) {
+            cfg.mode = DISPATCH_CORO;
+        } else if (strncmp(argv[i], "--calls=", 8) == 0) {
+            cfg.calls = atoi(argv[i] + 8);
+        } else if (strncmp(argv[i], "--work-ns=", 10) == 0) {
+            cfg.work_ns = atoll(argv[i] + 10);
+        } else if (strncmp(argv[i], "--arrival-ns=", 13) == 0) {
+            cfg.arrival_ns = atoll(argv[i] + 13);
+        } else if (strcmp(argv[i], "--metrics") == 0) {
+            metrics_name = METRICS_NAME;
+        } else if (strncmp(argv[i], "--metrics=", 10) == 0) {
+            metrics_name = argv[i] + 10;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (cfg.agents <= 0 || cfg.calls <= 0) {
+        fprintf(stderr, "Usage: %s --agents=N [--dispatch=shared|steal|coro] "
+            "[--calls=N] [--work-ns=N] [--arrival-ns=N] [--metrics[=NAME]]\n",
+            argv[0]);
+        return 1;
+    }
+    if (metrics_name) {
+        cfg.metrics = metrics_create(metrics_name);
+        if (!cfg.metrics) {
+            fprintf(stderr, "Could not create metrics segment %s\n", metrics_name);
+        }
+    }
+
+    sim_run(&cfg, &res);
+    if (cfg.metrics) {
+        metrics_destroy(cfg.metrics, metrics_name);
+    }
+    printf("Dispatch mode: %s\n", sim_mode_name(cfg.mode));
+    printf("Agents: %d\n", cfg.agents);
+    printf("Calls answered: %d in %.3f s (%.0f calls/s)\n", cfg.calls,
+        res.elapsed_s, res.calls_per_s);
+    printf("Wait time: mean %.1f us, p99 %.1f us, max %.1f us\n",
+        res.mean_wait_us, res.p99_wait_us, res.max_wait_us);
+    printf("Fairness (Jain's index over agents): %.3f\n", res.fairness);
+    printf("Steals: %ld\n", res.steals);
+    if (cfg.mode == DISPATCH_CORO) {
+        printf("Simulated time: %.3f s (wait times above are simulated)\n",
+            res.simulated_s);
+        printf("Coroutine switches: %lld (%.1f ns each)\n", res.switches,
+            res.elapsed_s * 1e9 / res.switches);
+    }
+    return 0;
+}
+
+/*
+ * This function runs one process of a call center split across processes,
+ * connected by a ring of calls in shared memory (see shmring.c).  It is
+ * selected by passing options on the command line:
+ *
+ *   --role=intake        read calls from standard input and queue them
+ *   --role=agent         answer queued calls until intake finishes
+ *   --ring=NAME          shared-memory name of the ring (default
+ *                        /callcenter.ring)
+ *   --capacity=N         calls the ring can hold, for intake (default 1024)
+ *
+ * Intake must be started first, since it creates the ring.  Any number of
+ * agent processes can attach to it.
+ *
+ * Params:
+ *   argc, argv - the program's command line arguments.
+ *
+ * Return:
+ *   Returns the program's exit status.
+ */
+int run_role(int argc, char const *argv[]) {
+    const char* role = NULL;
+    const char* name = SHMRING_NAME;
+    int capacity = 1024;
+    int status;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--role=", 7) == 0) {
+            role = argv[i] + 7;
+        } else if (strncmp(argv[i], "--ring=", 7) == 0) {
+            name = argv[i] + 7;
+        } else if (strncmp(argv[i], "--capacity=", 11) == 0) {
+            capacity = atoi(argv[i] + 11);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (strcmp(role, "intake") == 0 && capacity > 0) {
+        struct shmring* ring = shmring_create(name, capacity);
+        if (!ring) {
+            fprintf(stderr, "Could not create call ring %s\n", name);
+            return 1;
+        }
+        status = run_intake(ring);
+        shmring_destroy(ring, name);
+    } else if (strcmp(role, "agent") == 0) {
+        struct shmring* ring = shmring_attach(name);
+        if (!ring) {
+            fprintf(stderr, "No call ring %s; start --role=intake first\n", name);
+            return 1;
+        }
+        status = run_agent(ring);
+        shmring_detach(ring);
+    } else {
+        fprintf(stderr, "Usage: %s --role=intake|agent [--ring=NAME] "
+            "[--capacity=N]\n", argv[0]);
+        return 1;
+    }
+    return status;
+}
+
+/*
+ * This function runs the intake process: it reads each caller's name and
+ * reason from standard input, like receive_call(), and queues the call in
+ * the ring, waiting if the ring is full.  At end of input it closes the
+ * ring so the agents finish once every call has been answered, and waits
+ * for agents to take the calls left in it before returning.
+ *
+ * Params:
+ *   ring - the ring to queue calls in. It may not be NULL.
+ *
+ * Return:
+ *   Returns the program's exit status.
+ */
+int run_intake(struct shmring* ring) {
+    Call call;
+    int received = 0;
+
+    for (;;) {
+        printf("Enter caller's name: ");
+        if (!fgets(call.caller_name, sizeof(call.caller_name), stdin)) {
+            break;
+        }
+        strtok(call.caller_name, "\n"); // Remove trailing newline
+
+        printf("Enter call reason: ");
+        if (!fgets(call.call_reason, sizeof(call.call_reason), stdin)) {
+            break;
+        }
+        strtok(call.call_reason, "\n"); // Remove trailing newline
+
+        call.id = ++received;
+        call.received_ns = now_ns();
+        shmring_enqueue(ring, &call, -1);
+        printf("The call has been successfully added to the queue!\n");
+    }
+
+    shmring_close(ring);
+    printf("\nIntake closed after %d calls.\n", received);
+    // Removing the ring now would lose the calls no agent has taken yet,
+    // along with the chance for an agent to attach and take them
+    int left = shmring_drain(ring, 0);
+    if (left > 0) {
+        printf("Waiting for agents to take the %d calls still in the ring...\n",
+            left);
+        fflush(stdout);
+        shmring_drain(ring, -1);
+    }
+    return 0;
+}
+
+/*
+ * This function runs an agent process: it answers calls from the ring, in
+ * the order intake queued them, and pushes each onto its own stack of
+ * answered calls, until intake closes the ring and it runs dry.
+ *
+ * Params:
+ *   ring - the ring to answer calls from. It may not be NULL.
+ *
+ * Return:
+ *   Returns the program's exit status.
+ */
+int run_agent(struct shmring* ring) {
+    struct istack* answered_calls = istack_create(0);
+    Call* call = malloc(sizeof(Call));
+
+    while (shmring_dequeue(ring, call, -1)) {
+        istack_push(answered_calls, &call->link);
+        printf("The following call has been answered and added to the stack!\n");
+        printf("Call ID: %d\n", call->id);
+        printf("Caller’s name: %s\n", call->caller_name);
+        printf("Call reason: %s\n", call->call_reason);
+        printf("Waited: %.1f us\n", (now_ns() - call->received_ns) / 1e3);
+        fflush(stdout);
+        call = malloc(sizeof(Call));
+    }
+
+    printf("Number of calls answered: %d\n", istack_size(answered_calls));
+    free(call);
+    istack_clear(answered_calls, dispose_answered, NULL);
+    istack_free(answered_calls);
+    return 0;
+}
+
+/*
+ * This function displays how many calls were received and answered per
+ * second over the last 1, 5 and 15 minutes, and what share of the answered
+ * calls were answered within the service-level target.
+ */
+void display_stats() {
+    const int minutes[] = { 1, 5, 15 };
+    struct winstats_window w;
+
+    for (int i = 0; i < 3; i++) {
+        winstats_window(stats, 60 * minutes[i], clock_ns(), &w);
+        printf("Last %2d min: received %.2f/s, answered %.2f/s", minutes[i],
+            w.received / w.seconds, w.answered / w.seconds);
+        if (w.answered > 0) {
+            printf(", %.1f%% within %d s\n", 100.0 * w.within / w.answered,
+                target_s);
+        } else {
+            printf(", none answered\n");
+        }
+    }
+}
+
+/*
+ * Eviction function for the answered stack: a call dropped from the history
+ * is removed from the indexes before it is freed.
+ */
+void forget_answered(struct ilink* link, void* ctx) {
+    Call* call = CALL_OF_LINK(link);
+    skiplist_remove(answered_by_id, call->id, call);
+    skiplist_remove(answered_by_time, call->answered_ns, call);
+    free(call);
+}
+
+/*
+ * Function used when quitting to free the calls still on the answered
+ * stack.
+ */
+void dispose_answered(struct ilink* link, void* ctx) {
+    free(CALL_OF_LINK(link));
+}
+
+/*
+ * This function prompts for a call ID and displays the answered call with
+ * that ID, if it is still in the history.
+ */
+void find_answered() {
+    int id = 0;
+
+    printf("Enter call ID: ");
+    scanf("%d", &id);
+    clear_input_buffer();
+
+    Call* call = (Call*)skiplist_find(answered_by_id, id);
+    if (!call) {
+        printf("No answered call with ID %d in the history.\n", id);
+        return;
+    }
+    printf("Call ID: %d\n", call->id);
+    printf("Caller’s name: %s\n", call->caller_name);
+    printf("Call reason: %s\n", call->call_reason);
+    printf("Answered %.1f s ago after waiting %.1f s\n",
+        (clock_ns() - call->answered_ns) / 1e9,
+        (call->answered_ns - call->received_ns) / 1e9);
+}
+
+/*
+ * This function prompts for a time range, in seconds before now, and lists
+ * the calls answered in it that are still in the history, oldest first.
+ */
+void list_answered() {
+    int from_s = 0, to_s = 0, n = 0;
+
+    printf("From how many seconds ago? ");
+    scanf("%d", &from_s);
+    clear_input_buffer();
+    printf("Until how many seconds ago? ");
+    scanf("%d", &to_s);
+    clear_input_buffer();
+
+    long long now = clock_ns();
+    long long end = now - to_s * 1000000000LL;
+    struct skipnode* node = skiplist_seek(answered_by_time,
+        now - from_s * 1000000000LL);
+    for (; node && skiplist_key(node) <= end; node = skiplist_next(node)) {
+        Call* call = (Call*)skiplist_value(node);
+        printf("%8.1f s ago  ID %d  %s: %s\n", (now - call->answered_ns) / 1e9,
+            call->id, call->caller_name, call->call_reason);
+        n++;
+    }
+    printf("%d calls answered in that range.\n", n);
+}
+
+/*
+ * This function displays the ten most frequent reasons given for calls
+ * received so far.  The counts come from a fixed number of counters (see
+ * topk.c): each is at most the number shown in brackets too high, and any
+ * reason given for more than one call in a thousand is sure to be listed.
+ */
+void display_top_reasons() {
+    struct topk_item top[10];
+    int n = topk_top(top_reasons, 10, top);
+
+    if (n == 0) {
+        printf("No calls have been received yet!\n");
+        return;
+    }
+    printf("Top call reasons out of %ld calls:\n", topk_total(top_reasons));
+    for (int i = 0; i < n; i++) {
+        printf("%2d. %-40s %8ld", i + 1, top[i].key, top[i].count);
+        if (top[i].error > 0) {
+            printf(" (-%ld)", top[i].error);
+        }
+        printf("\n");
+    }
+}
+
+/*
+ * This function estimates how the calls waiting now would fare if agents
+ * answered them at a given rate from now on, and prints the results.  The
+ * waiting calls are walked in order with queue_get() and the answered
+ * history from the top of the stack; both are only read, so the live queue
+ * and stack are left as they were.
+ *
+ * Params:
+ *   queue - the queue of waiting calls. It may not be NULL.
+ *   stack - the stack of answered calls. It may not be NULL.
+ *   agents - the number of agents, for the printout.
+ *   answers_per_s - the rate at which the agents answer calls between them.
+ */
+void what_if_run(struct queue* queue, struct istack* stack, int agents,
+        double answers_per_s) {
+    int size = queue_size(queue), next = 0;
+    char* in_target = malloc(size + 1);
+    int n = 0, within = 0;
+    double t = 0, total_wait = 0, max_wait = 0;
+    long long now = clock_ns();
+
+    while (next < size && t < WHAT_IF_HORIZON_S) {
+        Call* call = (Call*)queue_get(queue, next++);
+        if (call->abandoned) {
+            continue; // The caller has already hung up
+        }
+        t = (n + 1) / answers_per_s;
+        double wait = (now - call->received_ns) / 1e9 + t;
+        total_wait += wait;
+        if (wait > max_wait) {
+            max_wait = wait;
+        }
+        in_target[n] = wait <= target_s;
+        within += in_target[n];
+        n++;
+    }
+
+    // Service level over the most recent answers, the estimated ones first
+    int recent = n < WHAT_IF_RECENT ? n : WHAT_IF_RECENT;
+    int recent_within = 0;
+    for (int i = n - recent; i < n; i++) {
+        recent_within += in_target[i];
+    }
+    for (struct ilink* l = istack_top(stack); l && recent < WHAT_IF_RECENT;
+            l = istack_next(stack, l)) {
+        Call* call = CALL_OF_LINK(l);
+        if (call->answered_ns - call->received_ns <= target_s * 1000000000LL) {
+            recent_within++;
+        }
+        recent++;
+    }
+
+    printf("%3d agents: ", agents);
+    if (n == 0) {
+        printf("no calls waiting");
+    } else if (next < size) {
+        printf("%d calls still waiting after %d s", size - next,
+            WHAT_IF_HORIZON_S);
+    } else {
+        printf("all answered in %.0f s, wait mean %.0f s, max %.0f s, "
+            "%.1f%% within %d s", t, total_wait / n, max_wait,
+            100.0 * within / n, target_s);
+    }
+    if (recent > 0) {
+        printf("; last %d answers %.1f%% within %d s", recent,
+            100.0 * recent_within / recent, target_s);
+    }
+    printf("\n");
+    free(in_target);
+}
+
+/*
+ * This function prompts for the number of agents answering calls now and
+ * a number of agents to add, and estimates how the calls waiting now would
+ * fare either way.  Agents are assumed to keep answering at the rate they
+ * have over the last five minutes.
+ *
+ * Params:
+ *   queue - the queue of waiting calls. It may not be NULL.
+ *   stack - the stack of answered calls. It may not be NULL.
+ */
+void what_if(struct queue* queue, struct istack* stack) {
+    int agents = 0, extra = 0;
+    struct winstats_window w;
+
+    printf("How many agents are answering calls now? ");
+    scanf("%d", &agents);
+    clear_input_buffer();
+    printf("How many agents to add? ");
+    scanf("%d", &extra);
+    clear_input_buffer();
+
+    if (agents <= 0 || extra < 0) {
+        printf("Invalid number of agents.\n");
+        return;
+    }
+    winstats_window(stats, 300, clock_ns(), &w);
+    if (w.answered == 0) {
+        printf("No calls answered in the last 5 minutes to tell how fast "
+            "agents answer.\n");
+        return;
+    }
+    double per_agent = w.answered / w.seconds / agents;
+    printf("Each agent answers %.3f calls/s; %d calls waiting.\n", per_agent,
+        queue_size(queue) - abandoned_waiting);
+    what_if_run(queue, stack, agents, agents * per_agent);
+    what_if_run(queue, stack, agents + extra, (agents + extra) * per_agent);
 }
-  
 
+/*
+ * This function displays how much memory the queue holds for its own
+ * storage, how much of it is in use, and how much the calls held in the
+ * queue and the stack take on top of that.  The stack has no storage of
+ * its own, since answered calls link themselves into it.
+ *
+ * Params:
+ *   queue - the queue of waiting calls. It may not be NULL.
+ *   stack - the stack of answered calls. It may not be NULL.
+ */
+void display_memory(struct queue* queue, struct istack* stack) {
+    struct mem_stats m;
+
+    queue_mem_stats(queue, &m);
+    printf("Queue: %zu bytes reserved, %zu used, peak %zu, "
+        "%ld allocations, %ld frees\n", m.reserved, m.used, m.peak,
+        m.allocs, m.frees);
+    printf("       plus %d calls, %zu bytes\n", queue_size(queue),
+        queue_size(queue) * sizeof(Call));
+    printf("Stack: no storage of its own; each call embeds a %zu-byte link\n",
+        sizeof(struct ilink));
+    printf("       plus %d calls, %zu bytes\n", istack_size(stack),
+        istack_size(stack) * sizeof(Call));
+}
 
+/*
+ * This function replays a trace of call center events instead of running
+ * the interactive menu, then prints a summary.  Each event is a call coming
+ * in or an agent answering, at a time in milliseconds from the start of the
+ * trace; traces may be text or binary (see trace.c) and can be generated
+ * with tracegen.  The call center runs on the trace's clock, so timeouts,
+ * callbacks and admission control behave as they would have live.
+ *
+ * Params:
+ *   path - the trace file. It may not be NULL.
+ *   queue - the queue of waiting calls. It may not be NULL.
+ *   stack - the stack of answered calls. It may not be NULL.
+ *
+ * Return:
+ *   Returns the program's exit status.
+ */
+int run_replay(const char* path, struct queue* queue, struct istack* stack) {
+    struct trace_reader* trace = trace_reader_open(path);
+    struct trace_event ev;
+    long long last_ms = 0;
+    long received = 0, events = 0;
+    int max_waiting = 0, got;
+
+    if (!trace) {
+        fprintf(stderr, "Could not open trace %s\n", path);
+        return 1;
+    }
+
+    while ((got = trace_read(trace, &ev)) > 0) {
+        last_ms = ev.t_ms;
+        replay_clock = ev.t_ms * 1000000;
+        timerwheel_advance(wheel, current_tick());
+        events++;
+
+        if (ev.type == TRACE_CALL) {
+            Call* call = (Call*)malloc(sizeof(Call));
+            snprintf(call->caller_name, sizeof(call->caller_name), "%s", ev.name);
+            snprintf(call->call_reason, sizeof(call->call_reason), "%s", ev.reason);
+            received++;
+            admit_call(queue, call);
+        } else {
+            take_call(queue, stack);
+        }
+
+        if (queue_size(queue) - abandoned_waiting > max_waiting) {
+            max_waiting = queue_size(queue) - abandoned_waiting;
+        }
+    }
+    if (got < 0) {
+        fprintf(stderr, "%s: %s\n", path, trace_reader_error(trace));
+        trace_reader_close(trace);
+        return 1;
+    }
+    trace_reader_close(trace);
+
+    printf("Replayed %ld events from %s over %.3f s\n", events, path,
+        last_ms / 1e3);
+    printf("Calls received: %ld (from repeat callers: %ld)\n", received,
+        repeat_calls);
+    if (admission) {
+        printf("Admitted: %ld, diverted to callbacks: %ld, rejected: %ld\n",
+            admission_count(admission, ADMIT_ACCEPT),
+            admission_count(admission, ADMIT_CALLBACK),
+            admission_count(admission, ADMIT_REJECT));
+    }
+    printf("Calls answered: %d\n", total_answered);
+    printf("Calls still waiting: %d (most at once: %d)\n",
+        queue_size(queue) - abandoned_waiting, max_waiting);
+    if (n_answer_waits > 0) {
+        double sum = 0;
+        for (int i = 0; i < n_answer_waits; i++) {
+            sum += answer_waits[i];
+        }
+        qsort(answer_waits, n_answer_waits, sizeof(long long), cmp_ll);
+        printf("Wait time: mean %.1f ms, p50 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+            sum / n_answer_waits / 1e6, answer_waits[n_answer_waits / 2] / 1e6,
+            answer_waits[(long)(n_answer_waits * 0.99)] / 1e6,
+            answer_waits[n_answer_waits - 1] / 1e6);
+    }
+    display_stats(); // Windows ending at the last event in the trace
+    display_top_reasons();
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * This file contains a small monitoring tool that maps the metrics segment
+ * published by callcenter (run with --metrics) and prints, once per
+ * interval, the rate of each operation and the current size and high-water
+ * mark of each structure.  The queue size shown is enqueues minus dequeues,
+ * which stays exact even while several threads share the queue.  It never
+ * writes to the segment, so sampling has no effect on the call center
+ * beyond sharing cache lines for reading.
+ *
+ * Usage: ./callcenter_stat [NAME] [INTERVAL_MS] [SAMPLES]
+ *
+ * NAME defaults to /callcenter, INTERVAL_MS to 1000, and SAMPLES to 0,
+ * which means sample until the call center exits.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+
+#include "metrics.h"
+#include "timeutil.h"
+
+/*
+ * Totals of every per-thread counter at one instant.
+ */
+struct totals {
+  unsigned long long enqueues, dequeues, pushes, pops;
+  unsigned long long thread_ops[METRICS_MAX_THREADS];
+};
+
+/*
+ * Auxilliary function to add up the per-thread counters of a segment.
+ */
+static void _sample(const struct metrics* m, struct totals* t) {
+  int n = __atomic_load_n(&m->n_threads, __ATOMIC_RELAXED);
+  memset(t, 0, sizeof(struct totals));
+  for (int i = 0; i < n && i < METRICS_MAX_THREADS; i++) {
+    const struct metrics_thread* th = &m->threads[i];
+    unsigned long long enq = __atomic_load_n(&th->enqueues, __ATOMIC_RELAXED);
+    unsigned long long deq = __atomic_load_n(&th->dequeues, __ATOMIC_RELAXED);
+    unsigned long long push = __atomic_load_n(&th->pushes, __ATOMIC_RELAXED);
+    unsigned long long pop = __atomic_load_n(&th->pops, __ATOMIC_RELAXED);
+    t->enqueues += enq;
+    t->dequeues += deq;
+    t->pushes += push;
+    t->pops += pop;
+    t->thread_ops[i] = enq + deq + push + pop;
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* name = argc > 1 ? argv[1] : METRICS_NAME;
+  long interval_ms = argc > 2 ? atol(argv[2]) : 1000;
+  long samples = argc > 3 ? atol(argv[3]) : 0;
+
+  struct metrics* m = metrics_open(name);
+  if (!m || interval_ms <= 0) {
+    fprintf(stderr, "Usage: %s [NAME] [INTERVAL_MS] [SAMPLES]\n", argv[0]);
+    if (!m) {
+      fprintf(stderr, "No metrics segment named %s; is callcenter running "
+        "with --metrics?\n", name);
+    }
+    return 1;
+  }
+
+  struct totals prev, cur;
+  struct timespec gap = { interval_ms / 1000, (interval_ms % 1000) * 1000000 };
+  long long prev_ns = now_ns();
+  _sample(m, &prev);
+
+  printf("%8s %10s %10s %10s %10s %8s %8s %7s %8s %8s\n", "time_s", "enq/s",
+    "deq/s", "push/s", "pop/s", "q_size", "q_high", "q_resz", "s_size",
+    "s_high");
+  for (long i = 0; samples == 0 || i < samples; i++) {
+    nanosleep(&gap, NULL);
+    long long t_ns = now_ns();
+    _sample(m, &cur);
+    double dt = (t_ns - prev_ns) / 1e9;
+
+    printf("%8.1f %10.0f %10.0f %10.0f %10.0f %8lld %8lld %7lld %8lld %8lld\n",
+      (t_ns - m->start_ns) / 1e9,
+      (cur.enqueues - prev.enqueues) / dt, (cur.dequeues - prev.dequeues) / dt,
+      (cur.pushes - prev.pushes) / dt, (cur.pops - prev.pops) / dt,
+      (long long)(cur.enqueues - cur.dequeues),
+      __atomic_load_n(&m->queue.high_water, __ATOMIC_RELAXED),
+      __atomic_load_n(&m->queue.resizes, __ATOMIC_RELAXED),
+      __atomic_load_n(&m->stack.size, __ATOMIC_RELAXED),
+      __atomic_load_n(&m->stack.high_water, __ATOMIC_RELAXED));
+
+    // With more than one thread, also show how the work is spread
+    int n = __atomic_load_n(&m->n_threads, __ATOMIC_RELAXED);
+    if (n > 1) {
+      printf("%8s", "ops/s:");
+      for (int j = 0; j < n && j < METRICS_MAX_THREADS; j++) {
+        printf(" t%d=%.0f", j, (cur.thread_ops[j] - prev.thread_ops[j]) / dt);
+      }
+      printf("\n");
+    }
+    fflush(stdout);
+
+    prev = cur;
+    prev_ns = t_ns;
+    if (kill(m->pid, 0) < 0 && errno == ESRCH) {
+      break; // The call center has exited; these were its final counts
+    }
+  }
+
+  metrics_close(m);
+  return 0;
+}
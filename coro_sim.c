@@ -0,0 +1,291 @@
+/*
+ * This file contains a simulation of a call center in which every agent is
+ * a stackless coroutine, so one thread can run hundreds of thousands of
+ * agents.  See the documentation below for more information on the
+ * individual functions in this implementation.
+ *
+ * An agent is a small state machine that runs the same loop as an agent
+ * thread in agent_sim.c: dequeue a call, handle it for the simulated
+ * handling time, push it onto the answered stack.  Each time it would block
+ * it records where to carry on and returns to the scheduler instead:
+ *
+ *   - With no call waiting, it parks on the queue of idle agents, and the
+ *     next call to arrive moves it to the run queue.
+ *   - While handling a call, it sleeps on a timer in a timing wheel, which
+ *     moves it to the run queue when the handling time is up.
+ *
+ * The scheduler resumes agents from the run queue, a plain `struct queue`,
+ * in FIFO order.  Time is simulated, in ticks of CORO_TICK_NS: when nothing
+ * is runnable, the wheel is advanced straight to the next tick on which a
+ * timer may expire (see timerwheel_next_expiry()), so idle stretches cost
+ * at most one advance per rotation of the wheel rather than one per tick.
+ * Wait times are in simulated time, while the reported throughput is how
+ * fast the simulator really ran.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "agent_sim.h"
+#include "call.h"
+#include "coro_sim.h"
+#include "queue.h"
+#include "stack.h"
+#include "timerwheel.h"
+#include "timeutil.h"
+
+/*
+ * Where an agent carries on from when it is next resumed.
+ */
+enum agent_state {
+  AGENT_FIND_CALL,   // Looking for the next call
+  AGENT_CALL_DONE    // Finished handling `call`
+};
+
+/*
+ * This structure is used to represent the whole state of one agent
+ * coroutine.  There is no stack: `state` and `call` are everything the
+ * agent needs to carry on.
+ */
+struct cagent {
+  enum agent_state state;
+  Call* call;
+  long handled;
+  struct timer timer;
+  struct csim* sim;
+};
+
+/*
+ * This structure is used to represent the state of one simulation run.
+ */
+struct csim {
+  const struct sim_config* cfg;
+  struct queue* run;        // Agents ready to be resumed
+  struct queue* idle;       // Agents parked until a call arrives
+  struct queue* calls;      // Calls waiting to be answered
+  struct stack* answered;
+  struct timerwheel* wheel;
+  unsigned long long now;   // Current tick
+  long long work_ticks;
+  long long* wait_ticks;    // Indexed by call ID - 1
+  int generated;
+  long answered_count;
+  struct timer arrivals;
+};
+
+/*
+ * This function returns the memory each agent takes beyond the calls it
+ * handles: its coroutine state plus its slot in the run or idle queue.
+ */
+int coro_agent_size() {
+  return sizeof(struct cagent) + sizeof(void*);
+}
+
+/*
+ * Auxilliary function to add a call to the queue, waking an idle agent if
+ * there is one.
+ */
+static void _arrive(struct csim* sim) {
+  Call* call = malloc(sizeof(Call));
+  assert(call);
+  call->id = ++sim->generated;
+  snprintf(call->caller_name, sizeof(call->caller_name), "caller%d", call->id);
+  strcpy(call->call_reason, "simulated");
+  call->received_ns = (long long)sim->now; // In ticks
+  queue_enqueue(sim->calls, call);
+
+  if (!queue_isempty(sim->idle)) {
+    queue_enqueue(sim->run, queue_dequeue(sim->idle));
+  }
+}
+
+/*
+ * Timer function for the arrival of calls: adds every call due by the
+ * current tick and, if more are to come, fires again on the tick the next
+ * one is due.  Call k, counting from 0, is due at k * arrival_ns.
+ */
+static void _arrivals_due(struct timer* t, void* ctx) {
+  struct csim* sim = ctx;
+  long long due = (long long)(sim->now * CORO_TICK_NS) / sim->cfg->arrival_ns + 1;
+  while (sim->generated < due && sim->generated < sim->cfg->calls) {
+    _arrive(sim);
+  }
+  if (sim->generated < sim->cfg->calls) {
+    long long next_ns = sim->generated * sim->cfg->arrival_ns;
+    timerwheel_schedule(sim->wheel, t,
+      (next_ns + CORO_TICK_NS - 1) / CORO_TICK_NS);
+  }
+}
+
+/*
+ * Timer function for an agent whose handling time is up.
+ */
+static void _agent_wake(struct timer* t, void* ctx) {
+  struct cagent* agent = ctx;
+  queue_enqueue(agent->sim->run, agent);
+}
+
+/*
+ * Auxilliary function to resume an agent until it next has to wait.
+ */
+static void _resume(struct cagent* agent) {
+  struct csim* sim = agent->sim;
+
+  for (;;) {
+    switch (agent->state) {
+      case AGENT_FIND_CALL:
+        if (queue_isempty(sim->calls)) {
+          queue_enqueue(sim->idle, agent); // Park until a call arrives
+          return;
+        }
+        agent->call = queue_dequeue(sim->calls);
+        sim->wait_ticks[agent->call->id - 1] =
+          (long long)sim->now - agent->call->received_ns;
+        agent->state = AGENT_CALL_DONE;
+        if (sim->work_ticks > 0) {
+          timerwheel_schedule(sim->wheel, &agent->timer,
+            sim->now + sim->work_ticks);
+        } else {
+          queue_enqueue(sim->run, agent); // Just yield to the other agents
+        }
+        return;
+
+      case AGENT_CALL_DONE:
+        stack_push(sim->answered, agent->call);
+        agent->call = NULL;
+        agent->handled++;
+        sim->answered_count++;
+        agent->state = AGENT_FIND_CALL;
+        break;
+    }
+  }
+}
+
+/*
+ * This function runs one simulation with every agent a coroutine on the
+ * calling thread, and reports its results.  Handling times are rounded to
+ * whole ticks of CORO_TICK_NS; with a handling time of 0 each agent just
+ * yields to the others between dequeuing a call and answering it.  With an
+ * arrival gap of 0 every call is waiting at the start.
+ *
+ * Wait times are in simulated time.  `res->switches` counts the times an
+ * agent was resumed, `res->simulated_s` is the simulated time taken, and
+ * `res->answered` counts the calls on the answered stack.  Every call must
+ * be answered exactly once; a call answered twice fails an assertion.
+ *
+ * Params:
+ *   cfg - the simulation parameters.  `cfg->mode` and `cfg->metrics` are
+ *     ignored.  May not be NULL.
+ *   res - filled in with the results of the run.  May not be NULL.
+ */
+void coro_sim_run(const struct sim_config* cfg, struct sim_result* res) {
+  assert(cfg && res && cfg->agents > 0 && cfg->calls > 0);
+
+  struct csim sim;
+  sim.cfg = cfg;
+  sim.run = queue_create();
+  sim.idle = queue_create();
+  sim.calls = queue_create();
+  sim.answered = stack_create();
+  sim.wheel = timerwheel_create(0);
+  sim.now = 0;
+  sim.work_ticks = (cfg->work_ns + CORO_TICK_NS / 2) / CORO_TICK_NS;
+  sim.wait_ticks = calloc(cfg->calls, sizeof(long long));
+  sim.generated = 0;
+  sim.answered_count = 0;
+  struct cagent* agents = calloc(cfg->agents, sizeof(struct cagent));
+  assert(sim.wait_ticks && agents);
+
+  long long start = now_ns();
+  queue_reserve(sim.run, cfg->agents);
+  for (int i = 0; i < cfg->agents; i++) {
+    agents[i].state = AGENT_FIND_CALL;
+    agents[i].sim = &sim;
+    timer_init(&agents[i].timer, _agent_wake, &agents[i]);
+    queue_enqueue(sim.run, &agents[i]);
+  }
+  timer_init(&sim.arrivals, _arrivals_due, &sim);
+  if (cfg->arrival_ns > 0) {
+    _arrivals_due(&sim.arrivals, &sim); // The first call arrives at tick 0
+  } else {
+    while (sim.generated < cfg->calls) {
+      _arrive(&sim);
+    }
+  }
+
+  /*
+   * Resume whoever is runnable; when nobody is, move time on to the next
+   * wake-ups.  Someone is always about to wake: an arrival is due or an
+   * agent is handling a call.
+   */
+  long long switches = 0;
+  while (sim.answered_count < cfg->calls) {
+    while (!queue_isempty(sim.run)) {
+      _resume(queue_dequeue(sim.run));
+      switches++;
+    }
+    if (sim.answered_count < cfg->calls) {
+      sim.now = timerwheel_next_expiry(sim.wheel);
+      timerwheel_advance(sim.wheel, sim.now);
+    }
+  }
+  long long elapsed = now_ns() - start;
+
+  /*
+   * Summarize wait times and how evenly the calls were spread over agents.
+   */
+  double sum = 0, sum_sq = 0, wait_sum = 0;
+  for (int i = 0; i < cfg->agents; i++) {
+    sum += agents[i].handled;
+    sum_sq += (double)agents[i].handled * agents[i].handled;
+  }
+  for (int i = 0; i < cfg->calls; i++) {
+    wait_sum += sim.wait_ticks[i];
+  }
+  qsort(sim.wait_ticks, cfg->calls, sizeof(long long), cmp_ll);
+
+  double tick_us = CORO_TICK_NS / 1e3;
+  res->elapsed_s = elapsed / 1e9;
+  res->calls_per_s = cfg->calls / res->elapsed_s;
+  res->mean_wait_us = wait_sum / cfg->calls * tick_us;
+  res->p99_wait_us = sim.wait_ticks[(long)(cfg->calls * 0.99)] * tick_us;
+  res->max_wait_us = sim.wait_ticks[cfg->calls - 1] * tick_us;
+  res->fairness = sum_sq > 0 ? sum * sum / (cfg->agents * sum_sq) : 1.0;
+  res->steals = 0;
+  res->switches = switches;
+  res->simulated_s = sim.now * (CORO_TICK_NS / 1e9);
+
+  /*
+   * Free the answered calls.  A call answered twice is a bug in the
+   * simulation, so it fails here rather than being freed twice.
+   */
+  char* seen = calloc(cfg->calls, 1);
+  assert(seen);
+  res->answered = 0;
+  for (Call* call; (call = stack_pop(sim.answered));) {
+    assert(!seen[call->id - 1]);
+    seen[call->id - 1] = 1;
+    res->answered++;
+    free(call);
+  }
+  assert(res->answered == cfg->calls);
+  free(seen);
+
+  /*
+   * queue_free() frees the values left in a queue, and the agents belong
+   * to `agents`, so empty the idle queue first.  The run queue and the
+   * call queue are already empty.
+   */
+  while (!queue_isempty(sim.idle)) {
+    queue_dequeue(sim.idle);
+  }
+  queue_free(sim.idle);
+  queue_free(sim.run);
+  queue_free(sim.calls);
+  stack_free(sim.answered);
+  timerwheel_free(sim.wheel);
+  free(sim.wait_ticks);
+  free(agents);
+}
@@ -0,0 +1,18 @@
+/*
+ * This file contains the definition of the interface for the single-thread
+ * agent simulation, in which every agent is a coroutine.  You can find
+ * descriptions of the simulation functions, including their parameters and
+ * their return values, in coro_sim.c.
+ */
+
+#ifndef __CORO_SIM_H
+#define __CORO_SIM_H
+
+#include "agent_sim.h"
+
+#define CORO_TICK_NS 1000 // Simulated time per tick of the timing wheel
+
+void coro_sim_run(const struct sim_config* cfg, struct sim_result* res);
+int coro_agent_size();
+
+#endif
@@ -4,10 +4,16 @@
  * this implementation.
  */
 
+#if defined(DYNARRAY_HUGEPAGES) && defined(__linux__)
+#define _DEFAULT_SOURCE
+#include <sys/mman.h>
+#endif
+
 #include <stdlib.h>
 #include <assert.h>
 
 #include "dynarray.h"
+#include "memacct.h"
 
 /*
  * This structure is used to represent a single dynamic array.
@@ -17,23 +23,77 @@ struct dynarray {
   int size;
   int capacity;
   int start; //Track the logical start of the circular buffer
+  int min_capacity; //The array never shrinks below this (see dynarray_reserve)
+  struct memacct* mem; //Where allocations are made and counted, or NULL
 };
 
 #define DYNARRAY_INIT_CAPACITY 4
 
+/*
+ * When built with -DDYNARRAY_HUGEPAGES on Linux, storage arrays of at least
+ * this many bytes are mapped directly and marked as eligible for transparent
+ * huge pages, which cuts TLB misses when a very large queue is walked.
+ */
+#define DYNARRAY_HUGEPAGE_MIN (2 * 1024 * 1024)
+
+/*
+ * Auxilliary functions to allocate and free a storage array able to hold
+ * `capacity` elements.  Huge-page mappings bypass a custom allocator, but
+ * are still counted.
+ */
+static void** _dynarray_alloc(struct dynarray* da, int capacity) {
+  size_t bytes = (size_t)capacity * sizeof(void*);
+#if defined(DYNARRAY_HUGEPAGES) && defined(__linux__)
+  if (bytes >= DYNARRAY_HUGEPAGE_MIN) {
+    void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(p != MAP_FAILED);
+    madvise(p, bytes, MADV_HUGEPAGE);
+    memacct_count(da->mem, bytes);
+    return p;
+  }
+#endif
+  return memacct_alloc(da->mem, bytes);
+}
+
+static void _dynarray_release(struct dynarray* da, void** data, int capacity) {
+  size_t bytes = (size_t)capacity * sizeof(void*);
+#if defined(DYNARRAY_HUGEPAGES) && defined(__linux__)
+  if (bytes >= DYNARRAY_HUGEPAGE_MIN) {
+    munmap(data, bytes);
+    memacct_count(da->mem, -(long long)bytes);
+    return;
+  }
+#endif
+  memacct_free(da->mem, data, bytes);
+}
+
 /*
  * This function allocates and initializes a new, empty dynamic array and
  * returns a pointer to it.
  */
 struct dynarray* dynarray_create() {
-  struct dynarray* da = malloc(sizeof(struct dynarray));
-  assert(da);
+  return dynarray_create_with(NULL);
+}
+
+/*
+ * This function allocates and initializes a new, empty dynamic array that
+ * gets its memory through, and counts it in, the given accounting state
+ * (see memacct.c).  The array and its storage are allocated there.
+ *
+ * Params:
+ *   mem - the accounting state of the container the array belongs to.  It
+ *     must outlive the array.  May be NULL to use malloc() and free().
+ */
+struct dynarray* dynarray_create_with(struct memacct* mem) {
+  struct dynarray* da = memacct_alloc(mem, sizeof(struct dynarray));
+  da->mem = mem;
 
-  da->data = malloc(DYNARRAY_INIT_CAPACITY * sizeof(void*));
-  assert(da->data);
+  da->data = _dynarray_alloc(da, DYNARRAY_INIT_CAPACITY);
   da->size = 0;
   da->capacity = DYNARRAY_INIT_CAPACITY;
   da->start = 0;
+  da->min_capacity = DYNARRAY_INIT_CAPACITY;
 
   return da;
 }
@@ -48,8 +108,23 @@ struct dynarray* dynarray_create() {
  */
 void dynarray_free(struct dynarray* da) {
   assert(da);
-  free(da->data);
-  free(da);
+  _dynarray_release(da, da->data, da->capacity);
+  memacct_free(da->mem, da, sizeof(struct dynarray));
+}
+
+/*
+ * This function changes the accounting state a dynamic array allocates and
+ * frees through from now on.  The memory it already holds is not counted
+ * over; see memacct_move().
+ *
+ * Params:
+ *   da - the dynamic array.  May not be NULL.
+ *   mem - the new accounting state, with the same allocator as the old one.
+ *     It must outlive the array.
+ */
+void dynarray_set_mem(struct dynarray* da, struct memacct* mem) {
+  assert(da);
+  da->mem = mem;
 }
 
 /*
@@ -61,10 +136,19 @@ int dynarray_size(struct dynarray* da) {
   return da->size;
 }
 
+/*
+ * This function returns the capacity of a given dynamic array (i.e. the
+ * number of elements it can hold before its storage must be resized).
+ */
+int dynarray_capacity(struct dynarray* da) {
+  assert(da);
+  return da->capacity;
+}
+
 
 /*
  * Auxilliary function to perform a resize on a dynamic array's underlying
- * storage array.
+ * storage array.  This is used both to grow and to shrink the array.
  */
 void _dynarray_resize(struct dynarray* da, int new_capacity) {
   assert(new_capacity > da->size);
@@ -72,8 +156,7 @@ void _dynarray_resize(struct dynarray* da, int new_capacity) {
   /*
    * Allocate space for the new array.
    */
-  void** new_data = malloc(new_capacity * sizeof(void*));
-  assert(new_data);
+  void** new_data = _dynarray_alloc(da, new_capacity);
 
   /*
    * Copy data from the old array to the new one.
@@ -86,12 +169,32 @@ void _dynarray_resize(struct dynarray* da, int new_capacity) {
   /*
    * Put the new array into the dynarray struct.
    */
-  free(da->data);
+  _dynarray_release(da, da->data, da->capacity);
   da->data = new_data;
   da->capacity = new_capacity;
   da->start = 0;
 }
 
+/*
+ * This function makes sure a dynamic array can hold at least `capacity`
+ * elements without resizing, and keeps it from shrinking below that
+ * capacity afterwards.  Use it to pre-size an array for a known peak.
+ *
+ * Params:
+ *   da - the dynamic array to reserve space in.  May not be NULL.
+ *   capacity - the number of elements to reserve space for.
+ */
+void dynarray_reserve(struct dynarray* da, int capacity) {
+  assert(da && capacity >= 0);
+  if (capacity < DYNARRAY_INIT_CAPACITY) {
+    capacity = DYNARRAY_INIT_CAPACITY;
+  }
+  if (capacity > da->capacity) {
+    _dynarray_resize(da, capacity);
+  }
+  da->min_capacity = capacity;
+}
+
 /*
  * This function inserts a new value to a given dynamic array.  The new element
  * is always inserted at the *end* of the array.
@@ -169,6 +272,7 @@ void dynarray_set(struct dynarray* da, int idx, void* val) {
  *   Returns the value at the logical start of the array.
  */
 void* dynarray_get_front(struct dynarray* da) {
+    assert(da && da->size > 0);
     int front_index = da->start;
     return da->data[front_index];
 }
@@ -183,6 +287,20 @@ void* dynarray_get_front(struct dynarray* da) {
  *     
  */
 void dynarray_remove_front(struct dynarray* da) {
-    da->start = (da->start + 1) ;  // start + 1 
+    assert(da && da->size > 0);
+    da->start = (da->start + 1) % da->capacity;  // start + 1, wrapping around
     da->size--;  
+
+    /*
+     * Halve the storage once it is less than a quarter full.  Growing at full
+     * and shrinking at a quarter leaves the array half full after either
+     * resize, so alternating inserts and removes can't make it thrash.
+     */
+    if (da->size < da->capacity / 4 && da->capacity > da->min_capacity) {
+        int new_capacity = da->capacity / 2;
+        if (new_capacity < da->min_capacity) {
+            new_capacity = da->min_capacity;
+        }
+        _dynarray_resize(da, new_capacity);
+    }
 }
@@ -13,14 +13,19 @@
  * here.  In other words, you can't define the fields of the struct here.
  */
 struct dynarray;
+struct memacct;
 
 /*
  * Dynamic array interface function prototypes.  Refer to dynarray.c for
  * documentation about each of these functions.
  */
 struct dynarray* dynarray_create();
+struct dynarray* dynarray_create_with(struct memacct* mem);
 void dynarray_free(struct dynarray* da);
+void dynarray_set_mem(struct dynarray* da, struct memacct* mem);
 int dynarray_size(struct dynarray* da);
+int dynarray_capacity(struct dynarray* da);
+void dynarray_reserve(struct dynarray* da, int capacity);
 void dynarray_insert(struct dynarray* da, void* val);
 //void dynarray_remove(struct dynarray* da, int idx);  //dynarray_remove_front is used
 void* dynarray_get(struct dynarray* da, int idx);
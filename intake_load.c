@@ -0,0 +1,197 @@
+/*
+ * This file contains a load generator for the call center's intake server
+ * (callcenter --listen).  It opens many connections, each standing in for
+ * one IVR line, and on each one submits calls back to back, waiting for
+ * every call to be accepted before submitting the next.  Every few calls
+ * it also asks where its last call is in the queue.  At the end it reports
+ * sustained calls per second and the latency from sending a call to
+ * having it accepted.
+ *
+ * Usage: ./intake_load [PATH] [CONNECTIONS] [CALLS_PER_CONNECTION]
+ *                      [STATUS_EVERY]
+ *
+ * The defaults are /tmp/callcenter.sock, 1000 connections, 100 calls per
+ * connection, and a status query after every 10th call (0 for none).
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "intake_proto.h"
+#include "timeutil.h"
+
+/*
+ * State of one client connection.
+ */
+struct client {
+  int fd;
+  int index;
+  int submitted;          // Calls accepted so far
+  int last_id;
+  long long sent_ns;      // When the outstanding submission was sent
+  char in[64];
+  int in_len;
+};
+
+int calls_per_conn;
+int status_every;
+long long* latency;
+long n_latency = 0;
+long turned_away = 0;
+long status_replies = 0;
+
+/*
+ * Sends one frame in full; the requests are tiny and only one is ever
+ * outstanding per connection, so a short write means something is wrong.
+ */
+void send_frame(struct client* c, int type, const void* payload, int len) {
+  char buf[sizeof(struct intake_frame) + sizeof(struct intake_submit)];
+  struct intake_frame hdr = { (uint16_t)type, (uint16_t)len };
+  memcpy(buf, &hdr, sizeof(hdr));
+  memcpy(buf + sizeof(hdr), payload, len);
+  if (send(c->fd, buf, sizeof(hdr) + len, MSG_NOSIGNAL) !=
+      (ssize_t)(sizeof(hdr) + len)) {
+    perror("send");
+    exit(1);
+  }
+}
+
+void submit(struct client* c) {
+  struct intake_submit sub;
+  memset(&sub, 0, sizeof(sub));
+  snprintf(sub.caller_name, sizeof(sub.caller_name), "line%d", c->index);
+  snprintf(sub.call_reason, sizeof(sub.call_reason), "load test");
+  c->sent_ns = now_ns();
+  send_frame(c, INTAKE_SUBMIT, &sub, sizeof(sub));
+}
+
+/*
+ * Handles one reply and sends the connection's next request.  Returns 1
+ * when the connection is finished.
+ */
+int handle(struct client* c, const struct intake_frame* hdr, const char* p) {
+  if (hdr->type == INTAKE_ACCEPTED) {
+    struct intake_accepted acc;
+    memcpy(&acc, p, sizeof(acc));
+    latency[n_latency++] = now_ns() - c->sent_ns;
+    c->last_id = acc.id;
+    turned_away += acc.position == 0;
+    c->submitted++;
+    if (status_every > 0 && c->submitted % status_every == 0) {
+      struct intake_status st = { c->last_id };
+      send_frame(c, INTAKE_STATUS, &st, sizeof(st));
+      return 0;
+    }
+  } else if (hdr->type == INTAKE_STATUS_REPLY) {
+    status_replies++;
+  } else {
+    fprintf(stderr, "Unexpected reply type %d\n", hdr->type);
+    exit(1);
+  }
+
+  if (c->submitted == calls_per_conn) {
+    return 1;
+  }
+  submit(c);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  const char* path = argc > 1 ? argv[1] : INTAKE_PATH;
+  int conns = argc > 2 ? atoi(argv[2]) : 1000;
+  calls_per_conn = argc > 3 ? atoi(argv[3]) : 100;
+  status_every = argc > 4 ? atoi(argv[4]) : 10;
+  if (conns <= 0 || calls_per_conn <= 0) {
+    fprintf(stderr, "Usage: %s [PATH] [CONNECTIONS] [CALLS_PER_CONNECTION] "
+      "[STATUS_EVERY]\n", argv[0]);
+    return 1;
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+  latency = malloc((long)conns * calls_per_conn * sizeof(long long));
+  struct client* clients = calloc(conns, sizeof(struct client));
+  int epfd = epoll_create1(0);
+  if (!latency || !clients || epfd < 0) {
+    return 1;
+  }
+
+  for (int i = 0; i < conns; i++) {
+    struct client* c = &clients[i];
+    c->index = i;
+    c->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (c->fd < 0 || connect(c->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+      fprintf(stderr, "Connection %d to %s failed: %s\n", i, path,
+        strerror(errno));
+      return 1;
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, c->fd, &ev);
+  }
+
+  long long start = now_ns();
+  for (int i = 0; i < conns; i++) {
+    submit(&clients[i]);
+  }
+
+  int open = conns;
+  struct epoll_event events[256];
+  while (open > 0) {
+    int n = epoll_wait(epfd, events, 256, -1);
+    for (int i = 0; i < n; i++) {
+      struct client* c = events[i].data.ptr;
+      ssize_t got = read(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len);
+      if (got <= 0) {
+        fprintf(stderr, "Server closed connection %d\n", c->index);
+        return 1;
+      }
+      c->in_len += got;
+
+      int off = 0, done = 0;
+      struct intake_frame hdr;
+      while (c->in_len - off >= (int)sizeof(hdr)) {
+        memcpy(&hdr, c->in + off, sizeof(hdr));
+        if (c->in_len - off < (int)sizeof(hdr) + hdr.len) {
+          break;
+        }
+        done = handle(c, &hdr, c->in + off + sizeof(hdr));
+        off += sizeof(hdr) + hdr.len;
+      }
+      memmove(c->in, c->in + off, c->in_len - off);
+      c->in_len -= off;
+      if (done) {
+        close(c->fd);
+        open--;
+      }
+    }
+  }
+  long long elapsed = now_ns() - start;
+
+  qsort(latency, n_latency, sizeof(long long), cmp_ll);
+  printf("Connections: %d\n", conns);
+  printf("Calls accepted: %ld in %.3f s (%.0f calls/s)\n", n_latency,
+    elapsed / 1e9, n_latency / (elapsed / 1e9));
+  printf("Calls turned away by admission control: %ld\n", turned_away);
+  printf("Status queries answered: %ld\n", status_replies);
+  printf("Intake latency: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+    latency[n_latency / 2] / 1e3, latency[(long)(n_latency * 0.99)] / 1e3,
+    latency[n_latency - 1] / 1e3);
+
+  free(latency);
+  free(clients);
+  close(epfd);
+  return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * This file contains the definition of the framed protocol spoken over the
+ * call center's Unix-domain intake socket (see intake_server.c).  Every
+ * message is a frame header followed by a fixed-size payload whose size
+ * the header repeats; both ends are on the same machine, so integers are
+ * in host byte order.
+ *
+ * A client sends INTAKE_SUBMIT to queue a call and gets INTAKE_ACCEPTED
+ * back with the call's ID and its position in the queue, or with both 0 if
+ * admission control kept the call out of the queue.  It sends
+ * INTAKE_STATUS to ask how many calls are waiting and, if `id` is nonzero,
+ * where that call now is, and gets INTAKE_STATUS_REPLY back.  Replies come
+ * in the order the requests were sent.
+ */
+
+#ifndef __INTAKE_PROTO_H
+#define __INTAKE_PROTO_H
+
+#include <stdint.h>
+
+#define INTAKE_PATH "/tmp/callcenter.sock" // Default socket path
+
+/*
+ * Message types.
+ */
+enum intake_type {
+  INTAKE_SUBMIT = 1,
+  INTAKE_ACCEPTED,
+  INTAKE_STATUS,
+  INTAKE_STATUS_REPLY
+};
+
+/*
+ * Header at the start of every frame.  `len` is the size of the payload
+ * that follows.
+ */
+struct intake_frame {
+  uint16_t type;
+  uint16_t len;
+};
+
+struct intake_submit {
+  char caller_name[30];
+  char call_reason[100];
+};
+
+struct intake_accepted {
+  int32_t id;
+  int32_t position;   // 1 for the front of the queue, 0 if not queued
+};
+
+struct intake_status {
+  int32_t id;         // Call to locate, or 0 for just the queue size
+};
+
+struct intake_status_reply {
+  int32_t id;
+  int32_t position;   // 0 if the call isn't waiting any more
+  int32_t waiting;    // Calls in the queue
+};
+
+#endif
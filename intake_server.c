@@ -0,0 +1,523 @@
+/*
+ * This file contains an implementation of the call center's intake server.
+ * It listens on a Unix-domain socket and serves any number of clients from
+ * a single thread with a nonblocking epoll event loop, speaking the framed
+ * protocol in intake_proto.h.
+ *
+ * Each turn of the loop reads everything the ready clients have sent and
+ * parses it into requests, then handles all of those requests together,
+ * so each client gets all its replies for the turn in one write.  Requests
+ * are handled in the order they arrived, so replies on a connection are
+ * never reordered.
+ *
+ * The server only runs when intake_server_run() is called, so the owner of
+ * the queue decides when it is safe to touch it.  epoll is Linux-only; on
+ * other systems intake_server_create() always fails.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "intake_proto.h"
+#include "intake_server.h"
+
+/*
+ * This function returns the position of a call in the queue, counting the
+ * front as 1.  It relies on IDs increasing from the front of the queue to
+ * the back, which intake_enqueue_fn guarantees, and binary searches them.
+ *
+ * Params:
+ *   queue - the queue of waiting calls.  May not be NULL.
+ *   id - the ID of the call to find.
+ *
+ * Return:
+ *   Returns the call's position, or 0 if it isn't in the queue.
+ */
+int intake_position(struct queue* queue, int id) {
+  int lo = 0, hi = queue_size(queue) - 1;
+  while (lo <= hi) {
+    int mid = lo + (hi - lo) / 2;
+    int mid_id = ((Call*)queue_get(queue, mid))->id;
+    if (mid_id == id) {
+      return mid + 1;
+    } else if (mid_id < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return 0;
+}
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define INTAKE_MAX_EVENTS 256
+#define INTAKE_INBUF 4096
+
+/*
+ * This structure is used to represent one client connection.  Connections
+ * with replies to send or waiting to be closed are linked through
+ * `next_dirty` until the end of the turn.
+ */
+struct conn {
+  int fd;
+  char in[INTAKE_INBUF];
+  int in_len;
+  char* out;
+  int out_len;
+  int out_cap;
+  int want_out;           // Registered for EPOLLOUT
+  int closing;
+  int dirty;
+  struct conn* next_dirty;
+  struct conn* prev;
+  struct conn* next;
+};
+
+/*
+ * This structure is used to represent one parsed request, waiting to be
+ * handled at the end of the turn.
+ */
+struct request {
+  struct conn* conn;
+  int type;
+  Call* call;             // For INTAKE_SUBMIT
+  int32_t id;             // For INTAKE_STATUS
+};
+
+/*
+ * This structure is used to represent an intake server.
+ */
+struct intake_server {
+  int listen_fd;
+  int epoll_fd;
+  char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+  struct queue* queue;
+  intake_enqueue_fn enqueue;
+  struct request* pending;
+  int n_pending;
+  int cap_pending;
+  struct conn* dirty;
+  struct conn* conns;
+  int connections;
+  long accepted;
+};
+
+/*
+ * Auxilliary function to put a connection on the list of those to visit
+ * at the end of the turn.
+ */
+static void _mark_dirty(struct intake_server* srv, struct conn* c) {
+  if (!c->dirty) {
+    c->dirty = 1;
+    c->next_dirty = srv->dirty;
+    srv->dirty = c;
+  }
+}
+
+/*
+ * Auxilliary function to queue a reply frame on a connection.
+ */
+static void _reply(struct intake_server* srv, struct conn* c, int type,
+    const void* payload, int len) {
+  int need = c->out_len + (int)sizeof(struct intake_frame) + len;
+  if (need > c->out_cap) {
+    c->out_cap = need > 2 * c->out_cap ? need : 2 * c->out_cap;
+    c->out = realloc(c->out, c->out_cap);
+    assert(c->out);
+  }
+  struct intake_frame hdr = { (uint16_t)type, (uint16_t)len };
+  memcpy(c->out + c->out_len, &hdr, sizeof(hdr));
+  memcpy(c->out + c->out_len + sizeof(hdr), payload, len);
+  c->out_len = need;
+  _mark_dirty(srv, c);
+}
+
+/*
+ * Auxilliary function to add a request to the current turn's batch.
+ */
+static struct request* _add_request(struct intake_server* srv,
+    struct conn* c, int type) {
+  if (srv->n_pending == srv->cap_pending) {
+    srv->cap_pending = srv->cap_pending ? 2 * srv->cap_pending : 64;
+    srv->pending = realloc(srv->pending,
+      srv->cap_pending * sizeof(struct request));
+    assert(srv->pending);
+  }
+  struct request* req = &srv->pending[srv->n_pending++];
+  req->conn = c;
+  req->type = type;
+  req->call = NULL;
+  req->id = 0;
+  return req;
+}
+
+/*
+ * Auxilliary function to turn the complete frames in a connection's input
+ * buffer into requests.  A malformed frame closes the connection.
+ */
+static void _parse(struct intake_server* srv, struct conn* c) {
+  int off = 0;
+  struct intake_frame hdr;
+
+  while (c->in_len - off >= (int)sizeof(hdr)) {
+    memcpy(&hdr, c->in + off, sizeof(hdr));
+    int expect = hdr.type == INTAKE_SUBMIT ? (int)sizeof(struct intake_submit) :
+      hdr.type == INTAKE_STATUS ? (int)sizeof(struct intake_status) : -1;
+    if (expect < 0 || hdr.len != expect) {
+      c->closing = 1;
+      _mark_dirty(srv, c);
+      return;
+    }
+    if (c->in_len - off < (int)sizeof(hdr) + hdr.len) {
+      break;
+    }
+
+    const char* payload = c->in + off + sizeof(hdr);
+    struct request* req = _add_request(srv, c, hdr.type);
+    if (hdr.type == INTAKE_SUBMIT) {
+      struct intake_submit sub;
+      memcpy(&sub, payload, sizeof(sub));
+      req->call = malloc(sizeof(Call));
+      assert(req->call);
+      memcpy(req->call->caller_name, sub.caller_name, sizeof(sub.caller_name));
+      req->call->caller_name[sizeof(sub.caller_name) - 1] = '\0';
+      memcpy(req->call->call_reason, sub.call_reason, sizeof(sub.call_reason));
+      req->call->call_reason[sizeof(sub.call_reason) - 1] = '\0';
+    } else {
+      struct intake_status st;
+      memcpy(&st, payload, sizeof(st));
+      req->id = st.id;
+    }
+    off += sizeof(hdr) + hdr.len;
+  }
+
+  memmove(c->in, c->in + off, c->in_len - off);
+  c->in_len -= off;
+}
+
+/*
+ * Auxilliary function to read everything a client has sent.
+ */
+static void _read(struct intake_server* srv, struct conn* c) {
+  while (!c->closing) {
+    ssize_t n = read(c->fd, c->in + c->in_len, INTAKE_INBUF - c->in_len);
+    if (n > 0) {
+      c->in_len += n;
+      _parse(srv, c);
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return;
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else {
+      c->closing = 1; // Hung up or failed
+      _mark_dirty(srv, c);
+    }
+  }
+}
+
+/*
+ * Auxilliary function to accept every pending connection.
+ */
+static void _accept(struct intake_server* srv) {
+  for (;;) {
+    int fd = accept(srv->listen_fd, NULL, NULL);
+    if (fd < 0) {
+      return; // EAGAIN, or out of descriptors until someone hangs up
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    struct conn* c = calloc(1, sizeof(struct conn));
+    assert(c);
+    c->fd = fd;
+    c->next = srv->conns;
+    if (srv->conns) {
+      srv->conns->prev = c;
+    }
+    srv->conns = c;
+    srv->connections++;
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    epoll_ctl(srv->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+  }
+}
+
+/*
+ * Auxilliary function to close a connection and free it.
+ */
+static void _close(struct intake_server* srv, struct conn* c) {
+  close(c->fd);
+  if (c->prev) {
+    c->prev->next = c->next;
+  } else {
+    srv->conns = c->next;
+  }
+  if (c->next) {
+    c->next->prev = c->prev;
+  }
+  srv->connections--;
+  free(c->out);
+  free(c);
+}
+
+/*
+ * Auxilliary function to send as much of a connection's replies as the
+ * socket takes, asking epoll to say when it can take more.
+ */
+static void _write(struct intake_server* srv, struct conn* c) {
+  int sent = 0;
+  while (sent < c->out_len) {
+    ssize_t n = send(c->fd, c->out + sent, c->out_len - sent, MSG_NOSIGNAL);
+    if (n > 0) {
+      sent += n;
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else {
+      if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        c->closing = 1;
+      }
+      break;
+    }
+  }
+  memmove(c->out, c->out + sent, c->out_len - sent);
+  c->out_len -= sent;
+
+  int want_out = c->out_len > 0;
+  if (want_out != c->want_out && !c->closing) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN | (want_out ? EPOLLOUT : 0);
+    ev.data.ptr = c;
+    epoll_ctl(srv->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->want_out = want_out;
+  }
+}
+
+/*
+ * Auxilliary function to handle the turn's batch of requests in order,
+ * then send the replies and close connections that are done.
+ */
+static void _finish_turn(struct intake_server* srv) {
+  for (int i = 0; i < srv->n_pending; i++) {
+    struct request* req = &srv->pending[i];
+    struct conn* c = req->conn;
+    if (req->type == INTAKE_SUBMIT) {
+      struct intake_accepted acc = { 0, 0 };
+      if (srv->enqueue(srv->queue, req->call)) {
+        acc.id = req->call->id;
+        acc.position = queue_size(srv->queue);
+        srv->accepted++;
+      }
+      if (!c->closing) {
+        _reply(srv, c, INTAKE_ACCEPTED, &acc, sizeof(acc));
+      }
+    } else if (!c->closing) {
+      struct intake_status_reply st = { req->id,
+        req->id ? intake_position(srv->queue, req->id) : 0,
+        queue_size(srv->queue) };
+      _reply(srv, c, INTAKE_STATUS_REPLY, &st, sizeof(st));
+    }
+  }
+  srv->n_pending = 0;
+
+  while (srv->dirty) {
+    struct conn* c = srv->dirty;
+    srv->dirty = c->next_dirty;
+    c->dirty = 0;
+    if (!c->closing) {
+      _write(srv, c);
+    }
+    if (c->closing) {
+      _close(srv, c);
+    }
+  }
+}
+
+/*
+ * This function creates an intake server listening on a Unix-domain socket.
+ * Any stale socket file at `path` is removed first.
+ *
+ * Params:
+ *   path - the filesystem path of the socket.  May not be NULL.
+ *   queue - the queue submitted calls are added to.  May not be NULL.
+ *   enqueue - the function used to add each call to the queue.  May not be
+ *     NULL.
+ *
+ * Return:
+ *   Returns the new server, or NULL if the socket could not be set up.
+ */
+struct intake_server* intake_server_create(const char* path,
+    struct queue* queue, intake_enqueue_fn enqueue) {
+  assert(path && queue && enqueue);
+  struct sockaddr_un addr;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    return NULL;
+  }
+
+  struct intake_server* srv = calloc(1, sizeof(struct intake_server));
+  assert(srv);
+  strcpy(srv->path, path);
+  srv->queue = queue;
+  srv->enqueue = enqueue;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  unlink(path);
+
+  srv->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  srv->epoll_fd = epoll_create1(0);
+  if (srv->listen_fd < 0 || srv->epoll_fd < 0 ||
+      bind(srv->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+      listen(srv->listen_fd, SOMAXCONN) < 0) {
+    if (srv->listen_fd >= 0) {
+      close(srv->listen_fd);
+    }
+    if (srv->epoll_fd >= 0) {
+      close(srv->epoll_fd);
+    }
+    free(srv);
+    return NULL;
+  }
+  fcntl(srv->listen_fd, F_SETFL, fcntl(srv->listen_fd, F_GETFL) | O_NONBLOCK);
+
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL; // The listening socket
+  epoll_ctl(srv->epoll_fd, EPOLL_CTL_ADD, srv->listen_fd, &ev);
+  return srv;
+}
+
+/*
+ * This function closes every connection, removes the socket and frees the
+ * server.  Calls already submitted stay in the queue.
+ *
+ * Params:
+ *   srv - the server to free.  May not be NULL.
+ */
+void intake_server_free(struct intake_server* srv) {
+  while (srv->conns) {
+    _close(srv, srv->conns);
+  }
+  close(srv->listen_fd);
+  close(srv->epoll_fd);
+  unlink(srv->path);
+  free(srv->pending);
+  free(srv);
+}
+
+/*
+ * This function adds another file descriptor, such as standard input, for
+ * intake_server_run() to watch, so one loop can wait for both.
+ *
+ * Params:
+ *   srv - the server.  May not be NULL.
+ *   fd - the descriptor to watch for input.
+ *
+ * Return:
+ *   Returns 1 on success or 0 if the descriptor can't be watched.
+ */
+int intake_server_watch(struct intake_server* srv, int fd) {
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = srv; // A watched descriptor
+  return epoll_ctl(srv->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+/*
+ * This function runs one turn of the event loop: it waits for activity,
+ * accepts new clients, reads and handles their requests and sends the
+ * replies.  Submitted calls are added to the queue before it returns.
+ *
+ * Params:
+ *   srv - the server.  May not be NULL.
+ *   timeout_ms - how long to wait for activity: 0 to poll, or -1 to wait
+ *     for as long as it takes.
+ *
+ * Return:
+ *   Returns 1 if a descriptor added with intake_server_watch() has input
+ *   waiting, otherwise 0.
+ */
+int intake_server_run(struct intake_server* srv, int timeout_ms) {
+  struct epoll_event events[INTAKE_MAX_EVENTS];
+  int watched = 0;
+
+  int n = epoll_wait(srv->epoll_fd, events, INTAKE_MAX_EVENTS, timeout_ms);
+  for (int i = 0; i < n; i++) {
+    void* ptr = events[i].data.ptr;
+    if (ptr == NULL) {
+      _accept(srv);
+    } else if (ptr == srv) {
+      watched = 1;
+    } else {
+      struct conn* c = ptr;
+      if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        _read(srv, c);
+      }
+      if (events[i].events & EPOLLOUT) {
+        _mark_dirty(srv, c);
+      }
+    }
+  }
+  _finish_turn(srv);
+  return watched;
+}
+
+/*
+ * This function returns the number of clients connected.
+ *
+ * Params:
+ *   srv - the server.  May not be NULL.
+ */
+int intake_server_connections(struct intake_server* srv) {
+  return srv->connections;
+}
+
+/*
+ * This function returns the number of calls submitted through the server
+ * that joined the queue since it was created.
+ *
+ * Params:
+ *   srv - the server.  May not be NULL.
+ */
+long intake_server_accepted(struct intake_server* srv) {
+  return srv->accepted;
+}
+
+#else
+
+struct intake_server* intake_server_create(const char* path,
+    struct queue* queue, intake_enqueue_fn enqueue) {
+  return NULL;
+}
+
+void intake_server_free(struct intake_server* srv) {}
+
+int intake_server_watch(struct intake_server* srv, int fd) {
+  return 0;
+}
+
+int intake_server_run(struct intake_server* srv, int timeout_ms) {
+  return 0;
+}
+
+int intake_server_connections(struct intake_server* srv) {
+  return 0;
+}
+
+long intake_server_accepted(struct intake_server* srv) {
+  return 0;
+}
+
+#endif
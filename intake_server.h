@@ -0,0 +1,40 @@
+/*
+ * This file contains the definition of the interface for the call center's
+ * intake server, which accepts calls from many clients at once over a
+ * Unix-domain socket.  You can find descriptions of the server functions,
+ * including their parameters and their return values, in intake_server.c.
+ */
+
+#ifndef __INTAKE_SERVER_H
+#define __INTAKE_SERVER_H
+
+#include "call.h"
+#include "queue.h"
+
+/*
+ * Structure used to represent an intake server.
+ */
+struct intake_server;
+
+/*
+ * Function the server calls to add a submitted call to the queue.  It must
+ * assign the call an ID larger than any already in the queue, and return 1,
+ * or take care of the call some other way (turn it away, call back later)
+ * and return 0.
+ */
+typedef int (*intake_enqueue_fn)(struct queue* queue, Call* call);
+
+/*
+ * Intake server interface function prototypes.  Refer to intake_server.c
+ * for documentation about each of these functions.
+ */
+struct intake_server* intake_server_create(const char* path,
+  struct queue* queue, intake_enqueue_fn enqueue);
+void intake_server_free(struct intake_server* srv);
+int intake_server_watch(struct intake_server* srv, int fd);
+int intake_server_run(struct intake_server* srv, int timeout_ms);
+int intake_server_connections(struct intake_server* srv);
+long intake_server_accepted(struct intake_server* srv);
+int intake_position(struct queue* queue, int id);
+
+#endif
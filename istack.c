@@ -0,0 +1,267 @@
+/*
+ * This file contains an implementation of an intrusive stack.  Instead of
+ * the stack allocating a node to hold each value, every value embeds a
+ * struct ilink, and the stack strings those links together into a circular
+ * doubly-linked list around a sentinel, newest first.  Pushing and popping
+ * therefore never allocate, and since each link knows both its neighbours,
+ * a value can be unlinked from the middle of the stack in O(1) given only
+ * the value itself.  Use a macro such as CALL_OF_LINK() in call.h to get
+ * from a link back to the value it is embedded in.
+ *
+ * Like stack_create_bounded(), a stack can be given a bound: pushing onto
+ * a full bounded stack evicts the oldest value, through the stack's
+ * eviction callback.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "istack.h"
+
+/*
+ * This structure is used to represent an intrusive stack.  `head` is the
+ * sentinel: head.next is the top of the stack and head.prev the bottom.
+ */
+struct istack {
+  struct ilink head;
+  int size;
+  int bound; // Most values kept, or 0 for no bound
+  void (*evict)(struct ilink* link, void* ctx);
+  void* evict_ctx;
+};
+
+/*
+ * Auxilliary function used to take a link out of the list it is in.  The
+ * link's fields are cleared so a stale link is easy to spot.
+ */
+static void _unlink(struct ilink* link) {
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+  link->next = NULL;
+  link->prev = NULL;
+}
+
+/*
+ * This function allocates and initializes a new, empty intrusive stack.
+ * This is the only allocation the stack ever makes.
+ *
+ * Params:
+ *   bound - the number of values to keep, or 0 to keep them all.  Pushing
+ *     onto a stack holding `bound` values evicts the oldest.
+ *
+ * Return:
+ *   Returns a pointer to the new stack.
+ */
+struct istack* istack_create(int bound) {
+  assert(bound >= 0);
+  struct istack* stack = malloc(sizeof(struct istack));
+  assert(stack);
+  stack->head.next = &stack->head;
+  stack->head.prev = &stack->head;
+  stack->size = 0;
+  stack->bound = bound;
+  stack->evict = NULL;
+  stack->evict_ctx = NULL;
+  return stack;
+}
+
+/*
+ * This function sets the function that is given each value a bounded stack
+ * evicts, e.g. to free the value the link is embedded in.  The link has
+ * already been unlinked when the callback runs.
+ *
+ * Params:
+ *   stack - the stack.  May not be NULL.
+ *   evict - the eviction callback, or NULL to just drop evicted values.
+ *   ctx - passed through to every call of `evict`.
+ */
+void istack_set_evict(struct istack* stack,
+    void (*evict)(struct ilink* link, void* ctx), void* ctx) {
+  assert(stack);
+  stack->evict = evict;
+  stack->evict_ctx = ctx;
+}
+
+/*
+ * This function frees an intrusive stack.  The stack doesn't own its
+ * values, so any still on it are left alone; use istack_clear() first to
+ * dispose of them.
+ *
+ * Params:
+ *   stack - the stack to free.  May not be NULL.
+ */
+void istack_free(struct istack* stack) {
+  assert(stack);
+  free(stack);
+}
+
+/*
+ * This function takes every value off an intrusive stack, top first,
+ * passing each one to a given function, e.g. to free the value its link is
+ * embedded in.
+ *
+ * Params:
+ *   stack - the stack.  May not be NULL.
+ *   fn - called with each unlinked link and `ctx`.  May be NULL.
+ *   ctx - passed through to `fn`.
+ */
+void istack_clear(struct istack* stack,
+    void (*fn)(struct ilink* link, void* ctx), void* ctx) {
+  assert(stack);
+  while (stack->head.next != &stack->head) {
+    struct ilink* link = stack->head.next;
+    _unlink(link);
+    stack->size--;
+    if (fn) {
+      fn(link, ctx);
+    }
+  }
+}
+
+/*
+ * This function checks whether an intrusive stack is empty.
+ *
+ * Params:
+ *   stack - the stack to check.  May not be NULL.
+ *
+ * Return:
+ *   Returns 1 if the stack is empty or 0 otherwise.
+ */
+int istack_isempty(struct istack* stack) {
+  assert(stack);
+  return stack->size == 0;
+}
+
+/*
+ * This function returns the number of values on an intrusive stack.
+ *
+ * Params:
+ *   stack - the stack.  May not be NULL.
+ */
+int istack_size(struct istack* stack) {
+  assert(stack);
+  return stack->size;
+}
+
+/*
+ * This function pushes a value onto an intrusive stack, evicting the
+ * oldest value first if the stack is bounded and full.
+ *
+ * Params:
+ *   stack - the stack onto which to push the value.  May not be NULL.
+ *   link - the link embedded in the value.  May not be NULL, and may not
+ *     be on any stack already.
+ */
+void istack_push(struct istack* stack, struct ilink* link) {
+  assert(stack && link);
+  if (stack->bound > 0 && stack->size == stack->bound) {
+    struct ilink* oldest = stack->head.prev;
+    _unlink(oldest);
+    stack->size--;
+    if (stack->evict) {
+      stack->evict(oldest, stack->evict_ctx);
+    }
+  }
+  link->prev = &stack->head;
+  link->next = stack->head.next;
+  stack->head.next->prev = link;
+  stack->head.next = link;
+  stack->size++;
+}
+
+/*
+ * This function returns the link at the top of an intrusive stack without
+ * removing it.
+ *
+ * Params:
+ *   stack - the stack.  May not be NULL.
+ *
+ * Return:
+ *   Returns the most recently pushed link, or NULL if the stack is empty.
+ */
+struct ilink* istack_top(struct istack* stack) {
+  assert(stack);
+  return stack->size ? stack->head.next : NULL;
+}
+
+/*
+ * This function pops the link at the top of an intrusive stack.
+ *
+ * Params:
+ *   stack - the stack.  May not be NULL.
+ *
+ * Return:
+ *   Returns the most recently pushed link, or NULL if the stack is empty.
+ */
+struct ilink* istack_pop(struct istack* stack) {
+  assert(stack);
+  if (stack->size == 0) {
+    return NULL;
+  }
+  struct ilink* link = stack->head.next;
+  _unlink(link);
+  stack->size--;
+  return link;
+}
+
+/*
+ * This function returns the link below a given link on an intrusive stack,
+ * i.e. the one pushed just before it, for walking the stack from the top.
+ *
+ * Params:
+ *   stack - the stack.  May not be NULL.
+ *   link - a link on the stack.  May not be NULL.
+ *
+ * Return:
+ *   Returns the next older link, or NULL if `link` is at the bottom.
+ */
+struct ilink* istack_next(struct istack* stack, struct ilink* link) {
+  assert(stack && link && link->next);
+  return link->next == &stack->head ? NULL : link->next;
+}
+
+/*
+ * This function returns the link at a given depth in an intrusive stack,
+ * walking from whichever end is nearer.
+ *
+ * Params:
+ *   stack - the stack.  May not be NULL.
+ *   idx - the depth of the link, 0 being the top.
+ *
+ * Return:
+ *   Returns the link, or NULL if `idx` is out of range.
+ */
+struct ilink* istack_get(struct istack* stack, int idx) {
+  assert(stack);
+  if (idx < 0 || idx >= stack->size) {
+    return NULL;
+  }
+  struct ilink* link;
+  if (idx < stack->size / 2) {
+    link = stack->head.next;
+    for (int i = 0; i < idx; i++) {
+      link = link->next;
+    }
+  } else {
+    link = stack->head.prev;
+    for (int i = stack->size - 1; i > idx; i--) {
+      link = link->prev;
+    }
+  }
+  return link;
+}
+
+/*
+ * This function unlinks a value from wherever it is in an intrusive stack,
+ * in constant time.  The eviction callback is not called.
+ *
+ * Params:
+ *   stack - the stack.  May not be NULL.
+ *   link - the link embedded in the value.  May not be NULL, and must be
+ *     on `stack`.
+ */
+void istack_remove(struct istack* stack, struct ilink* link) {
+  assert(stack && link && link->next);
+  _unlink(link);
+  stack->size--;
+}
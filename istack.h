@@ -0,0 +1,44 @@
+/*
+ * This file contains the definition of the interface for an intrusive
+ * stack.  You can find descriptions of the intrusive stack functions,
+ * including their parameters and their return values, in istack.c.
+ */
+
+#ifndef __ISTACK_H
+#define __ISTACK_H
+
+/*
+ * Structure used to link a value into an intrusive stack.  Links are
+ * allocated by the caller, embedded in the value they link, and belong to
+ * at most one stack at a time.  The fields are private to istack.c.
+ */
+struct ilink {
+  struct ilink* next;
+  struct ilink* prev;
+};
+
+/*
+ * Structure used to represent an intrusive stack.
+ */
+struct istack;
+
+/*
+ * Intrusive stack interface function prototypes.  Refer to istack.c for
+ * documentation about each of these functions.
+ */
+struct istack* istack_create(int bound);
+void istack_set_evict(struct istack* stack,
+    void (*evict)(struct ilink* link, void* ctx), void* ctx);
+void istack_free(struct istack* stack);
+void istack_clear(struct istack* stack,
+    void (*fn)(struct ilink* link, void* ctx), void* ctx);
+int istack_isempty(struct istack* stack);
+int istack_size(struct istack* stack);
+void istack_push(struct istack* stack, struct ilink* link);
+struct ilink* istack_top(struct istack* stack);
+struct ilink* istack_pop(struct istack* stack);
+struct ilink* istack_next(struct istack* stack, struct ilink* link);
+struct ilink* istack_get(struct istack* stack, int idx);
+void istack_remove(struct istack* stack, struct ilink* link);
+
+#endif
@@ -8,6 +8,7 @@
 #include <assert.h>
 
 #include "list.h"
+#include "memacct.h"
 
 /*
  * This structure is used to represent a single node in a singly-linked list.
@@ -24,6 +25,7 @@ struct node {
  */
 struct list {
   struct node* head;
+  struct memacct* mem; // Where nodes are allocated and counted, or NULL
 };
 
 /*
@@ -31,8 +33,22 @@ struct list {
  * returns a pointer to it.
  */
 struct list* list_create() {
-  struct list* list = malloc(sizeof(struct list));
+  return list_create_with(NULL);
+}
+
+/*
+ * This function allocates and initializes a new, empty linked list that
+ * gets its memory through, and counts it in, the given accounting state
+ * (see memacct.c).  The list and its nodes are allocated there.
+ *
+ * Params:
+ *   mem - the accounting state of the container the list belongs to.  It
+ *     must outlive the list.  May be NULL to use malloc() and free().
+ */
+struct list* list_create_with(struct memacct* mem) {
+  struct list* list = memacct_alloc(mem, sizeof(struct list));
   list->head = NULL;
+  list->mem = mem;
   return list;
 }
 
@@ -54,11 +70,26 @@ void list_free(struct list* list) {
   while (curr != NULL) {
     next = curr->next;
     free(curr->val); // 追加
-    free(curr);
+    memacct_free(list->mem, curr, sizeof(struct node));
     curr = next;
   }
 
-  free(list);
+  memacct_free(list->mem, list, sizeof(struct list));
+}
+
+/*
+ * This function changes the accounting state a linked list allocates and
+ * frees its nodes through from now on.  The memory it already holds is not
+ * counted over; see memacct_move().
+ *
+ * Params:
+ *   list - the linked list.  May not be NULL.
+ *   mem - the new accounting state, with the same allocator as the old one.
+ *     It must outlive the list.
+ */
+void list_set_mem(struct list* list, struct memacct* mem) {
+  assert(list);
+  list->mem = mem;
 }
 
 /*
@@ -76,7 +107,7 @@ void list_insert(struct list* list, void* val) {
   /*
    * Create new node and insert at head.
    */
-  struct node* temp = malloc(sizeof(struct node));
+  struct node* temp = memacct_alloc(list->mem, sizeof(struct node));
   temp->val = val;
   temp->next = list->head;
   list->head = temp;
@@ -115,7 +146,7 @@ void list_remove(struct list* list, void* val, int (*cmp)(void* a, void* b)) {
       } else {
         list->head = curr->next;
       }
-      free(curr);
+      memacct_free(list->mem, curr, sizeof(struct node));
       return;
     }
 
@@ -260,7 +291,7 @@ void* pop_value(struct list* list){
   void* return_value =  list->head->val;
   curr = list->head;
   list->head = curr->next;
-  free(curr);
+  memacct_free(list->mem, curr, sizeof(struct node));
   return return_value;
 }
 
@@ -290,3 +321,39 @@ int list_size(struct list* list) {
     }
     return size; // Return the current size of the list
 }
+
+/*
+ * This function returns the value stored at a given 0-based position in a
+ * linked list, counting from the head, without removing it.
+ *
+ * Params:
+ *   list - the linked list to read from.  May not be NULL.
+ *   idx - the position of the value to return.
+ *
+ * Return:
+ *   Returns the value at position `idx`, or NULL if the list has no more
+ *   than `idx` nodes.
+ */
+void* list_get(struct list* list, int idx) {
+  assert(list);
+
+  struct node* curr = list->head;
+  while (curr && idx > 0) {
+    curr = curr->next;
+    idx--;
+  }
+  return curr ? curr->val : NULL;
+}
+
+/*
+ * This function returns how many of the bytes a linked list holds are
+ * standing empty.  Every node holds a value, so for this list it is always
+ * 0; see list_unrolled.c for a list where it isn't.
+ *
+ * Params:
+ *   list - the linked list.  May not be NULL.
+ */
+size_t list_unused_bytes(struct list* list) {
+  assert(list);
+  return 0;
+}
@@ -7,19 +7,24 @@
 #ifndef __LIST_H
 #define __LIST_H
 
+#include <stddef.h>
+
 /*
  * Structure used to represent a singly-linked list.  You may not change the
  * fact that only a forward declaration of the list structure is included
  * here.  In other words, you can't define the fields of the struct here.
  */
 struct list;
+struct memacct;
 
 /*
  * Linked list interface function prototypes.  Refer to list.c for
  * documentation about each of these functions.
  */
 struct list* list_create();
+struct list* list_create_with(struct memacct* mem);
 void list_free(struct list* list);
+void list_set_mem(struct list* list, struct memacct* mem);
 void list_insert(struct list* list, void* val);
 void list_remove(struct list* list, void* val, int (*cmp)(void* a, void* b));
 int list_position(struct list* list, void* val, int (*cmp)(void* a, void* b));
@@ -28,5 +33,7 @@ void* top_value(struct list* list);
 void* pop_value(struct list* list);
 int list_isempty(struct list* list);
 int list_size(struct list* list); 
+void* list_get(struct list* list, int idx);
+size_t list_unused_bytes(struct list* list);
 
 #endif
\ No newline at end of file
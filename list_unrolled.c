@@ -0,0 +1,253 @@
+/*
+ * This file contains an unrolled implementation of the singly-linked list
+ * interface in list.h.  Instead of one node per value, each node holds up to
+ * UNROLLED_SLOTS values in a small array, so walking the list follows one
+ * pointer per chunk rather than one per element and reads values from
+ * consecutive memory.  A node is sized to two 64-byte cache lines.
+ *
+ * Link against list_unrolled.o instead of list.o to use it (for example,
+ * `make LIST_OBJ=list_unrolled.o`); the interface and its semantics are the
+ * same.  See the documentation in list.c for the individual functions.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "list.h"
+#include "memacct.h"
+
+#define UNROLLED_SLOTS 14
+
+/*
+ * This structure is used to represent a single chunk of the list.  The
+ * values of a node are stored in reverse: vals[count - 1] is the value
+ * nearest the head of the list and vals[0] the one nearest the tail, so
+ * inserting or removing at the head touches only the end of the array.
+ */
+struct node {
+  void* vals[UNROLLED_SLOTS];
+  int count;
+  struct node* next;
+};
+
+/*
+ * This structure is used to represent an entire list.  The numbers of values
+ * and nodes are kept so list_size() and list_unused_bytes() are O(1).
+ */
+struct list {
+  struct node* head;
+  int size;
+  int nodes;
+  struct memacct* mem; // Where nodes are allocated and counted, or NULL
+};
+
+struct list* list_create() {
+  return list_create_with(NULL);
+}
+
+struct list* list_create_with(struct memacct* mem) {
+  struct list* list = memacct_alloc(mem, sizeof(struct list));
+  list->head = NULL;
+  list->size = 0;
+  list->nodes = 0;
+  list->mem = mem;
+  return list;
+}
+
+/*
+ * Like list_free() in list.c, this frees the values still stored in the
+ * list along with the list itself.
+ */
+void list_free(struct list* list) {
+  assert(list);
+
+  struct node* next, * curr = list->head;
+  while (curr != NULL) {
+    next = curr->next;
+    for (int i = 0; i < curr->count; i++) {
+      free(curr->vals[i]);
+    }
+    memacct_free(list->mem, curr, sizeof(struct node));
+    curr = next;
+  }
+
+  memacct_free(list->mem, list, sizeof(struct list));
+}
+
+void list_set_mem(struct list* list, struct memacct* mem) {
+  assert(list);
+  list->mem = mem;
+}
+
+void list_insert(struct list* list, void* val) {
+  assert(list);
+
+  /*
+   * Fill the head node first; only start a new node when it is full.
+   */
+  if (!list->head || list->head->count == UNROLLED_SLOTS) {
+    struct node* temp = memacct_alloc(list->mem, sizeof(struct node));
+    temp->count = 0;
+    temp->next = list->head;
+    list->head = temp;
+    list->nodes++;
+  }
+  list->head->vals[list->head->count++] = val;
+  list->size++;
+}
+
+/*
+ * Auxilliary function to remove the value at array index `i` of `curr`,
+ * whose predecessor is `prev` (NULL at the head).  An emptied node is freed,
+ * and a node left less than a quarter full is merged into its successor
+ * when they fit in one node, to keep chunks dense.
+ */
+static void _remove_at(struct list* list, struct node* prev, struct node* curr,
+    int i) {
+  memmove(&curr->vals[i], &curr->vals[i + 1],
+    (curr->count - i - 1) * sizeof(void*));
+  curr->count--;
+  list->size--;
+
+  if (curr->count == 0) {
+    if (prev) {
+      prev->next = curr->next;
+    } else {
+      list->head = curr->next;
+    }
+    memacct_free(list->mem, curr, sizeof(struct node));
+    list->nodes--;
+    return;
+  }
+
+  struct node* next = curr->next;
+  if (curr->count < UNROLLED_SLOTS / 4 && next &&
+      curr->count + next->count <= UNROLLED_SLOTS) {
+    /*
+     * next's values come after curr's in list order, so they go below
+     * curr's in the (reversed) array.
+     */
+    memmove(&curr->vals[next->count], &curr->vals[0],
+      curr->count * sizeof(void*));
+    memcpy(&curr->vals[0], &next->vals[0], next->count * sizeof(void*));
+    curr->count += next->count;
+    curr->next = next->next;
+    memacct_free(list->mem, next, sizeof(struct node));
+    list->nodes--;
+  }
+}
+
+void list_remove(struct list* list, void* val, int (*cmp)(void* a, void* b)) {
+  assert(list);
+
+  struct node* prev = NULL, * curr = list->head;
+  while (curr) {
+    for (int i = curr->count - 1; i >= 0; i--) {
+      if (cmp(val, curr->vals[i]) == 0) {
+        _remove_at(list, prev, curr, i);
+        return;
+      }
+    }
+    prev = curr;
+    curr = curr->next;
+  }
+}
+
+int list_position(struct list* list, void* val, int (*cmp)(void* a, void* b)) {
+  assert(list);
+
+  struct node* curr = list->head;
+  int base = 0;
+  while (curr) {
+    /*
+     * Search within the chunk before following the next pointer.
+     */
+    for (int i = curr->count - 1; i >= 0; i--) {
+      if (cmp(val, curr->vals[i]) == 0) {
+        return base + (curr->count - 1 - i);
+      }
+    }
+    base += curr->count;
+    curr = curr->next;
+  }
+  return -1;
+}
+
+void list_reverse(struct list* list) {
+  assert(list);
+
+  /*
+   * Reverse the order of the nodes and the order of the values within each
+   * node.
+   */
+  struct node* next, * curr = list->head, * prev = NULL;
+  while (curr) {
+    for (int i = 0, j = curr->count - 1; i < j; i++, j--) {
+      void* temp = curr->vals[i];
+      curr->vals[i] = curr->vals[j];
+      curr->vals[j] = temp;
+    }
+    next = curr->next;
+    curr->next = prev;
+    list->head = prev = curr;
+    curr = next;
+  }
+}
+
+void* top_value(struct list* list) {
+  assert(list);
+  if (list->head == NULL) {
+    return NULL;
+  }
+  return list->head->vals[list->head->count - 1];
+}
+
+void* pop_value(struct list* list) {
+  assert(list);
+  if (list->head == NULL) {
+    return NULL;
+  }
+
+  struct node* head = list->head;
+  void* return_value = head->vals[--head->count];
+  list->size--;
+  if (head->count == 0) {
+    list->head = head->next;
+    memacct_free(list->mem, head, sizeof(struct node));
+    list->nodes--;
+  }
+  return return_value;
+}
+
+int list_isempty(struct list* list) {
+  assert(list);
+  return list->head == NULL;
+}
+
+int list_size(struct list* list) {
+  assert(list);
+  return list->size;
+}
+
+void* list_get(struct list* list, int idx) {
+  assert(list);
+
+  /*
+   * Skip whole chunks until reaching the one holding position `idx`.
+   */
+  struct node* curr = list->head;
+  while (curr && idx >= curr->count) {
+    idx -= curr->count;
+    curr = curr->next;
+  }
+  return curr ? curr->vals[curr->count - 1 - idx] : NULL;
+}
+
+/*
+ * Empty slots in partly filled chunks count as unused.
+ */
+size_t list_unused_bytes(struct list* list) {
+  assert(list);
+  return (size_t)(list->nodes * UNROLLED_SLOTS - list->size) * sizeof(void*);
+}
@@ -0,0 +1,145 @@
+/*
+ * This file contains an implementation of memory accounting for the
+ * containers.  Every allocation and free a container makes for its own
+ * storage goes through memacct_alloc() and memacct_free(), which call the
+ * container's allocator if it has one (or malloc() and free() if not) and
+ * keep a running total of the bytes held and its peak.
+ *
+ * How much of that memory is actually in use depends on the container:
+ * empty slots at the end of a dynamic array, half-full chunks of an
+ * unrolled list or recycled segments of a segmented queue all count as
+ * reserved but unused.  Each container works that out itself when asked
+ * and passes it to memacct_stats().
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "memacct.h"
+
+/*
+ * This function sets up accounting with nothing allocated yet.
+ *
+ * Params:
+ *   mem - the accounting state to initialize.  May not be NULL.
+ *   allocator - the allocator to get memory from.  Copied.  May be NULL, or
+ *     have NULL functions, to use malloc() and free().
+ */
+void memacct_init(struct memacct* mem, const struct allocator* allocator) {
+  assert(mem);
+  if (allocator) {
+    assert(!allocator->alloc == !allocator->release);
+    mem->allocator = *allocator;
+  } else {
+    mem->allocator.alloc = NULL;
+    mem->allocator.release = NULL;
+    mem->allocator.ctx = NULL;
+  }
+  mem->reserved = 0;
+  mem->peak = 0;
+  mem->allocs = 0;
+  mem->frees = 0;
+}
+
+/*
+ * This function allocates memory for a container and counts it.
+ *
+ * Params:
+ *   mem - the container's accounting state.  May be NULL to allocate with
+ *     malloc() without counting.
+ *   bytes - the number of bytes to allocate.
+ *
+ * Return:
+ *   Returns a pointer to the allocated memory.  Allocation may not fail.
+ */
+void* memacct_alloc(struct memacct* mem, size_t bytes) {
+  void* ptr;
+  if (mem && mem->allocator.alloc) {
+    ptr = mem->allocator.alloc(bytes, mem->allocator.ctx);
+  } else {
+    ptr = malloc(bytes);
+  }
+  assert(ptr);
+  memacct_count(mem, bytes);
+  return ptr;
+}
+
+/*
+ * This function frees memory allocated with memacct_alloc().
+ *
+ * Params:
+ *   mem - the accounting state the memory was allocated with.
+ *   ptr - the memory to free.
+ *   bytes - the number of bytes that were allocated.
+ */
+void memacct_free(struct memacct* mem, void* ptr, size_t bytes) {
+  if (mem && mem->allocator.release) {
+    mem->allocator.release(ptr, bytes, mem->allocator.ctx);
+  } else {
+    free(ptr);
+  }
+  memacct_count(mem, -(long long)bytes);
+}
+
+/*
+ * This function counts an allocation or a free without making it, for
+ * memory a container gets some other way than memacct_alloc() (see
+ * dynarray.c).
+ *
+ * Params:
+ *   mem - the accounting state.  May be NULL, in which case nothing is
+ *     counted.
+ *   bytes - the number of bytes allocated, or freed if negative.
+ */
+void memacct_count(struct memacct* mem, long long bytes) {
+  if (!mem) {
+    return;
+  }
+  if (bytes >= 0) {
+    mem->allocs++;
+  } else {
+    mem->frees++;
+  }
+  mem->reserved += bytes;
+  if (mem->reserved > mem->peak) {
+    mem->peak = mem->reserved;
+  }
+}
+
+/*
+ * This function hands memory over from one accounting state to another
+ * without allocating or freeing anything, e.g. when a container's storage is
+ * detached to be freed elsewhere (see queue_clear_async()).
+ *
+ * Params:
+ *   from - the accounting state the memory is counted in now.  May not be
+ *     NULL.
+ *   to - the accounting state to count it in instead.  May not be NULL.
+ *   bytes - the number of bytes to move.
+ */
+void memacct_move(struct memacct* from, struct memacct* to, size_t bytes) {
+  assert(from && to && bytes <= from->reserved);
+  from->reserved -= bytes;
+  to->reserved += bytes;
+  if (to->reserved > to->peak) {
+    to->peak = to->reserved;
+  }
+}
+
+/*
+ * This function reports the memory counted.
+ *
+ * Params:
+ *   mem - the accounting state.  May not be NULL.
+ *   unused - how many of the reserved bytes are standing empty.
+ *   out - filled in with the totals.  May not be NULL.
+ */
+void memacct_stats(const struct memacct* mem, size_t unused,
+    struct mem_stats* out) {
+  assert(mem && out && unused <= mem->reserved);
+  out->reserved = mem->reserved;
+  out->used = mem->reserved - unused;
+  out->peak = mem->peak;
+  out->allocs = mem->allocs;
+  out->frees = mem->frees;
+}
@@ -0,0 +1,63 @@
+/*
+ * This file contains the definition of the interface for memory accounting
+ * in the containers.  A container can be given an allocator to get its own
+ * storage from, and counts the bytes it holds either way, so callers can see
+ * how much memory each container takes and how much of it is in use.  You
+ * can find descriptions of the accounting functions, including their
+ * parameters and their return values, in memacct.c.
+ */
+
+#ifndef __MEMACCT_H
+#define __MEMACCT_H
+
+#include <stddef.h>
+
+/*
+ * Functions a container gets its own storage from (its structure, array,
+ * nodes or segments, but not the values stored in it).  `release` is told
+ * the size that was allocated.
+ */
+struct allocator {
+  void* (*alloc)(size_t bytes, void* ctx);
+  void (*release)(void* ptr, size_t bytes, void* ctx);
+  void* ctx;  // Passed through to both functions
+};
+
+/*
+ * Memory used by a container, filled in by queue_mem_stats() and
+ * stack_mem_stats().
+ */
+struct mem_stats {
+  size_t reserved;  // Bytes the container holds now
+  size_t used;      // Of those, bytes not standing empty
+  size_t peak;      // Most bytes the container has held at once
+  long allocs;      // Allocations made so far
+  long frees;       // Frees made so far
+};
+
+/*
+ * The accounting state a container keeps.  Containers embed it and pass a
+ * pointer to it to the structures they are built from, so its fields are
+ * visible here; callers should use the functions in memacct.c.
+ */
+struct memacct {
+  struct allocator allocator;  // alloc is NULL to use malloc() and free()
+  size_t reserved;
+  size_t peak;
+  long allocs;
+  long frees;
+};
+
+/*
+ * Memory accounting interface function prototypes.  Refer to memacct.c for
+ * documentation about each of these functions.
+ */
+void memacct_init(struct memacct* mem, const struct allocator* allocator);
+void* memacct_alloc(struct memacct* mem, size_t bytes);
+void memacct_free(struct memacct* mem, void* ptr, size_t bytes);
+void memacct_count(struct memacct* mem, long long bytes);
+void memacct_move(struct memacct* from, struct memacct* to, size_t bytes);
+void memacct_stats(const struct memacct* mem, size_t unused,
+  struct mem_stats* out);
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * This file contains the functions that create, map and remove the
+ * shared-memory metrics segment.  These are the only metrics functions that
+ * make system calls; the counters themselves are updated inline through the
+ * helpers in metrics.h.  See the documentation below for more information
+ * on the individual functions in this implementation.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "metrics.h"
+#include "timeutil.h"
+
+/*
+ * This function creates a metrics segment with the given POSIX
+ * shared-memory name, replacing any left over from an earlier run, and maps
+ * it for writing.  Every counter starts at zero and `n_threads` at 1.
+ *
+ * Params:
+ *   name - the shared-memory name, starting with '/'.  May not be NULL.
+ *
+ * Return:
+ *   Returns a pointer to the mapped segment, or NULL if it could not be
+ *   created.  Metrics are optional, so callers should carry on without them.
+ */
+struct metrics* metrics_create(const char* name) {
+  shm_unlink(name);
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    return NULL;
+  }
+  if (ftruncate(fd, sizeof(struct metrics)) < 0) {
+    close(fd);
+    shm_unlink(name);
+    return NULL;
+  }
+
+  struct metrics* m = mmap(NULL, sizeof(struct metrics),
+    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED) {
+    shm_unlink(name);
+    return NULL;
+  }
+
+  memset(m, 0, sizeof(struct metrics));
+  m->version = METRICS_VERSION;
+  m->pid = getpid();
+  m->n_threads = 1;
+  m->start_ns = now_ns();
+  __atomic_store_n(&m->magic, METRICS_MAGIC, __ATOMIC_RELEASE);
+  return m;
+}
+
+/*
+ * This function maps an existing metrics segment read-only, for monitoring
+ * tools.
+ *
+ * Params:
+ *   name - the shared-memory name the segment was created with.  May not
+ *     be NULL.
+ *
+ * Return:
+ *   Returns a pointer to the mapped segment, or NULL if there is no such
+ *   segment or it wasn't written by a compatible version.
+ */
+struct metrics* metrics_open(const char* name) {
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  struct metrics* m = mmap(NULL, sizeof(struct metrics), PROT_READ,
+    MAP_SHARED, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED) {
+    return NULL;
+  }
+  if (__atomic_load_n(&m->magic, __ATOMIC_ACQUIRE) != METRICS_MAGIC ||
+      m->version != METRICS_VERSION) {
+    munmap(m, sizeof(struct metrics));
+    return NULL;
+  }
+  return m;
+}
+
+/*
+ * This function unmaps a metrics segment without removing it.
+ *
+ * Params:
+ *   m - the segment to unmap.  May not be NULL.
+ */
+void metrics_close(struct metrics* m) {
+  munmap(m, sizeof(struct metrics));
+}
+
+/*
+ * This function unmaps a metrics segment and removes its name, so tools
+ * can no longer open it.  Tools that already have it mapped keep reading
+ * the final values.
+ *
+ * Params:
+ *   m - the segment to remove.  May not be NULL.
+ *   name - the shared-memory name the segment was created with.
+ */
+void metrics_destroy(struct metrics* m, const char* name) {
+  metrics_close(m);
+  shm_unlink(name);
+}
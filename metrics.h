@@ -0,0 +1,91 @@
+/*
+ * This file contains the definition of the shared-memory metrics segment the
+ * call center publishes its counters in.  The layout is public so that the
+ * hot path can bump counters inline, without a function call or a syscall,
+ * and so that external tools such as callcenter_stat can map the segment
+ * and read it.  You can find descriptions of the other functions, including
+ * their parameters and their return values, in metrics.c.
+ */
+
+#ifndef __METRICS_H
+#define __METRICS_H
+
+#define METRICS_NAME "/callcenter"   // Default POSIX shared-memory name
+#define METRICS_MAGIC 0x43434d54u    // "CCMT"
+#define METRICS_VERSION 1
+#define METRICS_MAX_THREADS 32
+
+/*
+ * Counters for one thread.  Each thread only writes its own slot, and each
+ * slot fills a whole cache line, so threads never contend on counters.
+ */
+struct metrics_thread {
+  unsigned long long enqueues;
+  unsigned long long dequeues;
+  unsigned long long pushes;
+  unsigned long long pops;
+} __attribute__((aligned(64)));
+
+/*
+ * Gauges for one structure, written only by the thread that owns it.
+ * `resizes` counts changes of capacity seen through metrics_gauge().
+ */
+struct metrics_gauge {
+  long long size;
+  long long high_water;
+  long long capacity;
+  long long resizes;
+} __attribute__((aligned(64)));
+
+/*
+ * The whole segment.  `n_threads` is the number of slots in use.
+ */
+struct metrics {
+  unsigned int magic;
+  unsigned int version;
+  int pid;
+  int n_threads;
+  long long start_ns;
+  struct metrics_gauge queue;
+  struct metrics_gauge stack;
+  struct metrics_thread threads[METRICS_MAX_THREADS];
+};
+
+/*
+ * Adds one to a counter owned by the calling thread.  The store is atomic
+ * so readers never see a torn value, but no read-modify-write is needed
+ * since nobody else writes the counter.
+ */
+static inline void metrics_inc(unsigned long long* counter) {
+  __atomic_store_n(counter, *counter + 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Records the current size and capacity of a structure, updating its
+ * high-water mark and counting a resize whenever the capacity changes.  A
+ * capacity of 0 means the structure has none to report.
+ */
+static inline void metrics_gauge(struct metrics_gauge* g, long long size,
+    long long capacity) {
+  __atomic_store_n(&g->size, size, __ATOMIC_RELAXED);
+  if (size > g->high_water) {
+    __atomic_store_n(&g->high_water, size, __ATOMIC_RELAXED);
+  }
+  if (capacity != g->capacity) {
+    if (g->capacity != 0) {
+      __atomic_store_n(&g->resizes, g->resizes + 1, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&g->capacity, capacity, __ATOMIC_RELAXED);
+  }
+}
+
+/*
+ * Interface function prototypes.  Refer to metrics.c for documentation
+ * about each of these functions.
+ */
+struct metrics* metrics_create(const char* name);
+struct metrics* metrics_open(const char* name);
+void metrics_close(struct metrics* m);
+void metrics_destroy(struct metrics* m, const char* name);
+
+#endif
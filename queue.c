@@ -13,19 +13,47 @@
 
 #include "queue.h"
 #include "dynarray.h"
+#include "reclaim.h"
+
+/*
+ * Number of values a queue holds inside its own structure before it
+ * allocates a dynamic array for them.
+ */
+#define QUEUE_SMALL_SLOTS 4
 
 /*
  * This is the structure that will be used to represent a queue.  This
  * structure specifically contains a single field representing a dynamic array
  * that should be used as the underlying data storage for the queue.
  *
- * You should not modify this structure.
+ * Until it first holds more than QUEUE_SMALL_SLOTS values, a queue keeps
+ * them in `small`, a ring inside the structure, and `array` is NULL.  Most
+ * queues never get that long, so they cost one allocation, not three (the
+ * structure, the array and its storage).
  */
 struct queue {
   struct dynarray* array;
-  
+  void* small[QUEUE_SMALL_SLOTS];
+  int small_start;
+  int small_size;
+  struct memacct mem; // Memory held by the queue and its array
+
 };
 
+/*
+ * Auxilliary function to move the values of a queue in small mode into a
+ * new dynamic array.
+ */
+static void _queue_spill(struct queue* queue) {
+	queue->array = dynarray_create_with(&queue->mem);
+	for (int i = 0; i < queue->small_size; i++) {
+		dynarray_insert(queue->array,
+			queue->small[(queue->small_start + i) % QUEUE_SMALL_SLOTS]);
+	}
+	queue->small_start = 0;
+	queue->small_size = 0;
+}
+
 /*
  * This function should allocate and initialize a new, empty queue and return
  * a pointer to it.
@@ -34,8 +62,26 @@ struct queue* queue_create() {
 	/*
 	 * FIXME:
 	 */
-	struct queue* new_queue = malloc(sizeof(struct queue));
-	new_queue->array = dynarray_create();
+	return queue_create_with(NULL);
+}
+
+/*
+ * This function allocates and initializes a new, empty queue that gets its
+ * own storage from the given allocator (see memacct.h).  Values stored in
+ * the queue are still the caller's to allocate and are freed with free().
+ *
+ * Params:
+ *   allocator - the allocator to use.  Copied.  May be NULL to use malloc()
+ *     and free().
+ */
+struct queue* queue_create_with(const struct allocator* allocator) {
+	struct memacct mem;
+	memacct_init(&mem, allocator);
+	struct queue* new_queue = memacct_alloc(&mem, sizeof(struct queue));
+	new_queue->mem = mem;
+	new_queue->array = NULL;
+	new_queue->small_start = 0;
+	new_queue->small_size = 0;
 	return new_queue;
 }
 
@@ -57,11 +103,67 @@ void queue_free(struct queue* queue) {
         void* value = queue_dequeue(queue);
         free(value); 
     }
-	dynarray_free(queue->array);
-	free(queue);
+	if (queue->array) {
+		dynarray_free(queue->array);
+	}
+	struct memacct mem = queue->mem; // The queue can't free itself from itself
+	memacct_free(&mem, queue, sizeof(struct queue));
   	return;
 }
 
+/*
+ * Auxilliary function run by the reclaimer (see reclaim.c) on a queue
+ * detached by queue_clear_async(): frees up to `batch` values, and the
+ * queue itself once it is empty.
+ */
+static int _queue_reclaim_step(void* arg, int batch) {
+	struct queue* detached = arg;
+	while (batch-- > 0 && !queue_isempty(detached)) {
+		free(queue_dequeue(detached));
+	}
+	if (!queue_isempty(detached)) {
+		return 1;
+	}
+	queue_free(detached);
+	return 0;
+}
+
+/*
+ * This function empties a given queue in O(1) time.  Its values, which are
+ * freed with free() as by queue_free(), are detached along with the array
+ * holding them and freed later on a background thread, so clearing a queue
+ * of millions of calls doesn't stall the caller.  The queue is left as if
+ * newly created, without any capacity reserved with queue_reserve().  A
+ * queue still holding its values in its own structure just frees them.
+ *
+ * The queue's allocator, if it has one, is called from the background
+ * thread too, so it must be safe to call from more than one thread.
+ *
+ * Params:
+ *   queue - the queue to clear.  May not be NULL.
+ */
+void queue_clear_async(struct queue* queue) {
+	if (!queue->array) {
+		while (queue->small_size > 0) {
+			free(queue_dequeue(queue));
+		}
+		return;
+	}
+	struct memacct mem;
+	memacct_init(&mem, &queue->mem.allocator);
+	struct queue* detached = memacct_alloc(&mem, sizeof(struct queue));
+	detached->mem = mem;
+	detached->array = queue->array;
+	detached->small_size = 0;
+	dynarray_set_mem(detached->array, &detached->mem);
+	// Everything but the queue structure itself belongs to the array
+	memacct_move(&queue->mem, &detached->mem,
+		queue->mem.reserved - sizeof(struct queue));
+
+	queue->array = NULL;
+	reclaim_defer(_queue_reclaim_step, detached);
+}
+
 /*
  * This function should indicate whether a given queue is currently empty.
  * Specifically, it should return 1 if the specified queue is empty (i.e.
@@ -74,7 +176,7 @@ int queue_isempty(struct queue* queue) {
 	/* 
 	 * FIXME:
 	 */
-	if(dynarray_size(queue->array) == 0){
+	if(queue_size(queue) == 0){
 		return 1;
 	}else{
 		return 0;
@@ -95,6 +197,15 @@ void queue_enqueue(struct queue* queue, void* val) {
 	/*
 	 * FIXME:
 	 */
+	if (!queue->array) {
+		if (queue->small_size < QUEUE_SMALL_SLOTS) {
+			int idx = (queue->small_start + queue->small_size) % QUEUE_SMALL_SLOTS;
+			queue->small[idx] = val;
+			queue->small_size++;
+			return;
+		}
+		_queue_spill(queue);
+	}
 	dynarray_insert(queue->array,val);
 	return;
 }
@@ -106,11 +217,20 @@ void queue_enqueue(struct queue* queue, void* val) {
  *
  * Params:
  *   queue - the queue from which to query the front value.  May not be NULL.
+ *
+ * Return:
+ *   Returns the value at the front of the queue, or NULL if it is empty.
  */
 void* queue_front(struct queue* queue) {
 	/* 
 	 * FIXME:
 	 */
+	if (queue_isempty(queue)) {
+		return NULL; // Like queue_dequeue(), whether or not the array exists
+	}
+	if (!queue->array) {
+		return queue->small[queue->small_start];
+	}
 	void* queue_front = dynarray_get(queue->array, 0);
 	return queue_front;
 }
@@ -132,6 +252,12 @@ void* queue_dequeue(struct queue* queue) {
     if (queue_isempty(queue)) {
         return NULL; // Return NULL if the queue is empty
     }
+    if (!queue->array) {
+        void* value = queue->small[queue->small_start];
+        queue->small_start = (queue->small_start + 1) % QUEUE_SMALL_SLOTS;
+        queue->small_size--;
+        return value;
+    }
 
      void* front_value = dynarray_get_front(queue->array);  // get fromt element
     dynarray_remove_front(queue->array);  // remove fromt elemetn
@@ -151,5 +277,73 @@ void* queue_dequeue(struct queue* queue) {
  *   This function should return the value that was dequeued.
  */
 int queue_size(struct queue* queue) {
+    if (!queue->array) {
+        return queue->small_size;
+    }
     return dynarray_size(queue->array); // Return the size of the dynamic array
 }
+
+/*
+ * This function returns the number of values a given queue can hold before
+ * its underlying storage must be resized.
+ *
+ * Params:
+ *   queue - the queue whose capacity is being queried.  May not be NULL.
+ */
+int queue_capacity(struct queue* queue) {
+	if (!queue->array) {
+		return QUEUE_SMALL_SLOTS;
+	}
+	return dynarray_capacity(queue->array);
+}
+
+/*
+ * This function pre-sizes a given queue to hold at least `capacity` values
+ * without resizing, e.g. for an expected peak.  The queue will not shrink
+ * below this capacity as it drains.
+ *
+ * Params:
+ *   queue - the queue in which to reserve space.  May not be NULL.
+ *   capacity - the number of values to reserve space for.
+ */
+void queue_reserve(struct queue* queue, int capacity) {
+	if (!queue->array) {
+		if (capacity <= QUEUE_SMALL_SLOTS) {
+			return;
+		}
+		_queue_spill(queue);
+	}
+	dynarray_reserve(queue->array, capacity);
+}
+
+/*
+ * This function returns a value held in a given queue without removing it,
+ * counting from the front: index 0 is the front of the queue.  Together with
+ * queue_size() this allows walking the queue in order.
+ *
+ * Params:
+ *   queue - the queue to read from.  May not be NULL.
+ *   idx - the position to read.  Must be between 0 (inclusive) and the size
+ *     of the queue (exclusive).
+ */
+void* queue_get(struct queue* queue, int idx) {
+	if (!queue->array) {
+		return queue->small[(queue->small_start + idx) % QUEUE_SMALL_SLOTS];
+	}
+	return dynarray_get(queue->array, idx);
+}
+
+/*
+ * This function reports the memory held by a given queue: its structure and
+ * storage array, but not the values stored in it.  Empty slots in the array,
+ * or in the structure while it holds the values itself, count as reserved
+ * but not used.
+ *
+ * Params:
+ *   queue - the queue to report on.  May not be NULL.
+ *   out - filled in with the queue's memory use.  May not be NULL.
+ */
+void queue_mem_stats(struct queue* queue, struct mem_stats* out) {
+	int empty = queue_capacity(queue) - queue_size(queue);
+	memacct_stats(&queue->mem, empty * sizeof(void*), out);
+}
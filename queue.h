@@ -8,6 +8,8 @@
 #ifndef __QUEUE_H
 #define __QUEUE_H
 
+#include "memacct.h"
+
 /*
  * Structure used to represent a queue.
  */
@@ -18,12 +20,18 @@ struct queue;
  * about each of these functions.
  */
 struct queue* queue_create();
+struct queue* queue_create_with(const struct allocator* allocator);
 void queue_free(struct queue* queue);
+void queue_clear_async(struct queue* queue);
 int queue_isempty(struct queue* queue);
 void queue_enqueue(struct queue* queue, void* val);
 void* queue_front(struct queue* queue);
 void* queue_dequeue(struct queue* queue);
 int queue_size(struct queue* queue); 
+int queue_capacity(struct queue* queue);
+void queue_reserve(struct queue* queue, int capacity);
+void* queue_get(struct queue* queue, int idx);
+void queue_mem_stats(struct queue* queue, struct mem_stats* out);
 
 
 #endif
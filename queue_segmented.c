@@ -0,0 +1,327 @@
+/*
+ * This file contains a segmented implementation of the queue interface in
+ * queue.h.  Values are stored in a linked chain of fixed-size segments:
+ * enqueueing fills the tail segment and links a new one when it is full,
+ * and dequeueing drains the head segment and recycles it once it is empty.
+ * Unlike the dynamic array behind queue.c, nothing is ever copied to grow
+ * the queue, so every enqueue is O(1) in the worst case, not just on
+ * average.  Emptied segments are kept on a free list (up to a limit) so a
+ * queue that keeps filling and draining stops calling malloc() entirely.
+ *
+ * Link against queue_segmented.o instead of queue.o and dynarray.o to use
+ * it (for example, `make QUEUE_OBJ=queue_segmented.o`); the interface and
+ * its semantics are the same.  See the documentation in queue.c for the
+ * individual functions.
+ *
+ * As in queue.c, a queue keeps its first few values inside its own
+ * structure and only allocates a segment once it holds more, which matters
+ * all the more here since a segment is 4 KB.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "queue.h"
+#include "reclaim.h"
+
+/*
+ * A segment is one 4 KB block: a next pointer and 511 value slots.
+ */
+#define SEGMENT_SLOTS 511
+#define SEGMENT_FREE_MAX 16
+#define QUEUE_SMALL_SLOTS 4
+
+/*
+ * This structure is used to represent a single segment.
+ */
+struct segment {
+  struct segment* next;
+  void* vals[SEGMENT_SLOTS];
+};
+
+/*
+ * This structure is used to represent a queue.  Values occupy
+ * head->vals[head_idx] through tail->vals[tail_idx - 1], following the chain
+ * of segments from `head` to `tail`.  Until the queue first holds more
+ * than QUEUE_SMALL_SLOTS values, `head` and `tail` are NULL and the values
+ * occupy a ring in `small` starting at small[small_start].
+ */
+struct queue {
+  struct segment* head;
+  struct segment* tail;
+  int head_idx;
+  int tail_idx;
+  int size;
+  int segments;          // Segments in the chain, not counting the free list
+  struct segment* free_list;
+  int free_count;
+  int free_max;          // Longest the free list may get
+  void* small[QUEUE_SMALL_SLOTS];
+  int small_start;
+  struct memacct mem;    // Memory held by the queue and its segments
+};
+
+/*
+ * Auxilliary functions to take a segment from the free list (or allocate
+ * one) and to give a segment back to the free list (or free it).
+ */
+static struct segment* _segment_get(struct queue* queue) {
+  struct segment* seg = queue->free_list;
+  if (seg) {
+    queue->free_list = seg->next;
+    queue->free_count--;
+  } else {
+    seg = memacct_alloc(&queue->mem, sizeof(struct segment));
+  }
+  seg->next = NULL;
+  return seg;
+}
+
+static void _segment_put(struct queue* queue, struct segment* seg) {
+  if (queue->free_count < queue->free_max) {
+    seg->next = queue->free_list;
+    queue->free_list = seg;
+    queue->free_count++;
+  } else {
+    memacct_free(&queue->mem, seg, sizeof(struct segment));
+  }
+}
+
+/*
+ * Auxilliary function to move the values of a queue in small mode into its
+ * first segment.
+ */
+static void _queue_spill(struct queue* queue) {
+  queue->head = queue->tail = _segment_get(queue);
+  queue->segments = 1;
+  for (int i = 0; i < queue->size; i++) {
+    queue->head->vals[i] =
+      queue->small[(queue->small_start + i) % QUEUE_SMALL_SLOTS];
+  }
+  queue->head_idx = 0;
+  queue->tail_idx = queue->size;
+  queue->small_start = 0;
+}
+
+struct queue* queue_create() {
+  return queue_create_with(NULL);
+}
+
+struct queue* queue_create_with(const struct allocator* allocator) {
+  struct memacct mem;
+  memacct_init(&mem, allocator);
+  struct queue* queue = memacct_alloc(&mem, sizeof(struct queue));
+  queue->mem = mem;
+  queue->free_list = NULL;
+  queue->free_count = 0;
+  queue->free_max = SEGMENT_FREE_MAX;
+  queue->head = queue->tail = NULL;
+  queue->head_idx = queue->tail_idx = 0;
+  queue->size = 0;
+  queue->segments = 0;
+  queue->small_start = 0;
+  return queue;
+}
+
+/*
+ * Like queue_free() in queue.c, this frees the values still stored in the
+ * queue along with the queue itself.
+ */
+void queue_free(struct queue* queue) {
+  assert(queue);
+  while (!queue_isempty(queue)) {
+    free(queue_dequeue(queue));
+  }
+  if (queue->head) {
+    memacct_free(&queue->mem, queue->head, sizeof(struct segment));
+  }
+  while (queue->free_list) {
+    struct segment* next = queue->free_list->next;
+    memacct_free(&queue->mem, queue->free_list, sizeof(struct segment));
+    queue->free_list = next;
+  }
+  struct memacct mem = queue->mem;
+  memacct_free(&mem, queue, sizeof(struct queue));
+}
+
+static int _queue_reclaim_step(void* arg, int batch) {
+  struct queue* detached = arg;
+  while (batch-- > 0 && !queue_isempty(detached)) {
+    free(queue_dequeue(detached));
+  }
+  if (!queue_isempty(detached)) {
+    return 1;
+  }
+  queue_free(detached);
+  return 0;
+}
+
+/*
+ * As in queue.c, the segments (and the free list) are detached in a copy
+ * of the queue structure and the queue starts again in small mode.
+ */
+void queue_clear_async(struct queue* queue) {
+  assert(queue);
+  if (!queue->head) {
+    while (queue->size > 0) {
+      free(queue_dequeue(queue));
+    }
+    return;
+  }
+  struct memacct mem;
+  memacct_init(&mem, &queue->mem.allocator);
+  struct queue* detached = memacct_alloc(&mem, sizeof(struct queue));
+  *detached = *queue;
+  detached->mem = mem;
+  memacct_move(&queue->mem, &detached->mem,
+    queue->mem.reserved - sizeof(struct queue));
+
+  queue->free_list = NULL;
+  queue->free_count = 0;
+  queue->head = queue->tail = NULL;
+  queue->head_idx = queue->tail_idx = 0;
+  queue->size = 0;
+  queue->segments = 0;
+  reclaim_defer(_queue_reclaim_step, detached);
+}
+
+int queue_isempty(struct queue* queue) {
+  assert(queue);
+  return queue->size == 0;
+}
+
+void queue_enqueue(struct queue* queue, void* val) {
+  assert(queue);
+  if (!queue->head) {
+    if (queue->size < QUEUE_SMALL_SLOTS) {
+      queue->small[(queue->small_start + queue->size) % QUEUE_SMALL_SLOTS] = val;
+      queue->size++;
+      return;
+    }
+    _queue_spill(queue);
+  }
+  if (queue->tail_idx == SEGMENT_SLOTS) {
+    struct segment* seg = _segment_get(queue);
+    queue->tail->next = seg;
+    queue->tail = seg;
+    queue->tail_idx = 0;
+    queue->segments++;
+  }
+  queue->tail->vals[queue->tail_idx++] = val;
+  queue->size++;
+}
+
+void* queue_front(struct queue* queue) {
+  assert(queue);
+  if (queue->size == 0) {
+    return NULL; // As in queue.c
+  }
+  if (!queue->head) {
+    return queue->small[queue->small_start];
+  }
+  return queue->head->vals[queue->head_idx];
+}
+
+void* queue_dequeue(struct queue* queue) {
+  assert(queue);
+  if (queue->size == 0) {
+    return NULL;
+  }
+  if (!queue->head) {
+    void* val = queue->small[queue->small_start];
+    queue->small_start = (queue->small_start + 1) % QUEUE_SMALL_SLOTS;
+    queue->size--;
+    return val;
+  }
+
+  void* val = queue->head->vals[queue->head_idx++];
+  queue->size--;
+
+  if (queue->size == 0) {
+    /*
+     * The queue is empty, so rewind to the start of the (single) segment
+     * rather than moving on to a new one.
+     */
+    queue->head_idx = queue->tail_idx = 0;
+  } else if (queue->head_idx == SEGMENT_SLOTS) {
+    struct segment* done = queue->head;
+    queue->head = done->next;
+    queue->head_idx = 0;
+    queue->segments--;
+    _segment_put(queue, done);
+  }
+  return val;
+}
+
+int queue_size(struct queue* queue) {
+  assert(queue);
+  return queue->size;
+}
+
+/*
+ * The capacity of a segmented queue is the number of slots it can fill
+ * without calling malloc(): the unused part of the chain plus the free list.
+ */
+int queue_capacity(struct queue* queue) {
+  assert(queue);
+  if (!queue->head) {
+    return QUEUE_SMALL_SLOTS;
+  }
+  return queue->size + (SEGMENT_SLOTS - queue->tail_idx) +
+    queue->free_count * SEGMENT_SLOTS;
+}
+
+/*
+ * Reserving space fills the free list with enough segments for `capacity`
+ * values and lets it grow that long, so the queue can reach that size (and
+ * drain and refill) without calling malloc() or free().
+ */
+void queue_reserve(struct queue* queue, int capacity) {
+  assert(queue && capacity >= 0);
+  if (!queue->head) {
+    if (capacity <= QUEUE_SMALL_SLOTS) {
+      return;
+    }
+    _queue_spill(queue);
+  }
+  int needed = (capacity + SEGMENT_SLOTS - 1) / SEGMENT_SLOTS;
+  if (needed > queue->free_max) {
+    queue->free_max = needed;
+  }
+  while (queue_capacity(queue) < capacity) {
+    struct segment* seg = memacct_alloc(&queue->mem, sizeof(struct segment));
+    seg->next = queue->free_list;
+    queue->free_list = seg;
+    queue->free_count++;
+  }
+}
+
+void* queue_get(struct queue* queue, int idx) {
+  assert(queue && idx >= 0 && idx < queue->size);
+  if (!queue->head) {
+    return queue->small[(queue->small_start + idx) % QUEUE_SMALL_SLOTS];
+  }
+  idx += queue->head_idx;
+  struct segment* seg = queue->head;
+  while (idx >= SEGMENT_SLOTS) {
+    seg = seg->next;
+    idx -= SEGMENT_SLOTS;
+  }
+  return seg->vals[idx];
+}
+
+/*
+ * Empty slots in the chain and whole segments on the free list count as
+ * reserved but not used, as do empty slots in the structure in small mode.
+ */
+void queue_mem_stats(struct queue* queue, struct mem_stats* out) {
+  assert(queue && out);
+  if (!queue->head) {
+    memacct_stats(&queue->mem,
+      (size_t)(QUEUE_SMALL_SLOTS - queue->size) * sizeof(void*), out);
+    return;
+  }
+  size_t empty = (size_t)(queue->segments * SEGMENT_SLOTS - queue->size) *
+    sizeof(void*) + (size_t)queue->free_count * sizeof(struct segment);
+  memacct_stats(&queue->mem, empty, out);
+}
@@ -0,0 +1,136 @@
+/*
+ * This file contains an implementation of deferred reclamation.  A
+ * container that is cleared detaches its contents in O(1) time and hands
+ * them here together with a step function that frees them a batch at a
+ * time.  A single background thread, started the first time it is needed,
+ * runs the steps of each detached structure in turn.  Between batches it
+ * yields the CPU, so a foreground thread that needs the processor (or the
+ * allocator, which both threads are hitting) isn't held up for long.
+ *
+ * Nothing waits for the background thread when the process exits: memory
+ * still waiting to be freed goes back to the system with the rest.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "reclaim.h"
+
+/*
+ * This structure is used to represent a detached structure waiting to be
+ * freed.
+ */
+struct reclaim_job {
+  int (*step)(void* arg, int batch);
+  void* arg;
+  struct reclaim_job* next;
+};
+
+/*
+ * The reclaimer's state, shared by every caller in the process.  `pending`
+ * counts jobs queued or running.
+ */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t drained = PTHREAD_COND_INITIALIZER;
+static struct reclaim_job* head = NULL;
+static struct reclaim_job* tail = NULL;
+static long pending = 0;
+static int started = 0;
+
+/*
+ * Auxilliary function run by the background thread: takes jobs in the
+ * order they were deferred and steps each one until it is done.
+ */
+static void* _reclaim_run(void* unused) {
+  (void)unused;
+  pthread_mutex_lock(&lock);
+  for (;;) {
+    while (!head) {
+      pthread_cond_wait(&queued, &lock);
+    }
+    struct reclaim_job* job = head;
+    head = job->next;
+    if (!head) {
+      tail = NULL;
+    }
+    pthread_mutex_unlock(&lock);
+
+    while (job->step(job->arg, RECLAIM_BATCH)) {
+      sched_yield();
+    }
+    free(job);
+
+    pthread_mutex_lock(&lock);
+    if (--pending == 0) {
+      pthread_cond_broadcast(&drained);
+    }
+  }
+  return NULL;
+}
+
+/*
+ * This function hands a detached structure to the background thread to be
+ * freed, starting the thread if it isn't running yet.
+ *
+ * Params:
+ *   step - frees up to `batch` of the structure's values each time it is
+ *     called, and returns 1 while there is more to free.  Once nothing is
+ *     left it frees the structure itself (and `arg`, if need be) and
+ *     returns 0.  It is called on the background thread, so it may touch
+ *     nothing the caller goes on using without a lock.
+ *   arg - passed to every call of `step`.
+ */
+void reclaim_defer(int (*step)(void* arg, int batch), void* arg) {
+  assert(step);
+  struct reclaim_job* job = malloc(sizeof(struct reclaim_job));
+  assert(job);
+  job->step = step;
+  job->arg = arg;
+  job->next = NULL;
+
+  pthread_mutex_lock(&lock);
+  if (!started) {
+    pthread_t thread;
+    int err = pthread_create(&thread, NULL, _reclaim_run, NULL);
+    assert(err == 0);
+    pthread_detach(thread);
+    started = 1;
+  }
+  if (tail) {
+    tail->next = job;
+  } else {
+    head = job;
+  }
+  tail = job;
+  pending++;
+  pthread_cond_signal(&queued);
+  pthread_mutex_unlock(&lock);
+}
+
+/*
+ * This function waits until everything deferred so far has been freed,
+ * e.g. before checking memory use.
+ */
+void reclaim_wait() {
+  pthread_mutex_lock(&lock);
+  while (pending > 0) {
+    pthread_cond_wait(&drained, &lock);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+/*
+ * This function returns the number of structures deferred but not yet
+ * completely freed.
+ */
+long reclaim_pending() {
+  pthread_mutex_lock(&lock);
+  long n = pending;
+  pthread_mutex_unlock(&lock);
+  return n;
+}
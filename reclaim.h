@@ -0,0 +1,25 @@
+/*
+ * This file contains the definition of the interface for deferred
+ * reclamation: freeing large structures on a background thread so the
+ * thread that is done with them doesn't have to wait.  You can find
+ * descriptions of the reclamation functions, including their parameters
+ * and their return values, in reclaim.c.
+ */
+
+#ifndef __RECLAIM_H
+#define __RECLAIM_H
+
+/*
+ * Number of values a reclamation step is asked to free at a time.
+ */
+#define RECLAIM_BATCH 4096
+
+/*
+ * Deferred reclamation interface function prototypes.  Refer to reclaim.c
+ * for documentation about each of these functions.
+ */
+void reclaim_defer(int (*step)(void* arg, int batch), void* arg);
+void reclaim_wait();
+long reclaim_pending();
+
+#endif
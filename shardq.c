@@ -0,0 +1,266 @@
+/*
+ * This file contains an implementation of a sharded queue.  Each shard is a
+ * small circular buffer with its own lock, padded to its own cache lines, so
+ * threads working on different shards never touch the same memory.
+ *
+ * Every value is stamped with the monotonic clock when it is enqueued.  Each
+ * thread enqueues into a "home" shard assigned on its first call, so under
+ * normal use one thread's values all land in one shard.  A dequeuer samples
+ * SHARDQ_SAMPLES shards at random (without locking, by reading each shard's
+ * published head stamp) and removes the head with the oldest stamp.
+ *
+ * Ordering guarantees:
+ *   - Each shard is strictly FIFO, so values enqueued by one thread are
+ *     dequeued in the order that thread enqueued them.
+ *   - Across threads, order is only approximately FIFO: the value returned
+ *     is the oldest among the sampled heads, not necessarily the oldest in
+ *     the queue.  With random two-choice sampling the expected rank error
+ *     grows with the number of shards, not with the number of values.
+ *   - No value is lost or returned twice, and shardq_dequeue() only returns
+ *     NULL after scanning every shard and finding each one empty.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "shardq.h"
+#include "timeutil.h"
+
+#define SHARDQ_INIT_CAPACITY 16
+#define SHARDQ_SAMPLES 2
+#define SHARDQ_EMPTY UINT64_MAX
+
+/*
+ * This structure is used to represent a single stamped value.
+ */
+struct entry {
+  uint64_t stamp;
+  void* val;
+};
+
+/*
+ * This structure is used to represent a single shard.  `head_stamp` is the
+ * stamp of the value at the front of the shard, or SHARDQ_EMPTY, and is
+ * read without the lock by dequeuers choosing a shard.
+ */
+struct shard {
+  pthread_mutex_t lock;
+  struct entry* data;
+  int size;
+  int capacity;
+  int start;
+  uint64_t head_stamp;
+} __attribute__((aligned(128)));
+
+/*
+ * This structure is used to represent an entire sharded queue.
+ */
+struct shardq {
+  struct shard* shards;
+  int n;
+  int size;
+};
+
+/*
+ * Each thread's home shard and sampling state.  `home` is -1 until the
+ * thread first enqueues.
+ */
+static __thread int home = -1;
+static __thread uint32_t rng;
+static int next_home = 0;
+
+/*
+ * This function allocates and initializes a new, empty sharded queue and
+ * returns a pointer to it.
+ *
+ * Params:
+ *   shards - the number of shards.  A good choice is the number of threads
+ *     that will use the queue, or the number of CPUs.  Must be positive.
+ */
+struct shardq* shardq_create(int shards) {
+  assert(shards > 0);
+  struct shardq* sq = malloc(sizeof(struct shardq));
+  assert(sq);
+  int rc = posix_memalign((void**)&sq->shards, 128,
+    shards * sizeof(struct shard));
+  assert(rc == 0);
+  sq->n = shards;
+  sq->size = 0;
+
+  for (int i = 0; i < shards; i++) {
+    struct shard* s = &sq->shards[i];
+    pthread_mutex_init(&s->lock, NULL);
+    s->data = malloc(SHARDQ_INIT_CAPACITY * sizeof(struct entry));
+    assert(s->data);
+    s->size = 0;
+    s->capacity = SHARDQ_INIT_CAPACITY;
+    s->start = 0;
+    s->head_stamp = SHARDQ_EMPTY;
+  }
+  return sq;
+}
+
+/*
+ * This function frees the memory associated with a sharded queue.  Freeing
+ * any memory associated with values still stored in the queue is the
+ * responsibility of the caller.
+ *
+ * Params:
+ *   sq - the sharded queue to be destroyed.  May not be NULL.
+ */
+void shardq_free(struct shardq* sq) {
+  assert(sq);
+  for (int i = 0; i < sq->n; i++) {
+    pthread_mutex_destroy(&sq->shards[i].lock);
+    free(sq->shards[i].data);
+  }
+  free(sq->shards);
+  free(sq);
+}
+
+/*
+ * Auxilliary function to double the capacity of a shard's buffer.  The
+ * shard's lock must be held.
+ */
+static void _shard_grow(struct shard* s) {
+  struct entry* data = malloc(2 * s->capacity * sizeof(struct entry));
+  assert(data);
+  for (int i = 0; i < s->size; i++) {
+    data[i] = s->data[(s->start + i) % s->capacity];
+  }
+  free(s->data);
+  s->data = data;
+  s->capacity *= 2;
+  s->start = 0;
+}
+
+/*
+ * This function enqueues a new value into the calling thread's home shard.
+ *
+ * Params:
+ *   sq - the sharded queue into which to enqueue a value.  May not be NULL.
+ *   val - the value to be enqueued.
+ */
+void shardq_enqueue(struct shardq* sq, void* val) {
+  assert(sq);
+  if (home < 0) {
+    home = __atomic_fetch_add(&next_home, 1, __ATOMIC_RELAXED);
+    rng = 2654435761u * (home + 1);
+  }
+  struct shard* s = &sq->shards[home % sq->n];
+
+  pthread_mutex_lock(&s->lock);
+  if (s->size == s->capacity) {
+    _shard_grow(s);
+  }
+  struct entry* e = &s->data[(s->start + s->size) % s->capacity];
+  e->stamp = (uint64_t)now_ns();
+  e->val = val;
+  if (s->size++ == 0) {
+    __atomic_store_n(&s->head_stamp, e->stamp, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&s->lock);
+  __atomic_add_fetch(&sq->size, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Auxilliary function to remove the head of a shard if it has one.
+ *
+ * Return:
+ *   Returns 1 and stores the head value in `*val` on success, or 0 if the
+ *   shard was empty.
+ */
+static int _shard_take(struct shardq* sq, struct shard* s, void** val) {
+  pthread_mutex_lock(&s->lock);
+  if (s->size == 0) {
+    pthread_mutex_unlock(&s->lock);
+    return 0;
+  }
+  *val = s->data[s->start].val;
+  s->start = (s->start + 1) % s->capacity;
+  s->size--;
+  __atomic_store_n(&s->head_stamp,
+    s->size ? s->data[s->start].stamp : SHARDQ_EMPTY, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&s->lock);
+  __atomic_sub_fetch(&sq->size, 1, __ATOMIC_RELAXED);
+  return 1;
+}
+
+/*
+ * Auxilliary function returning a pseudo-random number from the calling
+ * thread's xorshift generator.
+ */
+static uint32_t _next_rand() {
+  if (rng == 0) {
+    rng = 2463534242u;
+  }
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+/*
+ * This function dequeues the oldest value among a random sample of shards.
+ * If every sampled shard is empty, all shards are scanned oldest-first.
+ *
+ * Params:
+ *   sq - the sharded queue from which to dequeue a value.  May not be NULL.
+ *
+ * Return:
+ *   Returns the dequeued value, or NULL if every shard was empty.
+ */
+void* shardq_dequeue(struct shardq* sq) {
+  assert(sq);
+  void* val;
+
+  struct shard* best = NULL;
+  uint64_t best_stamp = SHARDQ_EMPTY;
+  for (int i = 0; i < SHARDQ_SAMPLES; i++) {
+    struct shard* s = &sq->shards[_next_rand() % sq->n];
+    uint64_t stamp = __atomic_load_n(&s->head_stamp, __ATOMIC_ACQUIRE);
+    if (stamp < best_stamp) {
+      best = s;
+      best_stamp = stamp;
+    }
+  }
+  if (best && _shard_take(sq, best, &val)) {
+    return val;
+  }
+
+  /*
+   * The sample came up empty (or lost a race), so fall back to a full scan,
+   * retrying until a take succeeds or every shard reads as empty.
+   */
+  for (;;) {
+    best = NULL;
+    best_stamp = SHARDQ_EMPTY;
+    for (int i = 0; i < sq->n; i++) {
+      uint64_t stamp = __atomic_load_n(&sq->shards[i].head_stamp,
+        __ATOMIC_ACQUIRE);
+      if (stamp < best_stamp) {
+        best = &sq->shards[i];
+        best_stamp = stamp;
+      }
+    }
+    if (!best) {
+      return NULL;
+    }
+    if (_shard_take(sq, best, &val)) {
+      return val;
+    }
+  }
+}
+
+/*
+ * This function returns the number of values in a sharded queue.  The value
+ * is exact when no other thread is using the queue.
+ */
+int shardq_size(struct shardq* sq) {
+  assert(sq);
+  return __atomic_load_n(&sq->size, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,27 @@
+/*
+ * This file contains the definition of the interface for a sharded queue, a
+ * thread-safe, approximately-FIFO queue split into independently locked
+ * sub-queues.  You can find descriptions of the sharded queue functions,
+ * including their parameters, their return values and the ordering
+ * guarantees they provide, in shardq.c.
+ */
+
+#ifndef __SHARDQ_H
+#define __SHARDQ_H
+
+/*
+ * Structure used to represent a sharded queue.
+ */
+struct shardq;
+
+/*
+ * Sharded queue interface function prototypes.  Refer to shardq.c for
+ * documentation about each of these functions.
+ */
+struct shardq* shardq_create(int shards);
+void shardq_free(struct shardq* sq);
+void shardq_enqueue(struct shardq* sq, void* val);
+void* shardq_dequeue(struct shardq* sq);
+int shardq_size(struct shardq* sq);
+
+#endif
@@ -0,0 +1,474 @@
+/*
+ * This file contains an implementation of a bounded queue of calls that
+ * lives in POSIX shared memory, so an intake process and any number of
+ * agent processes can exchange calls.
+ *
+ * Nothing in the segment is a pointer, since each process maps it at a
+ * different address.  Calls are copied in and out as fixed-size records
+ * (only the fields that mean something in another process), slots are
+ * found by their index from an offset stored in the header, and every
+ * position is a 64-bit ticket.  Each slot carries a sequence number, as in
+ * Dmitry Vyukov's bounded MPMC queue: a producer or consumer claims a
+ * ticket with one compare-and-swap and then waits for nobody, so several
+ * intake and agent processes can share one ring.
+ *
+ * A consumer that finds the ring empty, or a producer that finds it full,
+ * sleeps on a futex word in the segment that the other side bumps after
+ * each operation.  The other side only makes the wake-up system call when
+ * someone is actually asleep.  On systems without futexes the sleeper
+ * polls instead.
+ *
+ * A process that dies between claiming a ticket and finishing the copy
+ * leaves its slot unusable, and the ring stalls once the tickets wrap
+ * around to it; recovering from that needs a fresh ring.
+ */
+
+#define _GNU_SOURCE // syscall()
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#include "shmring.h"
+#include "timeutil.h"
+
+#define SHMRING_MAGIC 0x43435247u // "CCRG"
+#define SHMRING_VERSION 1
+#define SHMRING_POLL_NS 50000
+#define SHMRING_DRAIN_NS 10000000 // Longest sleep while waiting to drain
+
+/*
+ * The part of a Call that is copied through the ring.
+ */
+struct record {
+  int id;
+  char caller_name[30];
+  char call_reason[100];
+  long long received_ns;
+};
+
+/*
+ * This structure is used to represent one slot.  `seq` equals the ticket
+ * of the producer allowed to fill the slot, that ticket plus one once it
+ * is full, and the ticket plus the capacity once a consumer has emptied it.
+ */
+struct slot {
+  uint64_t seq;
+  struct record rec;
+};
+
+/*
+ * This structure is used to represent one end of the ring.  `ticket` is the
+ * next position to claim.  `seq` is the futex word the other end sleeps on
+ * and is bumped after every operation at this end; `sleepers` counts the
+ * processes asleep waiting for this end to move.
+ */
+struct end {
+  uint64_t ticket;
+  uint32_t seq;
+  uint32_t sleepers;
+} __attribute__((aligned(64)));
+
+/*
+ * This structure is the header at the start of the segment.
+ */
+struct header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t capacity;      // Number of slots, a power of 2
+  uint32_t closed;        // Set once no more calls will be enqueued
+  uint64_t slots_offset;  // Offset of the first slot from the header
+  uint64_t size;          // Size of the whole segment
+  struct end tail;        // Producers' end
+  struct end head;        // Consumers' end
+};
+
+/*
+ * This structure is used to represent one process's mapping of the ring.
+ */
+struct shmring {
+  struct header* h;
+  struct slot* slots;
+};
+
+/*
+ * Auxilliary function to sleep until the futex word `addr` no longer holds
+ * `val`, the deadline passes, or a spurious wake-up happens.
+ */
+static void _wait(uint32_t* addr, uint32_t val, long long deadline) {
+  long long left = deadline < 0 ? SHMRING_POLL_NS * 1000LL : deadline - now_ns();
+  if (left <= 0) {
+    return;
+  }
+#if defined(__linux__)
+  struct timespec ts = { left / 1000000000, left % 1000000000 };
+  syscall(SYS_futex, addr, FUTEX_WAIT, val, deadline < 0 ? NULL : &ts,
+    NULL, 0);
+#else
+  struct timespec ts = { 0, left < SHMRING_POLL_NS ? left : SHMRING_POLL_NS };
+  if (__atomic_load_n(addr, __ATOMIC_ACQUIRE) == val) {
+    nanosleep(&ts, NULL);
+  }
+#endif
+}
+
+/*
+ * Auxilliary function to record that one end moved and wake the processes
+ * waiting for it, if there are any.
+ */
+static void _moved(struct end* e, int all) {
+  __atomic_add_fetch(&e->seq, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&e->sleepers, __ATOMIC_SEQ_CST) > 0) {
+#if defined(__linux__)
+    syscall(SYS_futex, &e->seq, FUTEX_WAKE, all ? INT_MAX : 1, NULL, NULL, 0);
+#endif
+  }
+}
+
+/*
+ * Auxilliary function to map a segment that has already been sized.
+ */
+static struct shmring* _map(int fd, size_t size) {
+  void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return NULL;
+  }
+  struct shmring* r = malloc(sizeof(struct shmring));
+  assert(r);
+  r->h = base;
+  r->slots = (struct slot*)((char*)base + r->h->slots_offset);
+  return r;
+}
+
+/*
+ * This function creates a ring with the given POSIX shared-memory name,
+ * replacing any left over from an earlier run.
+ *
+ * Params:
+ *   name - the shared-memory name, starting with '/'.  May not be NULL.
+ *   capacity - the number of calls the ring can hold.  It is rounded up to
+ *     a power of 2.  Must be positive.
+ *
+ * Return:
+ *   Returns the new ring, attached to the calling process, or NULL if the
+ *   segment could not be created.
+ */
+struct shmring* shmring_create(const char* name, int capacity) {
+  assert(capacity > 0);
+  uint32_t n = 1;
+  while (n < (uint32_t)capacity) {
+    n *= 2;
+  }
+  uint64_t offset = sizeof(struct header);
+  uint64_t size = offset + n * sizeof(struct slot);
+
+  shm_unlink(name);
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return NULL;
+  }
+  if (ftruncate(fd, size) < 0) {
+    close(fd);
+    shm_unlink(name);
+    return NULL;
+  }
+  void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(name);
+    return NULL;
+  }
+
+  struct header* h = base;
+  memset(h, 0, sizeof(struct header));
+  h->version = SHMRING_VERSION;
+  h->capacity = n;
+  h->slots_offset = offset;
+  h->size = size;
+  struct slot* slots = (struct slot*)((char*)base + offset);
+  for (uint32_t i = 0; i < n; i++) {
+    slots[i].seq = i;
+  }
+  __atomic_store_n(&h->magic, SHMRING_MAGIC, __ATOMIC_RELEASE);
+
+  struct shmring* r = malloc(sizeof(struct shmring));
+  assert(r);
+  r->h = h;
+  r->slots = slots;
+  return r;
+}
+
+/*
+ * This function attaches the calling process to an existing ring.
+ *
+ * Params:
+ *   name - the shared-memory name the ring was created with.  May not be
+ *     NULL.
+ *
+ * Return:
+ *   Returns the ring, or NULL if there is no such ring or it wasn't created
+ *   by a compatible version.
+ */
+struct shmring* shmring_attach(const char* name) {
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  /*
+   * Map just the header first to learn how big the whole segment is.
+   */
+  struct header* h = mmap(NULL, sizeof(struct header), PROT_READ, MAP_SHARED,
+    fd, 0);
+  if (h == MAP_FAILED) {
+    close(fd);
+    return NULL;
+  }
+  int ok = __atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) == SHMRING_MAGIC &&
+    h->version == SHMRING_VERSION;
+  size_t size = h->size;
+  munmap(h, sizeof(struct header));
+  if (!ok) {
+    close(fd);
+    return NULL;
+  }
+  return _map(fd, size);
+}
+
+/*
+ * This function detaches the calling process from a ring.  The ring itself
+ * stays until it is destroyed and every process has detached.
+ *
+ * Params:
+ *   r - the ring to detach from.  May not be NULL.
+ */
+void shmring_detach(struct shmring* r) {
+  munmap(r->h, r->h->size);
+  free(r);
+}
+
+/*
+ * This function detaches from a ring and removes its name, so no new
+ * process can attach.  Processes already attached keep working.
+ *
+ * Params:
+ *   r - the ring.  May not be NULL.
+ *   name - the shared-memory name the ring was created with.
+ */
+void shmring_destroy(struct shmring* r, const char* name) {
+  shmring_detach(r);
+  shm_unlink(name);
+}
+
+/*
+ * This function copies a call into the ring, waiting for a free slot if
+ * the ring is full.
+ *
+ * Params:
+ *   r - the ring.  May not be NULL.
+ *   call - the call to copy in.  Its timer and abandoned flag are not
+ *     copied.  May not be NULL.
+ *   timeout_ns - how long to wait for a free slot: 0 to try once, or a
+ *     negative value to wait for as long as it takes.
+ *
+ * Return:
+ *   Returns 1 if the call was enqueued or 0 if the ring stayed full.
+ */
+int shmring_enqueue(struct shmring* r, const Call* call, long long timeout_ns) {
+  struct header* h = r->h;
+  uint64_t mask = h->capacity - 1;
+  long long deadline = timeout_ns > 0 ? now_ns() + timeout_ns : -1;
+
+  for (;;) {
+    uint64_t pos = __atomic_load_n(&h->tail.ticket, __ATOMIC_RELAXED);
+    struct slot* s = &r->slots[pos & mask];
+    int64_t dif = (int64_t)(__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) - pos);
+
+    if (dif == 0) {
+      if (!__atomic_compare_exchange_n(&h->tail.ticket, &pos, pos + 1, 0,
+          __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        continue;
+      }
+      s->rec.id = call->id;
+      memcpy(s->rec.caller_name, call->caller_name, sizeof(s->rec.caller_name));
+      memcpy(s->rec.call_reason, call->call_reason, sizeof(s->rec.call_reason));
+      s->rec.received_ns = call->received_ns;
+      __atomic_store_n(&s->seq, pos + 1, __ATOMIC_RELEASE);
+      _moved(&h->tail, 0);
+      return 1;
+    }
+    if (dif > 0) {
+      continue; // Another producer claimed this ticket first
+    }
+
+    /*
+     * Full: sleep until a consumer frees a slot.  The sleeper count is
+     * raised before looking again, so a consumer finishing in between
+     * either is seen here or sees the sleeper and wakes it.
+     */
+    if (timeout_ns == 0 || (deadline >= 0 && now_ns() >= deadline)) {
+      return 0;
+    }
+    __atomic_add_fetch(&h->head.sleepers, 1, __ATOMIC_SEQ_CST);
+    uint32_t seen = __atomic_load_n(&h->head.seq, __ATOMIC_SEQ_CST);
+    pos = __atomic_load_n(&h->tail.ticket, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&r->slots[pos & mask].seq, __ATOMIC_SEQ_CST) < pos) {
+      _wait(&h->head.seq, seen, deadline);
+    }
+    __atomic_sub_fetch(&h->head.sleepers, 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+/*
+ * This function copies the call at the front of the ring out and removes
+ * it, waiting for a call if the ring is empty.
+ *
+ * Params:
+ *   r - the ring.  May not be NULL.
+ *   call - filled in with the call.  Its timer and abandoned flag are left
+ *     alone.  May not be NULL.
+ *   timeout_ns - how long to wait for a call: 0 to try once, or a negative
+ *     value to wait until a call arrives or the ring is closed.
+ *
+ * Return:
+ *   Returns 1 if a call was dequeued, or 0 if the wait timed out or the
+ *   ring is closed and empty.
+ */
+int shmring_dequeue(struct shmring* r, Call* call, long long timeout_ns) {
+  struct header* h = r->h;
+  uint64_t mask = h->capacity - 1;
+  long long deadline = timeout_ns > 0 ? now_ns() + timeout_ns : -1;
+
+  for (;;) {
+    uint64_t pos = __atomic_load_n(&h->head.ticket, __ATOMIC_RELAXED);
+    struct slot* s = &r->slots[pos & mask];
+    int64_t dif =
+      (int64_t)(__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+
+    if (dif == 0) {
+      if (!__atomic_compare_exchange_n(&h->head.ticket, &pos, pos + 1, 0,
+          __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        continue;
+      }
+      call->id = s->rec.id;
+      memcpy(call->caller_name, s->rec.caller_name, sizeof(s->rec.caller_name));
+      memcpy(call->call_reason, s->rec.call_reason, sizeof(s->rec.call_reason));
+      call->received_ns = s->rec.received_ns;
+      __atomic_store_n(&s->seq, pos + mask + 1, __ATOMIC_RELEASE);
+      _moved(&h->head, 0);
+      return 1;
+    }
+    if (dif > 0) {
+      continue; // Another consumer took this ticket first
+    }
+
+    /*
+     * Empty: give up if the ring is closed, otherwise sleep until a
+     * producer adds a call, as in shmring_enqueue().
+     */
+    if (__atomic_load_n(&h->closed, __ATOMIC_ACQUIRE) &&
+        __atomic_load_n(&h->tail.ticket, __ATOMIC_ACQUIRE) == pos) {
+      return 0;
+    }
+    if (timeout_ns == 0 || (deadline >= 0 && now_ns() >= deadline)) {
+      return 0;
+    }
+    __atomic_add_fetch(&h->tail.sleepers, 1, __ATOMIC_SEQ_CST);
+    uint32_t seen = __atomic_load_n(&h->tail.seq, __ATOMIC_SEQ_CST);
+    pos = __atomic_load_n(&h->head.ticket, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&r->slots[pos & mask].seq, __ATOMIC_SEQ_CST) < pos + 1 &&
+        !__atomic_load_n(&h->closed, __ATOMIC_SEQ_CST)) {
+      _wait(&h->tail.seq, seen, deadline);
+    }
+    __atomic_sub_fetch(&h->tail.sleepers, 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+/*
+ * This function marks the ring closed: once the calls already in it are
+ * gone, shmring_dequeue() returns 0 straight away instead of waiting.
+ * Every sleeping consumer is woken so it can notice.
+ *
+ * Params:
+ *   r - the ring.  May not be NULL.
+ */
+void shmring_close(struct shmring* r) {
+  __atomic_store_n(&r->h->closed, 1, __ATOMIC_SEQ_CST);
+  _moved(&r->h->tail, 1);
+}
+
+/*
+ * This function waits for consumers to take every call in the ring, so
+ * that a producer can remove the ring without losing calls no consumer
+ * has attached to collect yet.
+ *
+ * Params:
+ *   r - the ring.  May not be NULL.
+ *   timeout_ns - how long to wait: 0 to check once, or a negative value to
+ *     wait for as long as it takes.
+ *
+ * Return:
+ *   Returns the number of calls still in the ring, 0 once it has drained.
+ */
+int shmring_drain(struct shmring* r, long long timeout_ns) {
+  struct header* h = r->h;
+  long long deadline = timeout_ns > 0 ? now_ns() + timeout_ns : -1;
+
+  for (;;) {
+    /*
+     * As in shmring_enqueue(), the sleeper count is raised before looking,
+     * so a consumer taking the last call either is seen or wakes someone.
+     * Consumers wake only one sleeper, which may be a blocked producer
+     * instead, so sleep in slices of SHMRING_DRAIN_NS and look again.
+     */
+    __atomic_add_fetch(&h->head.sleepers, 1, __ATOMIC_SEQ_CST);
+    uint32_t seen = __atomic_load_n(&h->head.seq, __ATOMIC_SEQ_CST);
+    int left = shmring_size(r);
+    long long until = now_ns() + SHMRING_DRAIN_NS;
+    if (deadline >= 0 && deadline < until) {
+      until = deadline;
+    }
+    if (left > 0 && timeout_ns != 0) {
+      _wait(&h->head.seq, seen, until);
+    }
+    __atomic_sub_fetch(&h->head.sleepers, 1, __ATOMIC_SEQ_CST);
+    if (left == 0 || timeout_ns == 0 ||
+        (deadline >= 0 && now_ns() >= deadline)) {
+      return shmring_size(r);
+    }
+  }
+}
+
+/*
+ * This function returns the number of calls in the ring.  Under concurrent
+ * use the answer may be stale by the time it is returned.
+ *
+ * Params:
+ *   r - the ring.  May not be NULL.
+ */
+int shmring_size(struct shmring* r) {
+  uint64_t head = __atomic_load_n(&r->h->head.ticket, __ATOMIC_ACQUIRE);
+  uint64_t tail = __atomic_load_n(&r->h->tail.ticket, __ATOMIC_ACQUIRE);
+  return tail > head ? (int)(tail - head) : 0;
+}
+
+/*
+ * This function returns the number of calls the ring can hold.
+ *
+ * Params:
+ *   r - the ring.  May not be NULL.
+ */
+int shmring_capacity(struct shmring* r) {
+  return r->h->capacity;
+}
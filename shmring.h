@@ -0,0 +1,35 @@
+/*
+ * This file contains the definition of the interface for a queue of calls
+ * shared between processes.  You can find descriptions of the ring
+ * functions, including their parameters and their return values, in
+ * shmring.c.
+ */
+
+#ifndef __SHMRING_H
+#define __SHMRING_H
+
+#include "call.h"
+
+#define SHMRING_NAME "/callcenter.ring" // Default POSIX shared-memory name
+
+/*
+ * Structure used to represent one process's attachment to a ring.
+ */
+struct shmring;
+
+/*
+ * Shared ring interface function prototypes.  Refer to shmring.c for
+ * documentation about each of these functions.
+ */
+struct shmring* shmring_create(const char* name, int capacity);
+struct shmring* shmring_attach(const char* name);
+void shmring_detach(struct shmring* r);
+void shmring_destroy(struct shmring* r, const char* name);
+int shmring_enqueue(struct shmring* r, const Call* call, long long timeout_ns);
+int shmring_dequeue(struct shmring* r, Call* call, long long timeout_ns);
+void shmring_close(struct shmring* r);
+int shmring_drain(struct shmring* r, long long timeout_ns);
+int shmring_size(struct shmring* r);
+int shmring_capacity(struct shmring* r);
+
+#endif
@@ -0,0 +1,324 @@
+/*
+ * This file contains an implementation of a blocked Bloom filter and a
+ * count-min sketch, both of a size fixed when they are created however many
+ * keys go through them.
+ *
+ * The Bloom filter is split into 64-byte blocks, one cache line each.  A key
+ * picks one block with part of its hash and sets or tests all of its bits
+ * within that block with the rest, so each lookup touches a single cache
+ * line instead of one per bit.  The price is a false positive rate somewhat
+ * above that of a classic Bloom filter of the same size, since keys don't
+ * spread over blocks perfectly evenly; bloom_create() sizes the filter with
+ * some headroom for that.
+ *
+ * The count-min sketch is a few rows of counters; a key adds to one counter
+ * per row and its count is estimated as the smallest of those counters.
+ * Collisions can only inflate a counter, so estimates are never too low.
+ * Adding uses conservative update, raising only the counters that are at
+ * the minimum, which keeps the overestimates much smaller.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "sketch.h"
+
+#define BLOOM_BLOCK_WORDS 8   // 64-bit words per block: 512 bits
+#define BLOOM_MAX_K 16
+#define CMS_MAX_DEPTH 8
+
+/*
+ * This structure is used to represent a blocked Bloom filter.
+ */
+struct bloom {
+  uint64_t* words;
+  uint64_t blocks;
+  int k;  // Bits set per key
+};
+
+/*
+ * This structure is used to represent a count-min sketch.  Counters are
+ * stored row after row; `mask` selects a column, as the width is a power
+ * of 2.
+ */
+struct cms {
+  uint32_t* counters;
+  uint64_t mask;
+  int depth;
+};
+
+/*
+ * Auxilliary function to scramble the bits of a 64-bit value (the MurmurHash3
+ * finalizer).
+ */
+static uint64_t _mix64(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+/*
+ * This function computes a 64-bit hash of a key, reading it 8 bytes at a
+ * time.  It is fast and well mixed, but not meant to resist deliberate
+ * collisions.
+ *
+ * Params:
+ *   key - the bytes of the key.
+ *   len - the length of the key in bytes.
+ *
+ * Return:
+ *   Returns the hash.
+ */
+uint64_t sketch_hash(const void* key, size_t len) {
+  const unsigned char* p = key;
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ (len * 0x100000001b3ULL);
+  while (len >= 8) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    h = (h ^ _mix64(w)) * 0x9fb21c651e98df25ULL;
+    p += 8;
+    len -= 8;
+  }
+  uint64_t w = 0;
+  memcpy(&w, p, len);
+  return _mix64(h ^ w);
+}
+
+/*
+ * This function creates an empty Bloom filter.
+ *
+ * Params:
+ *   capacity - the number of distinct keys the filter is sized for.  Must
+ *     be positive.
+ *   fp_rate - the chance wanted that a key never added is reported as seen,
+ *     once `capacity` keys have been added.  Between 0 and 1.
+ *
+ * Return:
+ *   Returns a pointer to the new filter.
+ */
+struct bloom* bloom_create(long capacity, double fp_rate) {
+  assert(capacity > 0 && fp_rate > 0 && fp_rate < 1);
+  struct bloom* b = malloc(sizeof(struct bloom));
+  assert(b);
+
+  /*
+   * The classic sizing, with a fifth more bits to make up for blocking.
+   */
+  double bits_per_key = -log(fp_rate) / (log(2) * log(2)) * 1.2;
+  b->k = (int)(bits_per_key / 1.2 * log(2) + 0.5);
+  b->k = b->k < 1 ? 1 : b->k > BLOOM_MAX_K ? BLOOM_MAX_K : b->k;
+  b->blocks = (uint64_t)(capacity * bits_per_key / 512) + 1;
+  b->words = calloc(b->blocks * BLOOM_BLOCK_WORDS, sizeof(uint64_t));
+  assert(b->words);
+  return b;
+}
+
+/*
+ * This function frees the memory associated with a Bloom filter.
+ *
+ * Params:
+ *   b - the filter to be destroyed.  May not be NULL.
+ */
+void bloom_free(struct bloom* b) {
+  assert(b);
+  free(b->words);
+  free(b);
+}
+
+/*
+ * Auxilliary function to test, and if `set` is given set, the bits of a key.
+ * The block is chosen from the top half of the hash by multiplying rather
+ * than dividing; each bit position within the block takes 9 bits from a
+ * remixed copy of the hash, drawing a fresh one every 7 bits.
+ */
+static int _bloom_probe(struct bloom* b, uint64_t hash, int set) {
+  uint64_t* block = b->words +
+    ((hash >> 32) * b->blocks >> 32) * BLOOM_BLOCK_WORDS;
+  uint64_t seed = hash, bits = _mix64(seed);
+  int present = 1;
+  for (int i = 0; i < b->k; i++) {
+    if (i > 0 && i % 7 == 0) {
+      seed += 0x9e3779b97f4a7c15ULL; // 7 * 9 bits used up; draw more
+      bits = _mix64(seed);
+    }
+    int pos = bits & 511;
+    bits >>= 9;
+    uint64_t bit = 1ULL << (pos & 63);
+    present &= (block[pos >> 6] & bit) != 0;
+    if (set) {
+      block[pos >> 6] |= bit;
+    }
+  }
+  return present;
+}
+
+/*
+ * This function adds a key to a Bloom filter.
+ *
+ * Params:
+ *   b - the filter.  May not be NULL.
+ *   hash - the key's hash, from sketch_hash().
+ *
+ * Return:
+ *   Returns 1 if the key had probably been added before, or 0 if it
+ *   certainly hadn't.
+ */
+int bloom_add(struct bloom* b, uint64_t hash) {
+  assert(b);
+  return _bloom_probe(b, hash, 1);
+}
+
+/*
+ * This function tests whether a key has been added to a Bloom filter,
+ * without adding it.
+ *
+ * Params:
+ *   b - the filter.  May not be NULL.
+ *   hash - the key's hash, from sketch_hash().
+ *
+ * Return:
+ *   Returns 1 if the key has probably been added, or 0 if it certainly
+ *   hasn't.
+ */
+int bloom_contains(struct bloom* b, uint64_t hash) {
+  assert(b);
+  return _bloom_probe(b, hash, 0);
+}
+
+/*
+ * This function empties a Bloom filter.
+ */
+void bloom_clear(struct bloom* b) {
+  assert(b);
+  memset(b->words, 0, b->blocks * BLOOM_BLOCK_WORDS * sizeof(uint64_t));
+}
+
+/*
+ * This function returns the memory a Bloom filter takes, in bytes.
+ */
+size_t bloom_bytes(struct bloom* b) {
+  assert(b);
+  return sizeof(struct bloom) + b->blocks * BLOOM_BLOCK_WORDS * sizeof(uint64_t);
+}
+
+/*
+ * This function creates an empty count-min sketch.
+ *
+ * Params:
+ *   epsilon - how far off estimates may be, as a share of the total count
+ *     added.  The width of the sketch is e / epsilon, rounded up to a power
+ *     of 2.
+ *   delta - the chance that an estimate is further off than that.  The
+ *     depth of the sketch is ln(1 / delta), at most CMS_MAX_DEPTH.
+ *
+ * Return:
+ *   Returns a pointer to the new sketch.
+ */
+struct cms* cms_create(double epsilon, double delta) {
+  assert(epsilon > 0 && delta > 0 && delta < 1);
+  struct cms* c = malloc(sizeof(struct cms));
+  assert(c);
+
+  uint64_t width = 1;
+  while (width < exp(1) / epsilon) {
+    width *= 2;
+  }
+  c->mask = width - 1;
+  c->depth = (int)ceil(log(1 / delta));
+  c->depth = c->depth < 1 ? 1 : c->depth > CMS_MAX_DEPTH ? CMS_MAX_DEPTH : c->depth;
+  c->counters = calloc(width * c->depth, sizeof(uint32_t));
+  assert(c->counters);
+  return c;
+}
+
+/*
+ * This function frees the memory associated with a count-min sketch.
+ *
+ * Params:
+ *   c - the sketch to be destroyed.  May not be NULL.
+ */
+void cms_free(struct cms* c) {
+  assert(c);
+  free(c->counters);
+  free(c);
+}
+
+/*
+ * Auxilliary function to find a key's counter in each row, deriving one
+ * column per row from two halves of the hash.
+ */
+static void _cms_cells(struct cms* c, uint64_t hash, uint32_t** cells) {
+  uint64_t h1 = hash, h2 = _mix64(hash) | 1;
+  for (int i = 0; i < c->depth; i++) {
+    cells[i] = &c->counters[(uint64_t)i * (c->mask + 1) + ((h1 + i * h2) & c->mask)];
+  }
+}
+
+/*
+ * This function counts one occurrence of a key in a count-min sketch.
+ *
+ * Params:
+ *   c - the sketch.  May not be NULL.
+ *   hash - the key's hash, from sketch_hash().
+ *
+ * Return:
+ *   Returns the key's estimated count, including this occurrence.
+ */
+uint32_t cms_add(struct cms* c, uint64_t hash) {
+  assert(c);
+  uint32_t* cells[CMS_MAX_DEPTH];
+  _cms_cells(c, hash, cells);
+
+  uint32_t min = *cells[0];
+  for (int i = 1; i < c->depth; i++) {
+    min = *cells[i] < min ? *cells[i] : min;
+  }
+  min++;
+  for (int i = 0; i < c->depth; i++) {
+    if (*cells[i] < min) {
+      *cells[i] = min;
+    }
+  }
+  return min;
+}
+
+/*
+ * This function estimates how many times a key has been counted in a
+ * count-min sketch.  The estimate is never too low.
+ *
+ * Params:
+ *   c - the sketch.  May not be NULL.
+ *   hash - the key's hash, from sketch_hash().
+ */
+uint32_t cms_estimate(struct cms* c, uint64_t hash) {
+  assert(c);
+  uint32_t* cells[CMS_MAX_DEPTH];
+  _cms_cells(c, hash, cells);
+
+  uint32_t min = *cells[0];
+  for (int i = 1; i < c->depth; i++) {
+    min = *cells[i] < min ? *cells[i] : min;
+  }
+  return min;
+}
+
+/*
+ * This function sets every count in a count-min sketch back to 0.
+ */
+void cms_clear(struct cms* c) {
+  assert(c);
+  memset(c->counters, 0, (c->mask + 1) * c->depth * sizeof(uint32_t));
+}
+
+/*
+ * This function returns the memory a count-min sketch takes, in bytes.
+ */
+size_t cms_bytes(struct cms* c) {
+  assert(c);
+  return sizeof(struct cms) + (c->mask + 1) * c->depth * sizeof(uint32_t);
+}
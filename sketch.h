@@ -0,0 +1,43 @@
+/*
+ * This file contains the definition of the interface for two fixed-size
+ * probabilistic summaries of a stream of keys: a blocked Bloom filter,
+ * which says whether a key has probably been seen before, and a count-min
+ * sketch, which estimates how many times each key has been seen.  Keys are
+ * hashed once with sketch_hash() and the hash is passed to both.  You can
+ * find descriptions of the functions, including their parameters and their
+ * return values, in sketch.c.
+ */
+
+#ifndef __SKETCH_H
+#define __SKETCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Structures used to represent a Bloom filter and a count-min sketch.
+ */
+struct bloom;
+struct cms;
+
+/*
+ * Sketch interface function prototypes.  Refer to sketch.c for
+ * documentation about each of these functions.
+ */
+uint64_t sketch_hash(const void* key, size_t len);
+
+struct bloom* bloom_create(long capacity, double fp_rate);
+void bloom_free(struct bloom* b);
+int bloom_add(struct bloom* b, uint64_t hash);
+int bloom_contains(struct bloom* b, uint64_t hash);
+void bloom_clear(struct bloom* b);
+size_t bloom_bytes(struct bloom* b);
+
+struct cms* cms_create(double epsilon, double delta);
+void cms_free(struct cms* c);
+uint32_t cms_add(struct cms* c, uint64_t hash);
+uint32_t cms_estimate(struct cms* c, uint64_t hash);
+void cms_clear(struct cms* c);
+size_t cms_bytes(struct cms* c);
+
+#endif
@@ -0,0 +1,281 @@
+/*
+ * This file contains an implementation of a skip list.  Every entry sits in
+ * a sorted linked list at level 0; an entry is also linked in at level 1
+ * with probability 1/4, at level 2 with probability 1/16, and so on, so a
+ * search can skip over long runs of entries at the upper levels and only
+ * walk a few at each level on the way down.  Keys may repeat: entries with
+ * equal keys are kept in the order they were inserted.
+ *
+ * Each node is allocated with exactly as many forward pointers as its
+ * level, so an index of n entries takes about 1.33 pointers per entry on
+ * top of the key and value.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "skiplist.h"
+
+#define SKIPLIST_MAX_LEVEL 16
+
+/*
+ * This structure is used to represent a single entry.  `next[i]` is the
+ * following entry among those linked in at level i.
+ */
+struct skipnode {
+  long long key;
+  void* val;
+  int level;
+  struct skipnode* next[];
+};
+
+/*
+ * This structure is used to represent a skip list.  `head` is a sentinel
+ * with a forward pointer at every level; `level` is the number of levels
+ * currently in use.
+ */
+struct skiplist {
+  struct skipnode* head;
+  int level;
+  int size;
+  unsigned int seed;  // State of the random level generator
+};
+
+/*
+ * Auxilliary function to allocate a node with `level` forward pointers.
+ */
+static struct skipnode* _skipnode_create(long long key, void* val, int level) {
+  struct skipnode* node =
+    malloc(sizeof(struct skipnode) + level * sizeof(struct skipnode*));
+  assert(node);
+  node->key = key;
+  node->val = val;
+  node->level = level;
+  return node;
+}
+
+/*
+ * This function allocates and initializes a new, empty skip list and returns
+ * a pointer to it.
+ */
+struct skiplist* skiplist_create() {
+  struct skiplist* sl = malloc(sizeof(struct skiplist));
+  assert(sl);
+  sl->head = _skipnode_create(0, NULL, SKIPLIST_MAX_LEVEL);
+  for (int i = 0; i < SKIPLIST_MAX_LEVEL; i++) {
+    sl->head->next[i] = NULL;
+  }
+  sl->level = 1;
+  sl->size = 0;
+  sl->seed = 0x2545f491u;
+  return sl;
+}
+
+/*
+ * This function frees the memory associated with a skip list.  The values
+ * stored in it are not freed; they belong to the caller.
+ *
+ * Params:
+ *   sl - the skip list to be destroyed.  May not be NULL.
+ */
+void skiplist_free(struct skiplist* sl) {
+  assert(sl);
+  struct skipnode* next, * curr = sl->head;
+  while (curr) {
+    next = curr->next[0];
+    free(curr);
+    curr = next;
+  }
+  free(sl);
+}
+
+/*
+ * Auxilliary function to pick the level of a new node: each level above the
+ * first is reached with probability 1/4.
+ */
+static int _skiplist_random_level(struct skiplist* sl) {
+  unsigned int x = sl->seed; // xorshift32
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  sl->seed = x;
+
+  int level = 1;
+  while ((x & 3) == 0 && level < SKIPLIST_MAX_LEVEL) {
+    level++;
+    x >>= 2;
+  }
+  return level;
+}
+
+/*
+ * Auxilliary function to find, at every level, the last node whose key is
+ * less than `key` (or, if `after_equal` is set, no greater than `key`).
+ * These are the nodes whose forward pointers an insertion or removal at
+ * `key` has to update.
+ */
+static void _skiplist_predecessors(struct skiplist* sl, long long key,
+    int after_equal, struct skipnode** update) {
+  struct skipnode* curr = sl->head;
+  for (int i = sl->level - 1; i >= 0; i--) {
+    while (curr->next[i] && (curr->next[i]->key < key ||
+        (after_equal && curr->next[i]->key == key))) {
+      curr = curr->next[i];
+    }
+    update[i] = curr;
+  }
+}
+
+/*
+ * This function inserts a value into a skip list under a given key.  If
+ * entries with an equal key are already present, the new entry goes after
+ * them.
+ *
+ * Params:
+ *   sl - the skip list.  May not be NULL.
+ *   key - the key to file the value under.
+ *   val - the value.
+ */
+void skiplist_insert(struct skiplist* sl, long long key, void* val) {
+  assert(sl);
+  struct skipnode* update[SKIPLIST_MAX_LEVEL];
+  _skiplist_predecessors(sl, key, 1, update);
+
+  int level = _skiplist_random_level(sl);
+  for (int i = sl->level; i < level; i++) {
+    update[i] = sl->head;
+  }
+  if (level > sl->level) {
+    sl->level = level;
+  }
+
+  struct skipnode* node = _skipnode_create(key, val, level);
+  for (int i = 0; i < level; i++) {
+    node->next[i] = update[i]->next[i];
+    update[i]->next[i] = node;
+  }
+  sl->size++;
+}
+
+/*
+ * This function removes the entry with a given key and value from a skip
+ * list.  Both are needed because keys may repeat.
+ *
+ * Params:
+ *   sl - the skip list.  May not be NULL.
+ *   key - the key of the entry to remove.
+ *   val - the value of the entry to remove.
+ *
+ * Return:
+ *   Returns 1 if an entry was removed, or 0 if there was none.
+ */
+int skiplist_remove(struct skiplist* sl, long long key, void* val) {
+  assert(sl);
+  struct skipnode* update[SKIPLIST_MAX_LEVEL];
+  _skiplist_predecessors(sl, key, 0, update);
+
+  /*
+   * The predecessors found lead to the first entry with this key; step
+   * along equal keys to the one holding `val`, keeping the predecessors at
+   * each of its levels up to date on the way.
+   */
+  struct skipnode* node = update[0]->next[0];
+  while (node && node->key == key && node->val != val) {
+    for (int i = 0; i < node->level; i++) {
+      update[i] = node;
+    }
+    node = node->next[0];
+  }
+  if (!node || node->key != key) {
+    return 0;
+  }
+
+  for (int i = 0; i < node->level; i++) {
+    update[i]->next[i] = node->next[i];
+  }
+  free(node);
+  while (sl->level > 1 && sl->head->next[sl->level - 1] == NULL) {
+    sl->level--;
+  }
+  sl->size--;
+  return 1;
+}
+
+/*
+ * This function returns the first entry in a skip list whose key is not
+ * less than a given key, from which the entries can be walked in order with
+ * skiplist_next().  This is the starting point for a range query.
+ *
+ * Params:
+ *   sl - the skip list.  May not be NULL.
+ *   key - the smallest key wanted.
+ *
+ * Return:
+ *   Returns the entry, or NULL if every key is less than `key`.
+ */
+struct skipnode* skiplist_seek(struct skiplist* sl, long long key) {
+  assert(sl);
+  struct skipnode* curr = sl->head;
+  for (int i = sl->level - 1; i >= 0; i--) {
+    while (curr->next[i] && curr->next[i]->key < key) {
+      curr = curr->next[i];
+    }
+  }
+  return curr->next[0];
+}
+
+/*
+ * This function returns the value of the first entry in a skip list with a
+ * given key.
+ *
+ * Params:
+ *   sl - the skip list.  May not be NULL.
+ *   key - the key to look up.
+ *
+ * Return:
+ *   Returns the value, or NULL if no entry has that key.
+ */
+void* skiplist_find(struct skiplist* sl, long long key) {
+  struct skipnode* node = skiplist_seek(sl, key);
+  return node && node->key == key ? node->val : NULL;
+}
+
+/*
+ * This function returns the entry with the smallest key in a skip list, or
+ * NULL if it is empty.
+ */
+struct skipnode* skiplist_first(struct skiplist* sl) {
+  assert(sl);
+  return sl->head->next[0];
+}
+
+/*
+ * This function returns the entry following a given one in key order, or
+ * NULL if it is the last.  The skip list must not have been changed since
+ * `node` was obtained.
+ */
+struct skipnode* skiplist_next(struct skipnode* node) {
+  assert(node);
+  return node->next[0];
+}
+
+/*
+ * These functions return the key and the value of an entry.
+ */
+long long skiplist_key(struct skipnode* node) {
+  assert(node);
+  return node->key;
+}
+
+void* skiplist_value(struct skipnode* node) {
+  assert(node);
+  return node->val;
+}
+
+/*
+ * This function returns the number of entries in a skip list.
+ */
+int skiplist_size(struct skiplist* sl) {
+  assert(sl);
+  return sl->size;
+}
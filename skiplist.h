@@ -0,0 +1,38 @@
+/*
+ * This file contains the definition of the interface for a skip list, an
+ * ordered index from integer keys to values with O(log n) expected lookup,
+ * insertion and removal, and in-order iteration.  You can find descriptions
+ * of the skip list functions, including their parameters and their return
+ * values, in skiplist.c.
+ */
+
+#ifndef __SKIPLIST_H
+#define __SKIPLIST_H
+
+/*
+ * Structure used to represent a skip list.
+ */
+struct skiplist;
+
+/*
+ * Structure used to represent a position in a skip list, for iterating.
+ */
+struct skipnode;
+
+/*
+ * Skip list interface function prototypes.  Refer to skiplist.c for
+ * documentation about each of these functions.
+ */
+struct skiplist* skiplist_create();
+void skiplist_free(struct skiplist* sl);
+void skiplist_insert(struct skiplist* sl, long long key, void* val);
+int skiplist_remove(struct skiplist* sl, long long key, void* val);
+void* skiplist_find(struct skiplist* sl, long long key);
+struct skipnode* skiplist_seek(struct skiplist* sl, long long key);
+struct skipnode* skiplist_first(struct skiplist* sl);
+struct skipnode* skiplist_next(struct skipnode* node);
+long long skiplist_key(struct skipnode* node);
+void* skiplist_value(struct skipnode* node);
+int skiplist_size(struct skiplist* sl);
+
+#endif
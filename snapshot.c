@@ -0,0 +1,288 @@
+/*
+ * This file contains the mechanisms that let supervisors read the state of
+ * the call center while agents keep changing it.  Readers never take a lock
+ * and never make a writer wait.
+ *
+ * The summary is protected by a seqlock: the writer makes the sequence
+ * number odd, copies the new summary in, and makes it even again.  A reader
+ * copies the summary out between two reads of the sequence number and
+ * retries if they differ or were odd.  Writers are never delayed by
+ * readers; a reader only retries while a write is in progress.
+ *
+ * Full snapshots are published by swapping a pointer.  The old snapshot
+ * can't be freed right away, since a reader may still be walking it, so it
+ * is retired and freed later using epoch-based reclamation: each reader
+ * announces the global epoch when it enters, the writer tags each retired
+ * snapshot with the epoch at which it was replaced and then advances the
+ * epoch, and a retired snapshot is freed once every reader inside is from a
+ * later epoch.
+ *
+ * Both mechanisms assume a single writer.  With several writers (e.g.
+ * agents answering calls on different threads), publish while holding the
+ * lock that already serializes changes to the queue and stack.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snapshot.h"
+
+#define READER_INACTIVE 0UL
+
+/*
+ * This structure is used to represent one registered reader, on its own
+ * cache line so readers don't slow each other down.
+ */
+struct reader {
+  unsigned long epoch;  // Epoch the reader entered in, or READER_INACTIVE
+  char pad[64 - sizeof(unsigned long)];
+};
+
+/*
+ * This structure is used to represent a snapshot waiting to be freed.
+ */
+struct retired {
+  struct cc_snapshot* snap;
+  unsigned long epoch;
+  struct retired* next;
+};
+
+/*
+ * This structure is used to represent a board.
+ */
+struct board {
+  unsigned long seq;
+  struct cc_summary summary;
+
+  struct cc_snapshot* current;
+  unsigned long epoch;  // Starts at 1; 0 marks an inactive reader
+  struct retired* retired;
+  int n_retired;
+
+  struct reader* readers;
+  int max_readers;
+  int n_readers;
+};
+
+/*
+ * This function allocates and initializes a new board and returns a pointer
+ * to it.  The summary starts zeroed and there is no snapshot.
+ *
+ * Params:
+ *   max_readers - the most reader threads that will register.
+ */
+struct board* board_create(int max_readers) {
+  assert(max_readers > 0);
+  struct board* b = calloc(1, sizeof(struct board));
+  assert(b);
+  b->readers = calloc(max_readers, sizeof(struct reader));
+  assert(b->readers);
+  b->max_readers = max_readers;
+  b->epoch = 1;
+  return b;
+}
+
+/*
+ * This function frees a board along with its current and retired
+ * snapshots.  No reader may be using the board when it is freed.
+ *
+ * Params:
+ *   b - the board to be destroyed.  May not be NULL.
+ */
+void board_free(struct board* b) {
+  assert(b);
+  while (b->retired) {
+    struct retired* next = b->retired->next;
+    snapshot_free(b->retired->snap);
+    free(b->retired);
+    b->retired = next;
+  }
+  snapshot_free(b->current);
+  free(b->readers);
+  free(b);
+}
+
+/*
+ * This function publishes a new summary.  Only the single writer may call
+ * it.
+ *
+ * Params:
+ *   b - the board.  May not be NULL.
+ *   sum - the summary to publish.  May not be NULL.
+ */
+void board_publish_summary(struct board* b, const struct cc_summary* sum) {
+  assert(b && sum);
+  unsigned long seq = __atomic_load_n(&b->seq, __ATOMIC_RELAXED);
+  __atomic_store_n(&b->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(&b->summary, sum, sizeof(struct cc_summary));
+  __atomic_store_n(&b->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * This function reads a consistent copy of the current summary.  Any number
+ * of threads may call it at once.
+ *
+ * Params:
+ *   b - the board.  May not be NULL.
+ *   sum - filled in with the summary.  May not be NULL.
+ */
+void board_read_summary(struct board* b, struct cc_summary* sum) {
+  assert(b && sum);
+  unsigned long before, after;
+  do {
+    before = __atomic_load_n(&b->seq, __ATOMIC_ACQUIRE);
+    if (before & 1) {
+      continue;
+    }
+    memcpy(sum, &b->summary, sizeof(struct cc_summary));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    after = __atomic_load_n(&b->seq, __ATOMIC_RELAXED);
+  } while ((before & 1) || before != after);
+}
+
+/*
+ * Auxilliary function to free every retired snapshot that no active reader
+ * can still be using.
+ */
+static void _board_reclaim(struct board* b) {
+  unsigned long oldest = ~0UL;
+  int n = __atomic_load_n(&b->n_readers, __ATOMIC_ACQUIRE);
+  for (int i = 0; i < n; i++) {
+    unsigned long e = __atomic_load_n(&b->readers[i].epoch, __ATOMIC_SEQ_CST);
+    if (e != READER_INACTIVE && e < oldest) {
+      oldest = e;
+    }
+  }
+
+  struct retired** link = &b->retired;
+  while (*link) {
+    struct retired* r = *link;
+    if (r->epoch < oldest) {
+      *link = r->next;
+      snapshot_free(r->snap);
+      free(r);
+      b->n_retired--;
+    } else {
+      link = &r->next;
+    }
+  }
+}
+
+/*
+ * This function publishes a new full snapshot, taking ownership of it.  The
+ * snapshot it replaces is freed as soon as no reader can still be using it.
+ * Only the single writer may call it.
+ *
+ * Params:
+ *   b - the board.  May not be NULL.
+ *   snap - the snapshot to publish, e.g. from snapshot_build().
+ */
+void board_publish_snapshot(struct board* b, struct cc_snapshot* snap) {
+  assert(b);
+  struct cc_snapshot* old = __atomic_exchange_n(&b->current, snap,
+    __ATOMIC_SEQ_CST);
+  if (old) {
+    struct retired* r = malloc(sizeof(struct retired));
+    assert(r);
+    r->snap = old;
+    r->epoch = __atomic_load_n(&b->epoch, __ATOMIC_SEQ_CST);
+    r->next = b->retired;
+    b->retired = r;
+    b->n_retired++;
+  }
+  __atomic_add_fetch(&b->epoch, 1, __ATOMIC_SEQ_CST);
+  _board_reclaim(b);
+}
+
+/*
+ * This function registers a new reader thread and returns its reader number,
+ * to be passed to board_snapshot_enter() and board_snapshot_exit().
+ */
+int board_reader_register(struct board* b) {
+  assert(b);
+  int reader = __atomic_fetch_add(&b->n_readers, 1, __ATOMIC_ACQ_REL);
+  assert(reader < b->max_readers);
+  return reader;
+}
+
+/*
+ * This function gives a reader access to the current snapshot.  The
+ * snapshot stays valid until the reader calls board_snapshot_exit().
+ *
+ * Params:
+ *   b - the board.  May not be NULL.
+ *   reader - the caller's reader number.
+ *
+ * Return:
+ *   Returns the current snapshot, or NULL if none has been published.
+ */
+const struct cc_snapshot* board_snapshot_enter(struct board* b, int reader) {
+  assert(b && reader >= 0 && reader < b->max_readers);
+  unsigned long epoch = __atomic_load_n(&b->epoch, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&b->readers[reader].epoch, epoch, __ATOMIC_SEQ_CST);
+  return __atomic_load_n(&b->current, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * This function ends a reader's access to the snapshot it entered.
+ */
+void board_snapshot_exit(struct board* b, int reader) {
+  assert(b && reader >= 0 && reader < b->max_readers);
+  __atomic_store_n(&b->readers[reader].epoch, READER_INACTIVE,
+    __ATOMIC_RELEASE);
+}
+
+/*
+ * This function returns the number of retired snapshots not yet freed.
+ */
+int board_retired(struct board* b) {
+  assert(b);
+  return b->n_retired;
+}
+
+/*
+ * This function copies the waiting calls in a queue and the most recently
+ * answered calls in a stack into a new snapshot.
+ *
+ * Params:
+ *   queue - the queue of waiting calls.  May not be NULL.
+ *   stack - the stack of answered calls, linked in by their `link`.  May
+ *     not be NULL.
+ *   max_answered - the most answered calls to copy.
+ */
+struct cc_snapshot* snapshot_build(struct queue* queue, struct istack* stack,
+    int max_answered) {
+  assert(queue && stack);
+  struct cc_snapshot* snap = malloc(sizeof(struct cc_snapshot));
+  assert(snap);
+
+  snap->n_waiting = queue_size(queue);
+  snap->waiting = malloc((snap->n_waiting + 1) * sizeof(Call));
+  assert(snap->waiting);
+  for (int i = 0; i < snap->n_waiting; i++) {
+    snap->waiting[i] = *(Call*)queue_get(queue, i);
+  }
+
+  int n = istack_size(stack);
+  snap->n_answered = n < max_answered ? n : max_answered;
+  snap->answered = malloc((snap->n_answered + 1) * sizeof(Call));
+  assert(snap->answered);
+  struct ilink* l = istack_top(stack);
+  for (int i = 0; i < snap->n_answered; i++, l = istack_next(stack, l)) {
+    snap->answered[i] = *CALL_OF_LINK(l);
+  }
+  return snap;
+}
+
+/*
+ * This function frees a snapshot.  `snap` may be NULL.
+ */
+void snapshot_free(struct cc_snapshot* snap) {
+  if (snap) {
+    free(snap->waiting);
+    free(snap->answered);
+    free(snap);
+  }
+}
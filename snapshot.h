@@ -0,0 +1,64 @@
+/*
+ * This file contains the definition of the interface for publishing the
+ * state of the call center to supervisors without blocking the agents.  You
+ * can find descriptions of the functions, including their parameters and
+ * their return values, in snapshot.c.
+ */
+
+#ifndef __SNAPSHOT_H
+#define __SNAPSHOT_H
+
+#include "call.h"
+#include "istack.h"
+#include "queue.h"
+
+/*
+ * A small, fixed-size summary of the call center, published under a
+ * seqlock.
+ */
+struct cc_summary {
+  int queue_size;
+  int stack_size;
+  int has_front;
+  Call front;       // First call waiting, if has_front
+  int has_top;
+  Call top;         // Last call answered, if has_top
+  long received;
+  long answered;
+};
+
+/*
+ * A full copy of the waiting calls and the most recently answered calls,
+ * published by pointer and reclaimed once no reader can still see it.
+ */
+struct cc_snapshot {
+  int n_waiting;
+  int n_answered;
+  Call* waiting;    // In queue order, front first
+  Call* answered;   // Most recent first
+};
+
+/*
+ * Structure used to represent the board supervisors read from.
+ */
+struct board;
+
+/*
+ * Interface function prototypes.  Refer to snapshot.c for documentation
+ * about each of these functions.
+ */
+struct board* board_create(int max_readers);
+void board_free(struct board* b);
+void board_publish_summary(struct board* b, const struct cc_summary* sum);
+void board_read_summary(struct board* b, struct cc_summary* sum);
+void board_publish_snapshot(struct board* b, struct cc_snapshot* snap);
+int board_reader_register(struct board* b);
+const struct cc_snapshot* board_snapshot_enter(struct board* b, int reader);
+void board_snapshot_exit(struct board* b, int reader);
+int board_retired(struct board* b);
+
+struct cc_snapshot* snapshot_build(struct queue* queue, struct istack* stack,
+    int max_answered);
+void snapshot_free(struct cc_snapshot* snap);
+
+#endif
@@ -10,21 +10,53 @@
  */
 
 #include <stdlib.h>
+#include <assert.h>
 
 #include "stack.h"
 #include "list.h"
+#include "reclaim.h"
+
+/*
+ * Number of values an unbounded stack holds inside its own structure
+ * before it allocates a linked list for them.
+ */
+#define STACK_SMALL_SLOTS 4
 
 /*
  * This is the structure that will be used to represent a stack.  This
  * structure specifically contains a single field representing a linked list
  * that should be used as the underlying data storage for the stack.
  *
- * You should not modify this structure.
+ * Until an unbounded stack first holds more than STACK_SMALL_SLOTS values,
+ * it keeps them in `small`, bottom first, and `list` is NULL.  Most stacks
+ * never get that deep, so they cost one allocation rather than one for the
+ * structure, one for the list and one per value.
  */
 struct stack {
   struct list* list;  //point of list
+  void* small[STACK_SMALL_SLOTS];
+  int small_count;    //number of values held in `small`
+  void** ring;        //bounded mode only: the most recent `bound` values
+  int bound;
+  int next;           //ring index the next push will write
+  int count;          //number of values held in the ring
+  void (*evict)(void* val, void* ctx);
+  void* evict_ctx;
+  struct memacct mem; //memory held by the stack and its list or ring
 };
 
+/*
+ * Auxilliary function to move the values of a stack in small mode into a
+ * new linked list, keeping their order.
+ */
+static void _stack_spill(struct stack* stack) {
+	stack->list = list_create_with(&stack->mem);
+	for (int i = 0; i < stack->small_count; i++) {
+		list_insert(stack->list, stack->small[i]);
+	}
+	stack->small_count = 0;
+}
+
 /*
  * This function should allocate and initialize a new, empty stack and return
  * a pointer to it.
@@ -33,12 +65,76 @@ struct stack* stack_create() {
 	/*
 	 * FIXME:
 	 */
-	struct stack* new_stack = malloc(sizeof(struct stack));  
-	new_stack->list = list_create();
+	return stack_create_with(NULL, 0);
+}
+
+/*
+ * This function allocates and initializes a new, empty bounded stack and
+ * returns a pointer to it.  A bounded stack keeps only the `n` most recently
+ * pushed values in a fixed ring: pushing onto a full bounded stack evicts
+ * the oldest value, so memory use stays flat however many values are pushed.
+ * Evicted values are passed to the stack's eviction callback (see
+ * stack_set_evict()), or freed with free() if no callback is set.
+ *
+ * Params:
+ *   n - the number of values to keep.  Must be positive.
+ */
+struct stack* stack_create_bounded(int n) {
+	assert(n > 0);
+	return stack_create_with(NULL, n);
+}
+
+/*
+ * This function allocates and initializes a new, empty stack that gets its
+ * own storage from the given allocator (see memacct.h).  Values stored in
+ * the stack are still the caller's to allocate and are freed with free().
+ *
+ * Params:
+ *   allocator - the allocator to use.  Copied.  May be NULL to use malloc()
+ *     and free().
+ *   n - the number of values to keep, as for stack_create_bounded(), or 0
+ *     for a stack without a bound.
+ */
+struct stack* stack_create_with(const struct allocator* allocator, int n) {
+	assert(n >= 0);
+	struct memacct mem;
+	memacct_init(&mem, allocator);
+	struct stack* new_stack = memacct_alloc(&mem, sizeof(struct stack));
+	new_stack->mem = mem;
+	if (n > 0) {
+		new_stack->list = NULL;
+		new_stack->ring = memacct_alloc(&new_stack->mem, n * sizeof(void*));
+	} else {
+		new_stack->list = NULL;
+		new_stack->ring = NULL;
+	}
+	new_stack->small_count = 0;
+	new_stack->bound = n;
+	new_stack->next = 0;
+	new_stack->count = 0;
+	new_stack->evict = NULL;
+	new_stack->evict_ctx = NULL;
 
 	return new_stack;
 }
 
+/*
+ * This function sets the function a bounded stack calls with each value it
+ * evicts, e.g. to free it or to export it elsewhere.  The callback takes
+ * ownership of the value.
+ *
+ * Params:
+ *   stack - the bounded stack.  May not be NULL.
+ *   evict - the eviction callback, or NULL to free evicted values.
+ *   ctx - passed through to every call of `evict`.
+ */
+void stack_set_evict(struct stack* stack, void (*evict)(void* val, void* ctx),
+		void* ctx) {
+	assert(stack);
+	stack->evict = evict;
+	stack->evict_ctx = ctx;
+}
+
 /*
  * This function should free the memory associated with a stack.  While this
  * function should up all memory used in the stack itself, it should not free
@@ -56,11 +152,76 @@ void stack_free(struct stack* stack) {
         void* value = stack_pop(stack); 
         free(value); 
     }
-	list_free(stack->list);
-	free(stack);
+	if (stack->ring) {
+		memacct_free(&stack->mem, stack->ring, stack->bound * sizeof(void*));
+	} else if (stack->list) {
+		list_free(stack->list);
+	}
+	struct memacct mem = stack->mem; //the stack can't free itself from itself
+	memacct_free(&mem, stack, sizeof(struct stack));
 	return;
 }
 
+/*
+ * Auxilliary function run by the reclaimer (see reclaim.c) on a stack
+ * detached by stack_clear_async(): frees up to `batch` values, and the
+ * stack itself once it is empty.
+ */
+static int _stack_reclaim_step(void* arg, int batch) {
+	struct stack* detached = arg;
+	while (batch-- > 0 && !stack_isempty(detached)) {
+		free(stack_pop(detached));
+	}
+	if (!stack_isempty(detached)) {
+		return 1;
+	}
+	stack_free(detached);
+	return 0;
+}
+
+/*
+ * This function empties a given stack in O(1) time.  Its values, which are
+ * freed with free() as by stack_free() (not passed to the eviction
+ * callback), are detached along with the list or ring holding them and
+ * freed later on a background thread, so clearing a stack of millions of
+ * calls doesn't stall the caller.  A bounded stack keeps its bound.  A
+ * stack still holding its values in its own structure just frees them.
+ *
+ * The stack's allocator, if it has one, is called from the background
+ * thread too, so it must be safe to call from more than one thread.
+ *
+ * Params:
+ *   stack - the stack to clear.  May not be NULL.
+ */
+void stack_clear_async(struct stack* stack) {
+	assert(stack);
+	if (!stack->ring && !stack->list) {
+		while (stack->small_count > 0) {
+			free(stack->small[--stack->small_count]);
+		}
+		return;
+	}
+	struct memacct mem;
+	memacct_init(&mem, &stack->mem.allocator);
+	struct stack* detached = memacct_alloc(&mem, sizeof(struct stack));
+	*detached = *stack;
+	detached->mem = mem;
+	detached->evict = NULL;
+	// Everything but the stack structure itself belongs to the list or ring
+	memacct_move(&stack->mem, &detached->mem,
+		stack->mem.reserved - sizeof(struct stack));
+
+	if (stack->ring) {
+		stack->ring = memacct_alloc(&stack->mem, stack->bound * sizeof(void*));
+		stack->next = 0;
+		stack->count = 0;
+	} else {
+		list_set_mem(detached->list, &detached->mem);
+		stack->list = NULL;
+	}
+	reclaim_defer(_stack_reclaim_step, detached);
+}
+
 /*
  * This function should indicate whether a given stack is currently empty.
  * Specifically, it should return 1 if the specified stack is empty (i.e.
@@ -73,6 +234,12 @@ int stack_isempty(struct stack* stack) {
 	/*
 	 * FIXME:
 	 */
+	if (stack->ring) {
+		return stack->count == 0;
+	}
+	if (!stack->list) {
+		return stack->small_count == 0;
+	}
 	int empty_check = list_isempty(stack->list);
 	return  empty_check;
 }
@@ -91,6 +258,32 @@ void stack_push(struct stack* stack, void* val) {
 	/*
 	 * FIXME:
 	 */
+	if (stack->ring) {
+		/*
+		 * When the ring is full, the slot about to be written holds the
+		 * oldest value, so evict it first.
+		 */
+		if (stack->count == stack->bound) {
+			void* oldest = stack->ring[stack->next];
+			if (stack->evict) {
+				stack->evict(oldest, stack->evict_ctx);
+			} else {
+				free(oldest);
+			}
+		} else {
+			stack->count++;
+		}
+		stack->ring[stack->next] = val;
+		stack->next = (stack->next + 1) % stack->bound;
+		return;
+	}
+	if (!stack->list) {
+		if (stack->small_count < STACK_SMALL_SLOTS) {
+			stack->small[stack->small_count++] = val;
+			return;
+		}
+		_stack_spill(stack);
+	}
 	list_insert(stack->list, val);
 
 
@@ -109,6 +302,9 @@ void* stack_top(struct stack* stack) {
 	/*
 	 * FIXME:
 	 */
+	if (stack->ring || !stack->list) {
+		return stack_get(stack, 0);
+	}
 	void* stack_top_value = top_value(stack->list);
 	return stack_top_value;
 }
@@ -127,6 +323,17 @@ void* stack_pop(struct stack* stack) {
 	/*
 	 * FIXME:
 	 */
+	if (stack->ring) {
+		if (stack->count == 0) {
+			return NULL;
+		}
+		stack->next = (stack->next + stack->bound - 1) % stack->bound;
+		stack->count--;
+		return stack->ring[stack->next];
+	}
+	if (!stack->list) {
+		return stack->small_count > 0 ? stack->small[--stack->small_count] : NULL;
+	}
 	void* value = pop_value(stack->list);
     
 	return value;
@@ -143,5 +350,63 @@ void* stack_pop(struct stack* stack) {
  *   This function should return the value that was popped.
  */
 int stack_size(struct stack* stack) {
+    if (stack->ring) {
+        return stack->count;
+    }
+    if (!stack->list) {
+        return stack->small_count;
+    }
     return list_size(stack->list); // Return the size of the linked list
 }
+
+/*
+ * This function returns a value held in a given stack without removing it,
+ * counting from the top: index 0 is the top, index 1 the value pushed just
+ * before it, and so on.  For a bounded stack this takes O(1) time, so the
+ * last n values can be walked with indices 0 to n - 1.  For an unbounded
+ * stack it takes O(idx) time.
+ *
+ * Params:
+ *   stack - the stack to read from.  May not be NULL.
+ *   idx - the position to read, counting from the top.
+ *
+ * Return:
+ *   Returns the value at position `idx`, or NULL if the stack holds no more
+ *   than `idx` values.
+ */
+void* stack_get(struct stack* stack, int idx) {
+    assert(stack && idx >= 0);
+    if (stack->ring) {
+        if (idx >= stack->count) {
+            return NULL;
+        }
+        return stack->ring[(stack->next + stack->bound - 1 - idx) % stack->bound];
+    }
+    if (!stack->list) {
+        return idx < stack->small_count ? stack->small[stack->small_count - 1 - idx] : NULL;
+    }
+    return list_get(stack->list, idx);
+}
+
+/*
+ * This function reports the memory held by a given stack: its structure and
+ * its list or ring, but not the values stored in it.  Empty slots in the
+ * ring, in the list's nodes, or in the structure while it holds the values
+ * itself, count as reserved but not used.
+ *
+ * Params:
+ *   stack - the stack to report on.  May not be NULL.
+ *   out - filled in with the stack's memory use.  May not be NULL.
+ */
+void stack_mem_stats(struct stack* stack, struct mem_stats* out) {
+    assert(stack && out);
+    size_t empty;
+    if (stack->ring) {
+        empty = (size_t)(stack->bound - stack->count) * sizeof(void*);
+    } else if (stack->list) {
+        empty = list_unused_bytes(stack->list);
+    } else {
+        empty = (size_t)(STACK_SMALL_SLOTS - stack->small_count) * sizeof(void*);
+    }
+    memacct_stats(&stack->mem, empty, out);
+}
@@ -8,6 +8,8 @@
 #ifndef __STACK_H
 #define __STACK_H
 
+#include "memacct.h"
+
 /*
  * Structure used to represent a stack.
  */
@@ -18,12 +20,19 @@ struct stack;
  * about each of these functions.
  */
 struct stack* stack_create();
+struct stack* stack_create_bounded(int n);
+struct stack* stack_create_with(const struct allocator* allocator, int n);
+void stack_set_evict(struct stack* stack, void (*evict)(void* val, void* ctx),
+    void* ctx);
 void stack_free(struct stack* stack);
+void stack_clear_async(struct stack* stack);
 int stack_isempty(struct stack* stack);
 void stack_push(struct stack* stack, void* val);
 void* stack_top(struct stack* stack);
 void* stack_pop(struct stack* stack);
 int stack_size(struct stack* stack); // Add this line to declare the function
+void* stack_get(struct stack* stack, int idx);
+void stack_mem_stats(struct stack* stack, struct mem_stats* out);
 
 
 #endif
@@ -0,0 +1,120 @@
+/*
+ * This file contains executable code for testing the admission controller
+ * on a simulated clock: the token bucket must refill at its rate and stop
+ * at its burst, the depth limit must be checked before the bucket, calls
+ * must become callbacks once the estimated wait is too long, and the
+ * service rate must only be sampled while calls were waiting.
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "admission.h"
+
+#define MS 1000000LL // Nanoseconds in a millisecond
+#define S 1000000000LL // Nanoseconds in a second
+
+/*
+ * Checks calls at time `now` with `depth` calls waiting until one isn't
+ * accepted, and returns how many were.
+ */
+int accepted_until_refused(struct admission* ac, int depth, long long now) {
+  int n = 0;
+  while (n < 1000 && admission_check(ac, depth, now) == ADMIT_ACCEPT) {
+    n++;
+  }
+  return n;
+}
+
+int main(int argc, char** argv) {
+  int ok = 1;
+
+  /*
+   * Token bucket: 10 calls/s in bursts of up to 3.
+   */
+  struct admission_config rate = { 10, 3, 0, 0 };
+  struct admission* ac = admission_create(&rate, 0);
+  int full = accepted_until_refused(ac, 0, 0);
+  int tenth = accepted_until_refused(ac, 0, 100 * MS);
+  int half_tenth = accepted_until_refused(ac, 0, 150 * MS);
+  int later = accepted_until_refused(ac, 0, 10 * S);
+  printf("== Accepted from a full bucket (expect 3): %d\n", full);
+  printf("== Accepted after 100 ms, then 50 ms more (expect 1 0): %d %d\n",
+    tenth, half_tenth);
+  printf("== Accepted after 10 s, capped at the burst (expect 3): %d\n", later);
+  printf("== Accepted and rejected so far (expect 7 4): %ld %ld\n",
+    admission_count(ac, ADMIT_ACCEPT), admission_count(ac, ADMIT_REJECT));
+  ok = ok && full == 3 && tenth == 1 && half_tenth == 0 && later == 3 &&
+    admission_count(ac, ADMIT_ACCEPT) == 7 &&
+    admission_count(ac, ADMIT_REJECT) == 4 &&
+    admission_count(ac, ADMIT_CALLBACK) == 0;
+  admission_free(ac);
+
+  /*
+   * A burst below one call is raised to one, or nothing would get in.
+   */
+  struct admission_config tiny = { 1, 0.2, 0, 0 };
+  ac = admission_create(&tiny, 0);
+  full = accepted_until_refused(ac, 0, 0);
+  later = accepted_until_refused(ac, 0, 1 * S);
+  printf("== Burst of 0.2 clamped to 1 (expect 1 1): %d %d\n", full, later);
+  ok = ok && full == 1 && later == 1;
+  admission_free(ac);
+
+  /*
+   * The depth limit is checked before the bucket, so a call turned away
+   * for depth doesn't use up a token.
+   */
+  struct admission_config depth = { 1, 1, 5, 0 };
+  ac = admission_create(&depth, 0);
+  int deep = admission_check(ac, 5, 0);
+  int deeper = admission_check(ac, 6, 0);
+  int shallow = admission_check(ac, 4, 0);
+  int no_token = admission_check(ac, 0, 0);
+  printf("== At and over the depth limit (expect %d %d): %d %d\n",
+    ADMIT_REJECT, ADMIT_REJECT, deep, deeper);
+  printf("== Under it, token kept, then used (expect %d %d): %d %d\n",
+    ADMIT_ACCEPT, ADMIT_REJECT, shallow, no_token);
+  ok = ok && deep == ADMIT_REJECT && deeper == ADMIT_REJECT &&
+    shallow == ADMIT_ACCEPT && no_token == ADMIT_REJECT &&
+    admission_count(ac, ADMIT_REJECT) == 3;
+  admission_free(ac);
+
+  /*
+   * Wait estimate: calls become callbacks once the depth times the time
+   * between answers is over 2 s.  Before the first sample there is no
+   * estimate, so everything is accepted.
+   */
+  struct admission_config wait = { 0, 0, 0, 2 };
+  ac = admission_create(&wait, 0);
+  int unmeasured = admission_check(ac, 1000, 0);
+  admission_served(ac, 10, 0);
+  admission_served(ac, 9, 500 * MS); // Half a second between answers
+  double est = admission_estimated_wait(ac, 4);
+  int at_limit = admission_check(ac, 4, 500 * MS);
+  int over = admission_check(ac, 5, 500 * MS);
+  printf("== Accepted before any answer (expect %d): %d\n", ADMIT_ACCEPT,
+    unmeasured);
+  printf("== Estimated wait behind 4 calls (expect 2.00): %.2f\n", est);
+  printf("== Behind 4 and 5 calls (expect %d %d): %d %d\n", ADMIT_ACCEPT,
+    ADMIT_CALLBACK, at_limit, over);
+  ok = ok && unmeasured == ADMIT_ACCEPT && fabs(est - 2) < 1e-9 &&
+    at_limit == ADMIT_ACCEPT && over == ADMIT_CALLBACK &&
+    admission_count(ac, ADMIT_CALLBACK) == 1;
+
+  /*
+   * An answer that empties the queue ends the backlog, so the idle gap to
+   * the next answer isn't sampled; the gap after that is, with weight 0.1.
+   */
+  admission_served(ac, 0, 1 * S);
+  admission_served(ac, 3, 100 * S);
+  double idle = admission_estimated_wait(ac, 10);
+  admission_served(ac, 2, 100 * S + 1500 * MS);
+  double busy = admission_estimated_wait(ac, 10);
+  printf("== Wait behind 10 after an idle gap (expect 5.00): %.2f\n", idle);
+  printf("== Wait behind 10 after a 1.5 s gap (expect 6.00): %.2f\n", busy);
+  ok = ok && fabs(idle - 5) < 1e-9 && fabs(busy - 6) < 1e-9;
+  admission_free(ac);
+
+  return ok ? 0 : 1;
+}
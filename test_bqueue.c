@@ -0,0 +1,224 @@
+/*
+ * This file contains executable code for testing the blocking queue: FIFO
+ * order, timeouts, consumers parked on an empty queue being woken by a
+ * batch or by closing the queue, and producer and consumer threads
+ * exchanging values without losing, duplicating or reordering any.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "bqueue.h"
+#include "timeutil.h"
+
+#define N_PRODUCERS 4
+#define N_CONSUMERS 4
+#define PER_PRODUCER 50000
+#define BATCH 16
+#define PARK_NS 50000000LL // Long enough for consumers to stop spinning
+#define WAKE_NS 5000000000LL // How long a woken consumer may take, at most
+
+/*
+ * Values encode producer * PER_PRODUCER + sequence number.
+ */
+int test_data[N_PRODUCERS * PER_PRODUCER];
+int seen[N_PRODUCERS * PER_PRODUCER];
+int in_order = 1;
+struct bqueue* bq;
+
+/*
+ * Results of a consumer that waits once for a single value.
+ */
+struct waiter {
+  pthread_t thread;
+  long long timeout_ns;
+  int* val;
+  long long woke_ns;
+};
+
+void* wait_once(void* arg) {
+  struct waiter* w = arg;
+  w->val = bqueue_dequeue_wait(bq, w->timeout_ns);
+  w->woke_ns = now_ns();
+  return NULL;
+}
+
+/*
+ * Starts `n` consumers that each wait for one value, and gives them time
+ * to park.
+ */
+void park(struct waiter* w, int n, long long timeout_ns) {
+  struct timespec pause = { 0, PARK_NS };
+  for (int i = 0; i < n; i++) {
+    w[i].timeout_ns = timeout_ns;
+    pthread_create(&w[i].thread, NULL, wait_once, &w[i]);
+  }
+  nanosleep(&pause, NULL);
+}
+
+/*
+ * Thread body of a producer: enqueues its values one at a time and in
+ * batches, alternately.
+ */
+void* producer(void* arg) {
+  int p = (int)(long)arg;
+  void* batch[BATCH];
+  int i = 0;
+  while (i < PER_PRODUCER) {
+    if ((i / BATCH) % 2 == 0 || PER_PRODUCER - i < BATCH) {
+      bqueue_enqueue(bq, &test_data[p * PER_PRODUCER + i]);
+      i++;
+    } else {
+      for (int k = 0; k < BATCH; k++) {
+        batch[k] = &test_data[p * PER_PRODUCER + i + k];
+      }
+      bqueue_enqueue_batch(bq, batch, BATCH);
+      i += BATCH;
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Thread body of a consumer: every value taken from one producer must come
+ * after the last value this consumer took from that producer.  Returns
+ * once the queue is closed and empty.
+ */
+void* consumer(void* arg) {
+  int last[N_PRODUCERS];
+  for (int p = 0; p < N_PRODUCERS; p++) {
+    last[p] = -1;
+  }
+  for (int* val; (val = bqueue_dequeue_wait(bq, -1));) {
+    int p = *val / PER_PRODUCER, i = *val % PER_PRODUCER;
+    if (i <= last[p]) {
+      in_order = 0;
+    }
+    last[p] = i;
+    __atomic_add_fetch(&seen[*val], 1, __ATOMIC_RELAXED);
+  }
+  return NULL;
+}
+
+int main(int argc, char** argv) {
+  int i, ok = 1;
+  struct waiter w[N_CONSUMERS];
+  pthread_t producers[N_PRODUCERS], consumers[N_CONSUMERS];
+
+  for (i = 0; i < N_PRODUCERS * PER_PRODUCER; i++) {
+    test_data[i] = i;
+  }
+
+  /*
+   * Single-threaded: values enqueued one at a time and in a batch come out
+   * in FIFO order.
+   */
+  bq = bqueue_create();
+  void* batch[5];
+  for (i = 0; i < 3; i++) {
+    bqueue_enqueue(bq, &test_data[i]);
+  }
+  for (i = 0; i < 5; i++) {
+    batch[i] = &test_data[3 + i];
+  }
+  bqueue_enqueue_batch(bq, batch, 5);
+  printf("== Size after 3 enqueues and a batch of 5 (expect 8): %d\n",
+    bqueue_size(bq));
+  int fifo = 1;
+  for (i = 0; i < 8; i++) {
+    if (*(int*)bqueue_dequeue_wait(bq, 0) != i) {
+      fifo = 0;
+    }
+  }
+  printf("== Single-thread FIFO (expect 1): %d\n", fifo);
+  ok = ok && fifo;
+
+  /*
+   * Timeouts: 0 doesn't wait at all, and a positive timeout gives up once
+   * it has passed.
+   */
+  long long start = now_ns();
+  void* none = bqueue_dequeue_wait(bq, 0);
+  long long waited = now_ns() - start;
+  printf("== Dequeue from empty, not waiting (expect 1 1): %d %d\n",
+    none == NULL, waited < PARK_NS);
+  ok = ok && none == NULL && waited < PARK_NS;
+  start = now_ns();
+  none = bqueue_dequeue_wait(bq, 20000000);
+  waited = now_ns() - start;
+  printf("== Dequeue from empty, waiting 20 ms (expect 1 1): %d %d\n",
+    none == NULL, waited >= 20000000);
+  ok = ok && none == NULL && waited >= 20000000;
+
+  /*
+   * Consumers parked on the empty queue are all woken by one batch, and
+   * each gets one of its values.
+   */
+  park(w, N_CONSUMERS, WAKE_NS);
+  for (i = 0; i < N_CONSUMERS; i++) {
+    batch[i] = &test_data[100 + i];
+  }
+  start = now_ns();
+  bqueue_enqueue_batch(bq, batch, N_CONSUMERS);
+  int woken = 0, sum = 0;
+  for (i = 0; i < N_CONSUMERS; i++) {
+    pthread_join(w[i].thread, NULL);
+    if (w[i].val && w[i].woke_ns - start < WAKE_NS / 2) {
+      woken++;
+      sum += *w[i].val;
+    }
+  }
+  printf("== Parked consumers woken by a batch (expect %d, sum %d): %d, sum %d\n",
+    N_CONSUMERS, 4 * 100 + 6, woken, sum);
+  ok = ok && woken == N_CONSUMERS && sum == 4 * 100 + 6;
+
+  /*
+   * Concurrent: nothing lost or duplicated, per-producer order kept.
+   */
+  for (i = 0; i < N_CONSUMERS; i++) {
+    pthread_create(&consumers[i], NULL, consumer, NULL);
+  }
+  for (i = 0; i < N_PRODUCERS; i++) {
+    pthread_create(&producers[i], NULL, producer, (void*)(long)i);
+  }
+  for (i = 0; i < N_PRODUCERS; i++) {
+    pthread_join(producers[i], NULL);
+  }
+  bqueue_close(bq);
+  for (i = 0; i < N_CONSUMERS; i++) {
+    pthread_join(consumers[i], NULL);
+  }
+  int all_once = 1;
+  for (i = 0; i < N_PRODUCERS * PER_PRODUCER; i++) {
+    if (seen[i] != 1) {
+      all_once = 0;
+    }
+  }
+  printf("== Every value dequeued exactly once (expect 1): %d\n", all_once);
+  printf("== Per-producer order kept (expect 1): %d\n", in_order);
+  ok = ok && all_once && in_order;
+  bqueue_free(bq);
+
+  /*
+   * Closing an empty queue wakes consumers parked with no timeout.
+   */
+  bq = bqueue_create();
+  park(w, N_CONSUMERS, -1);
+  start = now_ns();
+  bqueue_close(bq);
+  int closed = 0;
+  for (i = 0; i < N_CONSUMERS; i++) {
+    pthread_join(w[i].thread, NULL);
+    closed += w[i].val == NULL && w[i].woke_ns - start < WAKE_NS;
+  }
+  printf("== Parked consumers woken by closing (expect %d): %d\n",
+    N_CONSUMERS, closed);
+  ok = ok && closed == N_CONSUMERS;
+  bqueue_free(bq);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+/*
+ * This file contains executable code for testing the coroutine agent
+ * simulation on runs small enough to work out by hand: every call must be
+ * answered exactly once, and the simulated waits and time taken must be
+ * the ones the handling and arrival times give.  One tick is 1 us.
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "agent_sim.h"
+#include "coro_sim.h"
+
+/*
+ * Runs a simulation and checks its results against the expected ones.
+ */
+int check(const char* what, int agents, int calls, long long work_ns,
+    long long arrival_ns, double mean_us, double max_us, double simulated_us) {
+  struct sim_config cfg = { agents, calls, DISPATCH_CORO, work_ns, arrival_ns,
+    NULL };
+  struct sim_result res;
+  coro_sim_run(&cfg, &res);
+  printf("== %s (expect %d, mean %.1f us, max %.1f us, %.0f us): "
+    "%ld, mean %.1f us, max %.1f us, %.0f us\n", what, calls, mean_us,
+    max_us, simulated_us, res.answered, res.mean_wait_us, res.max_wait_us,
+    res.simulated_s * 1e6);
+  return res.answered == calls && fabs(res.mean_wait_us - mean_us) < 1e-9 &&
+    fabs(res.max_wait_us - max_us) < 1e-9 &&
+    fabs(res.simulated_s * 1e6 - simulated_us) < 1e-6;
+}
+
+int main(int argc, char** argv) {
+  int ok = 1;
+
+  /*
+   * Every call waiting at the start and no handling time: each agent
+   * takes a call and yields, so everything is answered at tick 0.
+   */
+  ok &= check("7 calls, 3 agents, all at once, no handling", 3, 7, 0, 0,
+    0, 0, 0);
+
+  /*
+   * Every call waiting at the start, 10 us each: two agents answer them in
+   * pairs at 0, 10 and 20 us, waiting 0, 0, 10, 10, 20 and 20 us, and the
+   * last pair is done at 30 us.
+   */
+  ok &= check("6 calls, 2 agents, all at once, 10 us each", 2, 6, 10000, 0,
+    10, 20, 30);
+
+  /*
+   * A call every 5 us from tick 0, 12 us each: calls arrive at 0, 5, 10 and
+   * 15 us.  The first two agents are idle and answer at once; call 3 waits
+   * for the first agent until 12 us and call 4 for the second until 17 us,
+   * which is done at 29 us.
+   */
+  ok &= check("4 calls, 2 agents, every 5 us, 12 us each", 2, 4, 12000, 5000,
+    1, 2, 29);
+
+  /*
+   * More agents than calls, a call every 3 us and 4 us each: nobody waits,
+   * and the last call, arriving at 9 us, is done at 13 us.
+   */
+  ok &= check("4 calls, 8 agents, every 3 us, 4 us each", 8, 4, 4000, 3000,
+    0, 0, 13);
+
+  /*
+   * Handling and arrival gaps spanning many rotations of the timing wheel,
+   * which time skips through.  Three calls at once, 10 ms each, for two
+   * agents: the third waits for the first agent and is done at 20 ms.  A
+   * call every 1 ms, 0.3 ms each, for one agent: nobody waits, and the
+   * third call, arriving at 2 ms, is done at 2.3 ms.
+   */
+  ok &= check("3 calls, 2 agents, all at once, 10 ms each", 2, 3, 10000000, 0,
+    10000.0 / 3, 10000, 20000);
+  ok &= check("3 calls, 1 agent, every 1 ms, 0.3 ms each", 1, 3, 300000,
+    1000000, 0, 0, 2300);
+
+  return ok ? 0 : 1;
+}
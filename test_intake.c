@@ -0,0 +1,197 @@
+/*
+ * This file contains executable code for testing the intake server: calls
+ * submitted over the socket must land in the queue, replies must report
+ * IDs and positions in request order, and a malformed frame must get the
+ * connection dropped.  The callcenter's menu, listening on a socket, must
+ * also work through commands piped in all at once.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "call.h"
+#include "intake_proto.h"
+#include "intake_server.h"
+#include "queue.h"
+
+int next_id = 0;
+
+int enqueue(struct queue* queue, Call* call) {
+  call->id = ++next_id;
+  queue_enqueue(queue, call);
+  return 1;
+}
+
+/*
+ * Appends one frame to a buffer and returns the new length.
+ */
+int frame(char* buf, int len, int type, const void* payload, int n) {
+  struct intake_frame hdr = { (uint16_t)type, (uint16_t)n };
+  memcpy(buf + len, &hdr, sizeof(hdr));
+  memcpy(buf + len + sizeof(hdr), payload, n);
+  return len + sizeof(hdr) + n;
+}
+
+/*
+ * Runs the callcenter menu with --listen, writes `input` to its stdin in
+ * one go and keeps the pipe open, as a script piping commands would.
+ * Returns 1 if the menu worked through the input and quit within two
+ * seconds, or 0 if it hung or failed.
+ */
+int run_piped_menu(const char* path, const char* input) {
+  int fds[2];
+  char listen[80];
+  if (pipe(fds) != 0) {
+    return 0;
+  }
+  snprintf(listen, sizeof(listen), "--listen=%s", path);
+  pid_t child = fork();
+  if (child == 0) {
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+    close(fds[1]);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    execl("./callcenter", "callcenter", listen, (char*)NULL);
+    _exit(127);
+  }
+  close(fds[0]);
+  write(fds[1], input, strlen(input));
+  int status = 0, done = 0;
+  for (int waited_ms = 0; !done && waited_ms < 2000; waited_ms += 10) {
+    done = waitpid(child, &status, WNOHANG) == child;
+    if (!done) {
+      usleep(10000);
+    }
+  }
+  if (!done) {
+    kill(child, SIGKILL);
+    waitpid(child, &status, 0);
+  }
+  close(fds[1]);
+  return done && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/*
+ * Runs the server until `want` bytes of replies have arrived on `fd`.
+ */
+int receive(struct intake_server* srv, int fd, char* buf, int want) {
+  int got = 0;
+  for (int turns = 0; got < want && turns < 100; turns++) {
+    intake_server_run(srv, 10);
+    ssize_t n = recv(fd, buf + got, want - got, MSG_DONTWAIT);
+    if (n == 0) {
+      break;
+    }
+    got += n > 0 ? n : 0;
+  }
+  return got;
+}
+
+int main(int argc, char** argv) {
+  char path[64], buf[512];
+  int ok = 1, len = 0;
+  struct intake_frame hdr;
+  struct intake_accepted acc[2];
+  struct intake_status_reply st;
+  snprintf(path, sizeof(path), "/tmp/test_intake.%d.sock", (int)getpid());
+
+  struct queue* queue = queue_create();
+  struct intake_server* srv = intake_server_create(path, queue, enqueue);
+  if (!srv) {
+    printf("== Could not create the intake server; skipping\n");
+    queue_free(queue);
+    return 0;
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+
+  /*
+   * Two submissions and a status query for the first, in one write.
+   */
+  struct intake_submit sub;
+  memset(&sub, 0, sizeof(sub));
+  strcpy(sub.caller_name, "Ann");
+  strcpy(sub.call_reason, "Billing");
+  len = frame(buf, len, INTAKE_SUBMIT, &sub, sizeof(sub));
+  strcpy(sub.caller_name, "Bob");
+  len = frame(buf, len, INTAKE_SUBMIT, &sub, sizeof(sub));
+  struct intake_status q = { 1 };
+  len = frame(buf, len, INTAKE_STATUS, &q, sizeof(q));
+  write(fd, buf, len);
+
+  int want = 2 * (sizeof(hdr) + sizeof(acc[0])) + sizeof(hdr) + sizeof(st);
+  int got = receive(srv, fd, buf, want);
+  memcpy(&acc[0], buf + sizeof(hdr), sizeof(acc[0]));
+  memcpy(&acc[1], buf + 2 * sizeof(hdr) + sizeof(acc[0]), sizeof(acc[1]));
+  memcpy(&st, buf + 3 * sizeof(hdr) + 2 * sizeof(acc[0]), sizeof(st));
+  printf("== Replies received (expect %d bytes): %d\n", want, got);
+  printf("== Accepted IDs and positions (expect 1 1 2 2): %d %d %d %d\n",
+    acc[0].id, acc[0].position, acc[1].id, acc[1].position);
+  printf("== Status of call 1 (expect position 1 of 2): %d of %d\n",
+    st.position, st.waiting);
+  printf("== Second call in the queue (expect Bob): %s\n",
+    ((Call*)queue_get(queue, 1))->caller_name);
+  ok = ok && got == want && acc[0].id == 1 && acc[0].position == 1 &&
+    acc[1].id == 2 && acc[1].position == 2 && st.position == 1 &&
+    st.waiting == 2 && strcmp(((Call*)queue_get(queue, 1))->caller_name, "Bob") == 0;
+
+  /*
+   * Answer the first call; the second moves to the front.
+   */
+  free(queue_dequeue(queue));
+  len = 0;
+  q.id = 1;
+  len = frame(buf, len, INTAKE_STATUS, &q, sizeof(q));
+  q.id = 2;
+  len = frame(buf, len, INTAKE_STATUS, &q, sizeof(q));
+  write(fd, buf, len);
+  want = 2 * (sizeof(hdr) + sizeof(st));
+  got = receive(srv, fd, buf, want);
+  struct intake_status_reply st2;
+  memcpy(&st, buf + sizeof(hdr), sizeof(st));
+  memcpy(&st2, buf + 2 * sizeof(hdr) + sizeof(st), sizeof(st2));
+  printf("== Positions after answering call 1 (expect 0 1): %d %d\n",
+    st.position, st2.position);
+  ok = ok && got == want && st.position == 0 && st2.position == 1;
+
+  /*
+   * A frame of an unknown type gets the connection closed.
+   */
+  len = frame(buf, 0, 99, &q, sizeof(q));
+  write(fd, buf, len);
+  got = receive(srv, fd, buf, 1);
+  printf("== Connection dropped after a bad frame (expect 0 0): %d %d\n", got,
+    intake_server_connections(srv));
+  ok = ok && got == 0 && intake_server_connections(srv) == 0;
+
+  close(fd);
+  intake_server_free(srv);
+  printf("== Socket removed (expect 1): %d\n", access(path, F_OK) != 0);
+  ok = ok && access(path, F_OK) != 0;
+  queue_free(queue);
+
+  /*
+   * Commands piped in together arrive in one read, most of them before the
+   * menu gets to wait for input; the menu must still see them all and quit.
+   */
+  int quit = run_piped_menu(path, "1\nBob\nBilling\n4\n5\n");
+  printf("== Menu worked through piped commands and quit (expect 1): %d\n",
+    quit);
+  ok = ok && quit;
+  return ok ? 0 : 1;
+}
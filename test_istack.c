@@ -0,0 +1,139 @@
+/*
+ * This file contains executable code for testing the intrusive stack.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#include "istack.h"
+
+/*
+ * Structure used to represent a test value, with its link in the middle so
+ * getting back from the link to the value is actually exercised.
+ */
+struct item {
+  int before;
+  struct ilink link;
+  int value;
+};
+
+#define ITEM_OF_LINK(l) ((struct item*)((char*)(l) - offsetof(struct item, link)))
+
+int evicted = 0, evicted_in_order = 1, disposed = 0;
+
+/*
+ * Eviction function: check that values leave a bounded stack oldest first.
+ */
+void evict(struct ilink* link, void* ctx) {
+  if (ITEM_OF_LINK(link)->value != evicted) {
+    evicted_in_order = 0;
+  }
+  evicted++;
+}
+
+void dispose(struct ilink* link, void* ctx) {
+  disposed++;
+}
+
+int main(int argc, char** argv) {
+  int i, n = 1000, ok;
+  struct item* items = malloc(n * sizeof(struct item));
+  struct istack* s = istack_create(0);
+
+  for (i = 0; i < n; i++) {
+    items[i].value = i;
+  }
+
+  /*
+   * Push everything, then pop it all back in reverse order.
+   */
+  for (i = 0; i < n; i++) {
+    istack_push(s, &items[i].link);
+  }
+  printf("== Size after %d pushes (expect %d): %d\n", n, n, istack_size(s));
+  printf("== Top (expect %d): %d\n", n - 1, ITEM_OF_LINK(istack_top(s))->value);
+  ok = 1;
+  for (i = 0; i < n; i++) {
+    struct ilink* got = istack_get(s, i);
+    if (!got || ITEM_OF_LINK(got)->value != n - 1 - i) {
+      ok = 0;
+    }
+  }
+  printf("== Get at every depth (expect 1): %d\n", ok);
+  printf("== Get out of range is NULL (expect 1): %d\n",
+    istack_get(s, -1) == NULL && istack_get(s, n) == NULL);
+  ok = 1;
+  for (i = n - 1; i >= 0; i--) {
+    struct ilink* got = istack_pop(s);
+    if (!got || ITEM_OF_LINK(got)->value != i) {
+      ok = 0;
+    }
+  }
+  printf("== Popped in LIFO order (expect 1): %d\n", ok);
+  printf("== Is stack empty (expect 1)? %d\n", istack_isempty(s));
+  printf("== Pop and top on empty are NULL (expect 1): %d\n",
+    istack_pop(s) == NULL && istack_top(s) == NULL);
+
+  /*
+   * Unlink every third value from the middle, then walk the rest from the
+   * top and make sure exactly the others are left, in order.
+   */
+  for (i = 0; i < n; i++) {
+    istack_push(s, &items[i].link);
+  }
+  for (i = 0; i < n; i += 3) {
+    istack_remove(s, &items[i].link);
+  }
+  ok = 1;
+  i = n - 1;
+  int seen = 0;
+  for (struct ilink* l = istack_top(s); l; l = istack_next(s, l)) {
+    while (i % 3 == 0) {
+      i--;
+    }
+    if (ITEM_OF_LINK(l)->value != i) {
+      ok = 0;
+    }
+    i--;
+    seen++;
+  }
+  printf("== Walk after removing every third (expect 1): %d\n",
+    ok && seen == istack_size(s));
+  printf("== Size after removals (expect %d): %d\n", n - (n + 2) / 3,
+    istack_size(s));
+
+  /*
+   * Removed values can be pushed again; clearing hands every value to the
+   * dispose function and leaves the stack empty.
+   */
+  istack_push(s, &items[0].link);
+  printf("== Re-pushed value on top (expect 0): %d\n",
+    ITEM_OF_LINK(istack_top(s))->value);
+  int expected = istack_size(s);
+  istack_clear(s, dispose, NULL);
+  printf("== Cleared (expect %d, 1): %d, %d\n", expected, disposed,
+    istack_isempty(s));
+  istack_free(s);
+
+  /*
+   * A bounded stack keeps the newest values and evicts the rest, oldest
+   * first.
+   */
+  int bound = 100;
+  s = istack_create(bound);
+  istack_set_evict(s, evict, NULL);
+  for (i = 0; i < n; i++) {
+    istack_push(s, &items[i].link);
+  }
+  printf("== Bounded size (expect %d): %d\n", bound, istack_size(s));
+  printf("== Evicted (expect %d): %d\n", n - bound, evicted);
+  printf("== Evicted oldest first (expect 1): %d\n", evicted_in_order);
+  printf("== Bottom is oldest kept (expect %d): %d\n", n - bound,
+    ITEM_OF_LINK(istack_get(s, bound - 1))->value);
+  istack_clear(s, NULL, NULL);
+  istack_free(s);
+
+  free(items);
+  return 0;
+}
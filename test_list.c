@@ -0,0 +1,207 @@
+/*
+ * This file contains executable code for testing a linked list backend
+ * against a plain array holding what the list should contain.  It is built
+ * twice, as test_list against list.o and as test_list_unrolled against
+ * list_unrolled.o, so both backends are held to the same behaviour.  The
+ * lists are long enough to span many chunks of the unrolled list, so
+ * removals, positions and lookups cross chunk boundaries, reversal moves
+ * values between chunks, and emptied and nearly empty chunks get freed and
+ * merged.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "list.h"
+
+#define MAX_VALUES 1000
+
+/*
+ * What the list should hold, head first.
+ */
+intptr_t model[MAX_VALUES];
+int model_size = 0;
+
+int cmp(void* a, void* b) {
+  return (intptr_t)a != (intptr_t)b;
+}
+
+/*
+ * Inserts a value at the head of the list and the model.
+ */
+void insert(struct list* list, intptr_t val) {
+  list_insert(list, (void*)val);
+  memmove(model + 1, model, model_size * sizeof(intptr_t));
+  model[0] = val;
+  model_size++;
+}
+
+/*
+ * Removes the first instance of a value from the list and the model.
+ */
+void remove_value(struct list* list, intptr_t val) {
+  list_remove(list, (void*)val, cmp);
+  for (int i = 0; i < model_size; i++) {
+    if (model[i] == val) {
+      memmove(model + i, model + i + 1, (model_size - i - 1) * sizeof(intptr_t));
+      model_size--;
+      return;
+    }
+  }
+}
+
+/*
+ * Checks that the list holds exactly what the model does, reading it with
+ * list_get(), list_position(), top_value() and list_size().
+ */
+int matches(struct list* list) {
+  if (list_size(list) != model_size || list_isempty(list) != (model_size == 0)) {
+    return 0;
+  }
+  for (int i = 0; i < model_size; i++) {
+    if ((intptr_t)list_get(list, i) != model[i] ||
+        list_position(list, (void*)model[i], cmp) != i) {
+      return 0;
+    }
+  }
+  return list_get(list, model_size) == NULL &&
+    (intptr_t)top_value(list) == (model_size ? model[0] : 0);
+}
+
+/*
+ * Pops every value off the list, so list_free() has nothing to free.
+ */
+void drain(struct list* list) {
+  while (pop_value(list)) {
+  }
+  model_size = 0;
+}
+
+int main(int argc, char** argv) {
+  int i, ok;
+  struct list* list = list_create();
+
+  /*
+   * 100 values, then values removed from the head, the tail and across
+   * the middle, each one a different distance into its chunk.
+   */
+  for (i = 1; i <= 100; i++) {
+    insert(list, i);
+  }
+  printf("== Size and order after 100 inserts (expect 1): %d\n",
+    matches(list));
+  ok = matches(list);
+  remove_value(list, 100);
+  remove_value(list, 1);
+  for (i = 5; i < 95; i += 7) {
+    remove_value(list, i);
+  }
+  remove_value(list, 1000); // Not in the list
+  printf("== Order after removals across chunks (expect 1): %d\n",
+    matches(list));
+  printf("== Position of a missing value (expect -1): %d\n",
+    list_position(list, (void*)(intptr_t)5, cmp));
+  ok = ok && matches(list) && list_position(list, (void*)(intptr_t)5, cmp) == -1;
+
+  /*
+   * Reversing a list of many chunks, twice.
+   */
+  list_reverse(list);
+  for (i = 0; i < model_size / 2; i++) {
+    intptr_t temp = model[i];
+    model[i] = model[model_size - 1 - i];
+    model[model_size - 1 - i] = temp;
+  }
+  int reversed = matches(list);
+  list_reverse(list);
+  for (i = 0; i < model_size / 2; i++) {
+    intptr_t temp = model[i];
+    model[i] = model[model_size - 1 - i];
+    model[model_size - 1 - i] = temp;
+  }
+  printf("== Reversed, and reversed back (expect 1 1): %d %d\n", reversed,
+    matches(list));
+  ok = ok && reversed && matches(list);
+  drain(list);
+
+  /*
+   * Thin out the oldest chunk, then empty most of the one before it: once
+   * that is under a quarter full, the two fit in one chunk and are merged,
+   * so few slots stand empty.
+   */
+  for (i = 1; i <= 34; i++) {
+    insert(list, i); // Unrolled: 1-14, 15-28 and 29-34 in three chunks
+  }
+  for (i = 1; i <= 6; i++) {
+    remove_value(list, i);
+  }
+  for (i = 15; i <= 26; i++) {
+    remove_value(list, i);
+  }
+  printf("== Order after thinning two chunks (expect 1): %d\n", matches(list));
+  printf("== Unused bytes at most two chunks' worth less 16 values "
+    "(expect 1): %d\n", list_unused_bytes(list) <= (28 - 16) * sizeof(void*));
+  ok = ok && matches(list) &&
+    list_unused_bytes(list) <= (28 - 16) * sizeof(void*);
+  remove_value(list, 27);
+  remove_value(list, 28);
+  for (i = 29; i <= 34; i++) {
+    remove_value(list, i);
+  }
+  printf("== Order after emptying chunks (expect 1): %d\n", matches(list));
+  ok = ok && matches(list);
+  drain(list);
+
+  /*
+   * Emptying the oldest chunk, which has no successor to merge into,
+   * unlinks it from behind the head chunk.
+   */
+  for (i = 1; i <= 15; i++) {
+    insert(list, i); // Unrolled: 1-14 and 15 in two chunks
+  }
+  for (i = 1; i <= 14; i++) {
+    remove_value(list, i);
+  }
+  insert(list, 16);
+  printf("== Order after emptying the oldest chunk (expect 1): %d\n",
+    matches(list));
+  ok = ok && matches(list);
+  drain(list);
+
+  /*
+   * Random inserts and removals, checked against the model throughout.
+   */
+  srand(3);
+  intptr_t next = 1;
+  int random_ok = 1;
+  for (int op = 0; op < 5000; op++) {
+    int r = rand() % 10;
+    if ((r < 5 || model_size == 0) && model_size < MAX_VALUES) {
+      insert(list, next++);
+    } else if (r < 9) {
+      remove_value(list, model[rand() % model_size]);
+    } else {
+      list_reverse(list);
+      for (i = 0; i < model_size / 2; i++) {
+        intptr_t temp = model[i];
+        model[i] = model[model_size - 1 - i];
+        model[model_size - 1 - i] = temp;
+      }
+    }
+    if (op % 50 == 0 && !matches(list)) {
+      random_ok = 0;
+    }
+  }
+  printf("== Random inserts, removals and reversals (expect 1): %d\n",
+    random_ok && matches(list));
+  ok = ok && random_ok && matches(list);
+  drain(list);
+  printf("== Empty after popping everything (expect 1 1): %d %d\n",
+    list_isempty(list), top_value(list) == NULL);
+  ok = ok && list_isempty(list) && top_value(list) == NULL;
+
+  list_free(list);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+/*
+ * This file contains executable code for testing the memory accounting of
+ * the queue and the stack.  A counting allocator is plugged into each
+ * container, and what the container reports is checked against what the
+ * allocator saw.  It works with any backend linked in.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "queue.h"
+#include "stack.h"
+
+/*
+ * State of the counting allocator.
+ */
+struct counter {
+  size_t live;
+  long allocs;
+  long frees;
+};
+
+void* counting_alloc(size_t bytes, void* ctx) {
+  struct counter* c = ctx;
+  c->live += bytes;
+  c->allocs++;
+  return malloc(bytes);
+}
+
+void counting_release(void* ptr, size_t bytes, void* ctx) {
+  struct counter* c = ctx;
+  c->live -= bytes;
+  c->frees++;
+  free(ptr);
+}
+
+/*
+ * Checks a container's report against the allocator, and that the used
+ * bytes cover at least the pointers to the values held.
+ */
+int check(const char* name, struct mem_stats* m, struct counter* c, int n) {
+  int ok = m->reserved == c->live && m->allocs == c->allocs &&
+    m->frees == c->frees && m->used <= m->reserved &&
+    m->used >= n * sizeof(void*) && m->peak >= m->reserved;
+  printf("== %s, %d values: %zu reserved (allocator: %zu), %zu used, "
+    "peak %zu, %ld / %ld allocs / frees: %s\n", name, n, m->reserved, c->live,
+    m->used, m->peak, m->allocs, m->frees, ok ? "ok" : "WRONG");
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  struct counter qc = { 0, 0, 0 }, sc = { 0, 0, 0 }, bc = { 0, 0, 0 };
+  struct allocator qa = { counting_alloc, counting_release, &qc };
+  struct allocator sa = { counting_alloc, counting_release, &sc };
+  struct allocator ba = { counting_alloc, counting_release, &bc };
+  struct mem_stats m;
+  int ok = 1, n = 10000;
+  size_t peak;
+
+  struct queue* queue = queue_create_with(&qa);
+  for (int i = 0; i < n; i++) {
+    queue_enqueue(queue, malloc(16));
+  }
+  queue_mem_stats(queue, &m);
+  ok &= check("Queue filled", &m, &qc, n);
+  peak = m.peak;
+  for (int i = 0; i < n - 10; i++) {
+    free(queue_dequeue(queue));
+  }
+  queue_mem_stats(queue, &m);
+  ok &= check("Queue drained", &m, &qc, 10);
+  ok &= m.peak == peak;
+  queue_free(queue);
+  printf("== Queue freed, bytes / allocs - frees left (expect 0 / 0): "
+    "%zu / %ld\n", qc.live, qc.allocs - qc.frees);
+  ok &= qc.live == 0 && qc.allocs == qc.frees;
+
+  struct stack* stack = stack_create_with(&sa, 0);
+  for (int i = 0; i < n; i++) {
+    stack_push(stack, malloc(16));
+  }
+  stack_mem_stats(stack, &m);
+  ok &= check("Stack filled", &m, &sc, n);
+  for (int i = 0; i < n / 2; i++) {
+    free(stack_pop(stack));
+  }
+  stack_mem_stats(stack, &m);
+  ok &= check("Stack half popped", &m, &sc, n / 2);
+  stack_free(stack);
+  ok &= sc.live == 0 && sc.allocs == sc.frees;
+
+  /*
+   * A bounded stack allocates its ring up front; pushes allocate nothing.
+   */
+  stack = stack_create_with(&ba, 100);
+  stack_mem_stats(stack, &m);
+  long allocs = m.allocs;
+  for (int i = 0; i < n; i++) {
+    stack_push(stack, malloc(16));
+  }
+  stack_mem_stats(stack, &m);
+  ok &= check("Bounded stack", &m, &bc, 100);
+  printf("== Bounded stack, allocations while pushing (expect 0): %ld\n",
+    m.allocs - allocs);
+  ok &= m.allocs == allocs && m.used == m.reserved;
+  stack_free(stack);
+  ok &= bc.live == 0 && bc.allocs == bc.frees;
+
+  /*
+   * Small containers hold their values in their own structure: one
+   * allocation each until they grow past it, in the same order after.
+   */
+  struct counter tc = { 0, 0, 0 };
+  struct allocator ta = { counting_alloc, counting_release, &tc };
+  queue = queue_create_with(&ta);
+  stack = stack_create_with(&ta, 0);
+  int vals[8];
+  for (int i = 0; i < 3; i++) {
+    queue_enqueue(queue, &vals[i]);
+    stack_push(stack, &vals[i]);
+  }
+  printf("== Queue and stack of 3, allocations (expect 2): %ld\n", tc.allocs);
+  ok &= tc.allocs == 2;
+  for (int i = 3; i < 8; i++) {
+    queue_enqueue(queue, &vals[i]);
+    stack_push(stack, &vals[i]);
+  }
+  int in_order = 1;
+  for (int i = 0; i < 8; i++) {
+    in_order &= queue_dequeue(queue) == &vals[i];
+    in_order &= stack_pop(stack) == &vals[7 - i];
+  }
+  printf("== Values in order after growing (expect 1): %d\n", in_order);
+  ok &= in_order;
+  queue_free(queue);
+  stack_free(stack);
+  ok &= tc.live == 0 && tc.allocs == tc.frees;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+/*
+ * This file contains executable code for testing the shared-memory metrics
+ * segment: what the writer records must be what a separate read-only
+ * mapping sees, and removing the segment must hide it from new readers.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "metrics.h"
+
+int main(int argc, char** argv) {
+  char name[64];
+  int ok = 1;
+  snprintf(name, sizeof(name), "/test_metrics.%d", (int)getpid());
+
+  struct metrics* m = metrics_create(name);
+  if (!m) {
+    printf("== Could not create a shared-memory segment; skipping\n");
+    return 0;
+  }
+  struct metrics* r = metrics_open(name);
+  printf("== Opened the segment read-only (expect 1): %d\n", r != NULL);
+  ok = ok && r != NULL;
+
+  printf("== Thread slots are one cache line each (expect 64): %d\n",
+    (int)sizeof(struct metrics_thread));
+  ok = ok && sizeof(struct metrics_thread) == 64;
+
+  /*
+   * Grow a gauge from 0 to 10 and back down to 3, doubling its "capacity"
+   * from 2 to 16 on the way up.
+   */
+  for (int i = 1; i <= 10; i++) {
+    metrics_inc(&m->threads[0].enqueues);
+    metrics_gauge(&m->queue, i, i <= 2 ? 2 : i <= 4 ? 4 : i <= 8 ? 8 : 16);
+  }
+  for (int i = 9; i >= 3; i--) {
+    metrics_inc(&m->threads[1].dequeues);
+    metrics_gauge(&m->queue, i, 16);
+  }
+  printf("== Enqueues seen by reader (expect 10): %llu\n",
+    r->threads[0].enqueues);
+  printf("== Dequeues seen by reader (expect 7): %llu\n",
+    r->threads[1].dequeues);
+  printf("== Queue size, high water, resizes (expect 3 10 3): %lld %lld %lld\n",
+    r->queue.size, r->queue.high_water, r->queue.resizes);
+  ok = ok && r->threads[0].enqueues == 10 && r->threads[1].dequeues == 7 &&
+    r->queue.size == 3 && r->queue.high_water == 10 && r->queue.resizes == 3;
+
+  metrics_destroy(m, name);
+  printf("== Existing reader still sees final counts (expect 10): %llu\n",
+    r->threads[0].enqueues);
+  ok = ok && r->threads[0].enqueues == 10;
+  metrics_close(r);
+
+  r = metrics_open(name);
+  printf("== Removed segment can be opened (expect 0): %d\n", r != NULL);
+  ok = ok && r == NULL;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+/*
+ * This file contains executable code for testing a queue backend against a
+ * plain array holding what the queue should contain.  It is built twice, as
+ * test_queue_model against queue.o and as test_queue_model_segmented
+ * against queue_segmented.o, so both backends behind queue.h are held to
+ * the same behaviour.  The queues get long enough to span several 511-value
+ * segments, so lookups and dequeues cross segment boundaries, and they
+ * drain and refill, so emptied segments are reused from the free list.
+ * The segmented build defines QUEUE_SEGMENTED to check for that reuse.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "queue.h"
+
+#define MAX_VALUES 100000
+
+/*
+ * What the queue should hold: model[model_front] through
+ * model[model_back - 1], front first.
+ */
+intptr_t model[MAX_VALUES];
+int model_front = 0, model_back = 0;
+intptr_t next = 1;
+
+/*
+ * Enqueues the next `n` values onto the queue and the model.
+ */
+void enqueue(struct queue* q, int n) {
+  for (int i = 0; i < n; i++) {
+    queue_enqueue(q, (void*)next);
+    model[model_back++] = next++;
+  }
+}
+
+/*
+ * Dequeues `n` values, and returns 1 if each was the front of the model.
+ */
+int dequeue(struct queue* q, int n) {
+  int ok = 1;
+  for (int i = 0; i < n; i++) {
+    intptr_t front = (intptr_t)queue_front(q);
+    intptr_t val = (intptr_t)queue_dequeue(q);
+    ok = ok && front == model[model_front] && val == model[model_front];
+    model_front++;
+  }
+  return ok;
+}
+
+/*
+ * Checks that the queue holds exactly what the model does, reading it with
+ * queue_get(), queue_front(), queue_size() and queue_isempty().
+ */
+int matches(struct queue* q) {
+  int size = model_back - model_front;
+  if (queue_size(q) != size || queue_isempty(q) != (size == 0)) {
+    return 0;
+  }
+  for (int i = 0; i < size; i++) {
+    if ((intptr_t)queue_get(q, i) != model[model_front + i]) {
+      return 0;
+    }
+  }
+  return (intptr_t)queue_front(q) == (size ? model[model_front] : 0);
+}
+
+/*
+ * Returns the number of allocations a queue has made so far.
+ */
+long allocs(struct queue* q) {
+  struct mem_stats stats;
+  queue_mem_stats(q, &stats);
+  return stats.allocs;
+}
+
+int main(int argc, char** argv) {
+  int ok = 1, round_ok;
+  struct queue* q = queue_create();
+
+  /*
+   * An empty queue has no front and nothing to dequeue.
+   */
+  printf("== Front and dequeue of an empty queue (expect 1 1): %d %d\n",
+    queue_front(q) == NULL, queue_dequeue(q) == NULL);
+  ok = ok && queue_front(q) == NULL && queue_dequeue(q) == NULL;
+
+  /*
+   * A few values wrapping around the slots inside the queue structure,
+   * then enough to move them out into storage of their own.
+   */
+  enqueue(q, 3);
+  round_ok = dequeue(q, 2) && matches(q);
+  enqueue(q, 3);
+  round_ok = round_ok && matches(q);
+  enqueue(q, 10);
+  printf("== Order while small and after moving out (expect 1 1): %d %d\n",
+    round_ok, matches(q));
+  ok = ok && round_ok && matches(q);
+  dequeue(q, model_back - model_front);
+
+  /*
+   * Four segments' worth, read across segment boundaries, then dequeued
+   * past the first boundary and refilled.
+   */
+  enqueue(q, 2000);
+  printf("== Order of 2000 values (expect 1): %d\n", matches(q));
+  ok = ok && matches(q);
+  round_ok = dequeue(q, 700);
+  enqueue(q, 1500);
+  printf("== Order after dequeueing 700 and enqueueing 1500 (expect 1 1): "
+    "%d %d\n", round_ok, matches(q));
+  ok = ok && round_ok && matches(q);
+  round_ok = dequeue(q, model_back - model_front);
+  printf("== Dequeued in order, then empty (expect 1 1 1): %d %d %d\n",
+    round_ok, matches(q), queue_front(q) == NULL);
+  ok = ok && round_ok && matches(q) && queue_front(q) == NULL;
+
+  /*
+   * A drained queue can be refilled up to its capacity without allocating.
+   * The segmented queue keeps emptied segments on its free list, so there
+   * its capacity still covers what it held before draining.
+   */
+  enqueue(q, 2800);
+  dequeue(q, 2800);
+  int capacity = queue_capacity(q);
+  long before = allocs(q);
+  round_ok = 1;
+  for (int round = 0; round < 5; round++) {
+    enqueue(q, capacity);
+    int matched = matches(q);
+    round_ok = dequeue(q, capacity) && matched && round_ok;
+  }
+  printf("== Allocations refilling to capacity five times (expect 0): %ld\n",
+    allocs(q) - before);
+  printf("== Order while refilling (expect 1): %d\n", round_ok);
+  ok = ok && allocs(q) == before && round_ok;
+#ifdef QUEUE_SEGMENTED
+  printf("== Capacity after draining 2800 values (expect at least 2800): %d\n",
+    capacity);
+  ok = ok && capacity >= 2800;
+#endif
+
+  /*
+   * Reserving room for more values than the queue has ever held lets it
+   * reach that size, drain and refill without allocating.
+   */
+  queue_reserve(q, 20000);
+  before = allocs(q);
+  enqueue(q, 20000);
+  dequeue(q, 20000);
+  enqueue(q, 20000);
+  printf("== Allocations filling a reserved queue twice (expect 0): %ld\n",
+    allocs(q) - before);
+  printf("== Order in a reserved queue (expect 1): %d\n", matches(q));
+  ok = ok && allocs(q) == before && matches(q);
+  dequeue(q, model_back - model_front);
+
+  /*
+   * Random runs of enqueues and dequeues, checked against the model.
+   */
+  srand(5);
+  round_ok = 1;
+  for (int op = 0; op < 400 && model_back + 1000 <= MAX_VALUES; op++) {
+    int n = rand() % 1000;
+    if (rand() % 2) {
+      enqueue(q, n);
+    } else {
+      int size = model_back - model_front;
+      round_ok = dequeue(q, n < size ? n : size) && round_ok;
+    }
+    if (op % 10 == 0 && !matches(q)) {
+      round_ok = 0;
+    }
+  }
+  printf("== Random enqueues and dequeues (expect 1): %d\n",
+    round_ok && matches(q));
+  ok = ok && round_ok && matches(q);
+  dequeue(q, model_back - model_front);
+
+  queue_free(q);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+/*
+ * This file contains executable code for testing asynchronous clearing of
+ * the queue and the stack.  A locked counting allocator is plugged into
+ * each container, since storage is freed on the reclaimer's thread too.
+ * After clearing, a container must be empty at once and usable as new, and
+ * once the reclaimer is done, the allocator must hold exactly what the
+ * container reports.  It works with any backend linked in.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "queue.h"
+#include "reclaim.h"
+#include "stack.h"
+
+/*
+ * State of the counting allocator.
+ */
+struct counter {
+  pthread_mutex_t lock;
+  size_t live;
+};
+
+void* counting_alloc(size_t bytes, void* ctx) {
+  struct counter* c = ctx;
+  pthread_mutex_lock(&c->lock);
+  c->live += bytes;
+  pthread_mutex_unlock(&c->lock);
+  return malloc(bytes);
+}
+
+void counting_release(void* ptr, size_t bytes, void* ctx) {
+  struct counter* c = ctx;
+  pthread_mutex_lock(&c->lock);
+  c->live -= bytes;
+  pthread_mutex_unlock(&c->lock);
+  free(ptr);
+}
+
+/*
+ * Returns a value for a container to own, holding `i`.
+ */
+int* value(int i) {
+  int* v = malloc(sizeof(int));
+  *v = i;
+  return v;
+}
+
+int main(int argc, char** argv) {
+  struct counter qc = { PTHREAD_MUTEX_INITIALIZER, 0 };
+  struct counter sc = { PTHREAD_MUTEX_INITIALIZER, 0 };
+  struct counter bc = { PTHREAD_MUTEX_INITIALIZER, 0 };
+  struct allocator qa = { counting_alloc, counting_release, &qc };
+  struct allocator sa = { counting_alloc, counting_release, &sc };
+  struct allocator ba = { counting_alloc, counting_release, &bc };
+  struct mem_stats qm, sm, bm;
+  int ok = 1, n = 200000;
+
+  struct queue* queue = queue_create_with(&qa);
+  struct stack* stack = stack_create_with(&sa, 0);
+  struct stack* bounded = stack_create_with(&ba, 1000);
+  for (int i = 0; i < n; i++) {
+    queue_enqueue(queue, value(i));
+    stack_push(stack, value(i));
+    stack_push(bounded, value(i));
+  }
+
+  /*
+   * Clearing empties the containers at once, and they work as new while
+   * the old values are still being freed.
+   */
+  queue_clear_async(queue);
+  stack_clear_async(stack);
+  stack_clear_async(bounded);
+  int empty = queue_isempty(queue) && stack_isempty(stack) &&
+    stack_isempty(bounded);
+  for (int i = 0; i < 1500; i++) {
+    queue_enqueue(queue, value(i));
+    stack_push(stack, value(i));
+    stack_push(bounded, value(i));
+  }
+  int* front = queue_dequeue(queue);
+  int* top = stack_pop(stack);
+  int* btop = stack_pop(bounded);
+  printf("== Cleared empty (expect 1): %d\n", empty);
+  printf("== After refilling, front / top / bounded top / bounded size "
+    "(expect 0 / 1499 / 1499 / 999): %d / %d / %d / %d\n", *front, *top,
+    *btop, stack_size(bounded));
+  ok &= empty && *front == 0 && *top == 1499 && *btop == 1499 &&
+    stack_size(bounded) == 999;
+  free(front);
+  free(top);
+  free(btop);
+
+  /*
+   * Once the reclaimer is done, the old storage has all gone back to the
+   * allocator.
+   */
+  reclaim_wait();
+  queue_mem_stats(queue, &qm);
+  stack_mem_stats(stack, &sm);
+  stack_mem_stats(bounded, &bm);
+  printf("== Structures left to reclaim (expect 0): %ld\n", reclaim_pending());
+  printf("== Reserved by queue / stack / bounded stack (allocator: "
+    "%zu / %zu / %zu): %zu / %zu / %zu\n", qc.live, sc.live, bc.live,
+    qm.reserved, sm.reserved, bm.reserved);
+  ok &= reclaim_pending() == 0 && qm.reserved == qc.live &&
+    sm.reserved == sc.live && bm.reserved == bc.live;
+
+  queue_free(queue);
+  stack_free(stack);
+  stack_free(bounded);
+  printf("== Left with the allocators after freeing (expect 0): %zu\n",
+    qc.live + sc.live + bc.live);
+  ok &= qc.live + sc.live + bc.live == 0;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+ * This file contains executable code for testing the sharded queue.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "shardq.h"
+
+#define N_PRODUCERS 4
+#define N_CONSUMERS 4
+#define PER_PRODUCER 50000
+
+/*
+ * Values encode producer * PER_PRODUCER + sequence number.
+ */
+int test_data[N_PRODUCERS * PER_PRODUCER];
+int seen[N_PRODUCERS * PER_PRODUCER];
+int producers_done = 0;
+int in_order = 1;
+struct shardq* sq;
+
+void* producer(void* arg) {
+  int p = (int)(long)arg;
+  for (int i = 0; i < PER_PRODUCER; i++) {
+    shardq_enqueue(sq, &test_data[p * PER_PRODUCER + i]);
+  }
+  return NULL;
+}
+
+/*
+ * Thread body of a consumer: every value taken from one producer must come
+ * after the last value this consumer took from that producer.
+ */
+void* consumer(void* arg) {
+  int last[N_PRODUCERS];
+  for (int p = 0; p < N_PRODUCERS; p++) {
+    last[p] = -1;
+  }
+  for (;;) {
+    int* val = shardq_dequeue(sq);
+    if (!val) {
+      if (__atomic_load_n(&producers_done, __ATOMIC_ACQUIRE) &&
+          shardq_size(sq) == 0) {
+        return NULL;
+      }
+      continue;
+    }
+    int p = *val / PER_PRODUCER, i = *val % PER_PRODUCER;
+    if (i <= last[p]) {
+      in_order = 0;
+    }
+    last[p] = i;
+    __atomic_add_fetch(&seen[*val], 1, __ATOMIC_RELAXED);
+  }
+}
+
+int main(int argc, char** argv) {
+  int i, ok = 1;
+  pthread_t producers[N_PRODUCERS], consumers[N_CONSUMERS];
+
+  for (i = 0; i < N_PRODUCERS * PER_PRODUCER; i++) {
+    test_data[i] = i;
+  }
+
+  /*
+   * Single-threaded: one thread's values come out in FIFO order.
+   */
+  sq = shardq_create(8);
+  for (i = 0; i < 8; i++) {
+    shardq_enqueue(sq, &test_data[i]);
+  }
+  printf("== Size after 8 enqueues (expect 8): %d\n", shardq_size(sq));
+  for (i = 0; i < 8; i++) {
+    if (*(int*)shardq_dequeue(sq) != i) {
+      ok = 0;
+    }
+  }
+  printf("== Single-thread FIFO (expect 1): %d\n", ok);
+  printf("== Empty dequeue returns NULL (expect 1): %d\n",
+    shardq_dequeue(sq) == NULL);
+
+  /*
+   * Concurrent: nothing lost or duplicated, per-producer order kept.
+   */
+  for (i = 0; i < N_CONSUMERS; i++) {
+    pthread_create(&consumers[i], NULL, consumer, NULL);
+  }
+  for (i = 0; i < N_PRODUCERS; i++) {
+    pthread_create(&producers[i], NULL, producer, (void*)(long)i);
+  }
+  for (i = 0; i < N_PRODUCERS; i++) {
+    pthread_join(producers[i], NULL);
+  }
+  __atomic_store_n(&producers_done, 1, __ATOMIC_RELEASE);
+  for (i = 0; i < N_CONSUMERS; i++) {
+    pthread_join(consumers[i], NULL);
+  }
+
+  int all_once = 1;
+  for (i = 0; i < N_PRODUCERS * PER_PRODUCER; i++) {
+    if (seen[i] != 1) {
+      all_once = 0;
+    }
+  }
+  printf("== Every value dequeued exactly once (expect 1): %d\n", all_once);
+  printf("== Per-producer order kept (expect 1): %d\n", in_order);
+
+  shardq_free(sq);
+  return ok && all_once && in_order ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/*
+ * This file contains executable code for testing the shared-memory call
+ * ring, with the producer in a child process and the consumer in the
+ * parent, through a ring small enough that both sides have to sleep, and
+ * then the producer waiting for a late consumer to drain the ring.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "shmring.h"
+#include "timeutil.h"
+
+#define N_CALLS 100000
+
+int main(int argc, char** argv) {
+  char name[64];
+  Call call;
+  int ok = 1;
+  snprintf(name, sizeof(name), "/test_shmring.%d", (int)getpid());
+
+  struct shmring* r = shmring_create(name, 5);
+  if (!r) {
+    printf("== Could not create a shared-memory segment; skipping\n");
+    return 0;
+  }
+  printf("== Capacity rounded up (expect 8): %d\n", shmring_capacity(r));
+  ok = ok && shmring_capacity(r) == 8;
+
+  printf("== Dequeue from empty ring, trying once (expect 0): %d\n",
+    shmring_dequeue(r, &call, 0));
+  long long start = now_ns();
+  int got = shmring_dequeue(r, &call, 20000000);
+  long long waited = now_ns() - start;
+  printf("== Dequeue from empty ring, waiting 20 ms (expect 0 1): %d %d\n",
+    got, waited >= 20000000);
+  ok = ok && !got && waited >= 20000000;
+
+  pid_t child = fork();
+  if (child == 0) {
+    struct shmring* w = shmring_attach(name);
+    if (!w) {
+      _exit(1);
+    }
+    for (int i = 1; i <= N_CALLS; i++) {
+      call.id = i;
+      snprintf(call.caller_name, sizeof(call.caller_name), "caller%d", i);
+      call.received_ns = now_ns();
+      shmring_enqueue(w, &call, -1);
+    }
+    shmring_close(w);
+    shmring_detach(w);
+    _exit(0);
+  }
+
+  /*
+   * One producer and one consumer, so calls must arrive in order.
+   */
+  int n = 0, in_order = 1;
+  char expected[30];
+  while (shmring_dequeue(r, &call, -1)) {
+    n++;
+    snprintf(expected, sizeof(expected), "caller%d", n);
+    if (call.id != n || strcmp(call.caller_name, expected) != 0) {
+      in_order = 0;
+    }
+  }
+  int status;
+  waitpid(child, &status, 0);
+  printf("== Calls received from the other process (expect %d): %d\n",
+    N_CALLS, n);
+  printf("== Calls arrived intact and in order (expect 1): %d\n", in_order);
+  printf("== Dequeue from closed, empty ring (expect 0): %d\n",
+    shmring_dequeue(r, &call, -1));
+  ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+    n == N_CALLS && in_order;
+
+  shmring_destroy(r, name);
+  printf("== Removed ring can be attached (expect 0): %d\n",
+    shmring_attach(name) != NULL);
+
+  /*
+   * Intake closing with calls left: draining waits for an agent that only
+   * attaches later to take them.
+   */
+  r = shmring_create(name, 8);
+  for (int i = 1; i <= 3; i++) {
+    call.id = i;
+    shmring_enqueue(r, &call, -1);
+  }
+  shmring_close(r);
+  int left = shmring_drain(r, 20000000);
+  printf("== Calls left after draining 20 ms with no agent (expect 3): %d\n",
+    left);
+  child = fork();
+  if (child == 0) {
+    struct timespec late = { 0, 50000000 };
+    nanosleep(&late, NULL);
+    struct shmring* a = shmring_attach(name);
+    int taken = 0;
+    while (a && shmring_dequeue(a, &call, -1)) {
+      taken++;
+    }
+    _exit(taken == 3 ? 0 : 1);
+  }
+  int drained = shmring_drain(r, -1);
+  waitpid(child, &status, 0);
+  printf("== Late agent took them all (expect 0 1): %d %d\n", drained,
+    WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  ok = ok && left == 3 && drained == 0 && WIFEXITED(status) &&
+    WEXITSTATUS(status) == 0;
+  shmring_destroy(r, name);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+/*
+ * This file contains executable code for testing the Bloom filter and the
+ * count-min sketch: neither may ever miss a key, and their errors must stay
+ * near what they were sized for.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sketch.h"
+
+#define KEYS 100000
+#define REPEATS 5
+
+/*
+ * Hashes the name of caller `i`.
+ */
+uint64_t caller_hash(int i) {
+  char name[30];
+  snprintf(name, sizeof(name), "caller%d", i);
+  return sketch_hash(name, strlen(name));
+}
+
+int main(int argc, char** argv) {
+  struct bloom* b = bloom_create(KEYS, 0.01);
+  struct cms* c = cms_create(1e-5, 0.02);
+  int ok = 1, missed = 0, low = 0, exact = 0, false_pos = 0;
+
+  /*
+   * Caller i calls 1 + i % REPEATS times.
+   */
+  for (int r = 0; r < REPEATS; r++) {
+    for (int i = 0; i < KEYS; i++) {
+      if (r <= i % REPEATS) {
+        uint64_t h = caller_hash(i);
+        bloom_add(b, h);
+        cms_add(c, h);
+      }
+    }
+  }
+  for (int i = 0; i < KEYS; i++) {
+    uint64_t h = caller_hash(i);
+    uint32_t est = cms_estimate(c, h);
+    missed += !bloom_contains(b, h);
+    low += est < (uint32_t)(1 + i % REPEATS);
+    exact += est == (uint32_t)(1 + i % REPEATS);
+  }
+  for (int i = KEYS; i < 2 * KEYS; i++) {
+    false_pos += bloom_contains(b, caller_hash(i));
+  }
+  printf("== Bloom filter, keys missed (expect 0): %d\n", missed);
+  printf("== Bloom filter, false positive rate (expect about 1%%): %.2f%%\n",
+    100.0 * false_pos / KEYS);
+  printf("== Count-min sketch, estimates too low (expect 0): %d\n", low);
+  printf("== Count-min sketch, estimates exact (expect most): %.1f%%\n",
+    100.0 * exact / KEYS);
+  ok &= missed == 0 && false_pos < KEYS / 50 && low == 0 && exact > KEYS * 9 / 10;
+
+  /*
+   * Clearing forgets everything.
+   */
+  bloom_clear(b);
+  cms_clear(c);
+  printf("== After clearing, caller0 seen / count (expect 0 / 0): %d / %u\n",
+    bloom_contains(b, caller_hash(0)), cms_estimate(c, caller_hash(0)));
+  ok &= !bloom_contains(b, caller_hash(0)) && cms_estimate(c, caller_hash(0)) == 0;
+  int first = bloom_add(b, caller_hash(1));
+  int again = bloom_add(b, caller_hash(1));
+  printf("== bloom_add of a new key / a key just added (expect 0 / 1): %d / %d\n",
+    first, again);
+  ok &= !first && again;
+
+  bloom_free(b);
+  cms_free(c);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+/*
+ * This file contains executable code for testing the skip list against a
+ * sorted array.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "skiplist.h"
+
+int n = 100000;
+
+/*
+ * Function used to sort keys with qsort().
+ */
+int cmp_key(const void* a, const void* b) {
+  long long x = *(const long long*)a, y = *(const long long*)b;
+  return (x > y) - (x < y);
+}
+
+int main(int argc, char** argv) {
+  long long* keys = malloc(n * sizeof(long long));
+  long long* sorted = malloc(n * sizeof(long long));
+  struct skiplist* sl = skiplist_create();
+  int i, ok = 1, misses = 0;
+
+  /*
+   * Random keys, with plenty of repeats.  Each value is the entry's index,
+   * so every entry can be told apart.
+   */
+  srand(7);
+  for (i = 0; i < n; i++) {
+    keys[i] = rand() % (n / 4);
+    sorted[i] = keys[i];
+    skiplist_insert(sl, keys[i], &keys[i]);
+  }
+  qsort(sorted, n, sizeof(long long), cmp_key);
+
+  struct skipnode* node = skiplist_first(sl);
+  for (i = 0; i < n && node; i++, node = skiplist_next(node)) {
+    misses += skiplist_key(node) != sorted[i];
+  }
+  printf("== In-order walk, size / out of order (expect %d / 0): %d / %d\n", n,
+    skiplist_size(sl), misses + (i != n) + (node != NULL));
+  ok &= misses == 0 && i == n && !node && skiplist_size(sl) == n;
+
+  /*
+   * Equal keys come out in the order they went in.
+   */
+  misses = 0;
+  for (node = skiplist_first(sl); node && skiplist_next(node);
+      node = skiplist_next(node)) {
+    struct skipnode* next = skiplist_next(node);
+    if (skiplist_key(node) == skiplist_key(next) &&
+        skiplist_value(node) > skiplist_value(next)) {
+      misses++;
+    }
+  }
+  printf("== Equal keys out of insertion order (expect 0): %d\n", misses);
+  ok &= misses == 0;
+
+  /*
+   * A range query returns exactly the keys in the range.
+   */
+  long long lo = n / 16, hi = n / 8;
+  int expected = 0, got = 0;
+  for (i = 0; i < n; i++) {
+    expected += sorted[i] >= lo && sorted[i] <= hi;
+  }
+  for (node = skiplist_seek(sl, lo); node && skiplist_key(node) <= hi;
+      node = skiplist_next(node)) {
+    got++;
+  }
+  printf("== Keys in [%lld, %lld] (expect %d): %d\n", lo, hi, expected, got);
+  ok &= got == expected;
+
+  /*
+   * Remove every other entry by key and value, then look up the rest.
+   */
+  misses = 0;
+  for (i = 0; i < n; i += 2) {
+    misses += !skiplist_remove(sl, keys[i], &keys[i]);
+  }
+  misses += skiplist_remove(sl, keys[0], &keys[0]); // Already gone
+  for (i = 1; i < n; i += 2) {
+    void* found = skiplist_find(sl, keys[i]);
+    misses += !found || *(long long*)found != keys[i];
+  }
+  misses += skiplist_find(sl, n) != NULL; // Never inserted
+  printf("== After removing half, size / misses (expect %d / 0): %d / %d\n",
+    n / 2, skiplist_size(sl), misses);
+  ok &= misses == 0 && skiplist_size(sl) == n / 2;
+
+  for (i = 1; i < n; i += 2) {
+    skiplist_remove(sl, keys[i], &keys[i]);
+  }
+  printf("== After removing the rest, size (expect 0): %d\n", skiplist_size(sl));
+  ok &= skiplist_size(sl) == 0 && skiplist_first(sl) == NULL;
+
+  skiplist_free(sl);
+  free(keys);
+  free(sorted);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/*
+ * This file contains executable code for testing the supervisor board:
+ * readers must always see a consistent summary and a snapshot that stays
+ * intact while they walk it, however fast the writer publishes.  Snapshots
+ * built from a queue and an answered stack must copy the right calls.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "snapshot.h"
+
+#define N_READERS 3
+#define N_PUBLISH 20000
+
+struct board* b;
+int done = 0;
+int torn_summaries = 0, torn_snapshots = 0;
+
+/*
+ * Thread body of a reader.  The writer keeps every summary and snapshot
+ * internally consistent (see main), so any mismatch means a torn read.
+ */
+void* reader(void* arg) {
+  int me = board_reader_register(b);
+  while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+    struct cc_summary sum;
+    board_read_summary(b, &sum);
+    if (sum.received != sum.answered + sum.queue_size ||
+        (sum.has_front && sum.front.id != (int)sum.answered + 1)) {
+      __atomic_add_fetch(&torn_summaries, 1, __ATOMIC_RELAXED);
+    }
+
+    const struct cc_snapshot* snap = board_snapshot_enter(b, me);
+    if (snap) {
+      for (int i = 1; i < snap->n_waiting; i++) {
+        if (snap->waiting[i].id != snap->waiting[0].id + i) {
+          __atomic_add_fetch(&torn_snapshots, 1, __ATOMIC_RELAXED);
+        }
+      }
+    }
+    board_snapshot_exit(b, me);
+  }
+  return NULL;
+}
+
+int main(int argc, char** argv) {
+  int i;
+  pthread_t readers[N_READERS];
+  struct cc_summary sum = { 0 };
+
+  b = board_create(N_READERS);
+  for (i = 0; i < N_READERS; i++) {
+    pthread_create(&readers[i], NULL, reader, NULL);
+  }
+
+  /*
+   * Publish a sliding window of waiting calls with ids answered + 1 to
+   * answered + 8.
+   */
+  for (i = 0; i < N_PUBLISH; i++) {
+    sum.answered = i;
+    sum.queue_size = 8;
+    sum.received = sum.answered + sum.queue_size;
+    sum.has_front = 1;
+    sum.front.id = i + 1;
+    board_publish_summary(b, &sum);
+
+    struct cc_snapshot* snap = malloc(sizeof(struct cc_snapshot));
+    snap->n_waiting = 8;
+    snap->n_answered = 0;
+    snap->waiting = malloc(8 * sizeof(Call));
+    snap->answered = NULL;
+    for (int j = 0; j < 8; j++) {
+      snap->waiting[j].id = i + 1 + j;
+    }
+    board_publish_snapshot(b, snap);
+  }
+  __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+  for (i = 0; i < N_READERS; i++) {
+    pthread_join(readers[i], NULL);
+  }
+
+  printf("== Torn summaries seen (expect 0): %d\n", torn_summaries);
+  printf("== Torn snapshots seen (expect 0): %d\n", torn_snapshots);
+  board_publish_snapshot(b, NULL);
+  printf("== Retired snapshots left once readers are gone (expect 0): %d\n",
+    board_retired(b));
+
+  int ok = torn_summaries == 0 && torn_snapshots == 0 && board_retired(b) == 0;
+  board_free(b);
+
+  /*
+   * Three calls waiting and five answered; the snapshot keeps the queue in
+   * order and the three most recent answers, newest first.
+   */
+  Call calls[8];
+  struct queue* q = queue_create();
+  struct istack* s = istack_create(0);
+  for (i = 0; i < 8; i++) {
+    calls[i].id = i + 1;
+    if (i < 5) {
+      istack_push(s, &calls[i].link);
+    } else {
+      queue_enqueue(q, &calls[i]);
+    }
+  }
+  struct cc_snapshot* snap = snapshot_build(q, s, 3);
+  printf("== Snapshot waiting calls (expect 6 7 8): %d %d %d\n",
+    snap->waiting[0].id, snap->waiting[1].id, snap->waiting[2].id);
+  printf("== Snapshot answered calls (expect 3: 5 4 3): %d: %d %d %d\n",
+    snap->n_answered, snap->answered[0].id, snap->answered[1].id,
+    snap->answered[2].id);
+  ok = ok && snap->n_waiting == 3 && snap->waiting[0].id == 6 &&
+    snap->waiting[2].id == 8 && snap->n_answered == 3 &&
+    snap->answered[0].id == 5 && snap->answered[2].id == 3;
+  snapshot_free(snap);
+  snap = snapshot_build(q, s, 10);
+  printf("== Snapshot of a short stack (expect 5, oldest 1): %d, oldest %d\n",
+    snap->n_answered, snap->answered[snap->n_answered - 1].id);
+  ok = ok && snap->n_answered == 5 && snap->answered[4].id == 1;
+  snapshot_free(snap);
+  while (queue_dequeue(q)) {
+  }
+  queue_free(q);
+  istack_free(s);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/*
+ * This file contains executable code for testing the timing wheel.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "timerwheel.h"
+
+int n = 200000;
+unsigned long long now;
+int early = 0, late = 0, fired = 0;
+
+/*
+ * Timer function: check that the timer fired on exactly its expiry tick.
+ */
+void expire(struct timer* t, void* ctx) {
+  unsigned long long expected = *(unsigned long long*)ctx;
+  if (now < expected) {
+    early++;
+  } else if (now > expected) {
+    late++;
+  }
+  fired++;
+}
+
+int main(int argc, char** argv) {
+  int i;
+  struct timer* timers = malloc(n * sizeof(struct timer));
+  unsigned long long* expires = malloc(n * sizeof(unsigned long long));
+  struct timerwheel* tw = timerwheel_create(1000);
+
+  /*
+   * Spread expiries over several levels of the wheel, and cancel every
+   * tenth timer.
+   */
+  srand(42);
+  for (i = 0; i < n; i++) {
+    unsigned long long span = i % 3 == 0 ? 300 : i % 3 == 1 ? 70000 : 20000000;
+    expires[i] = 1000 + (unsigned long long)rand() % span;
+    timer_init(&timers[i], expire, &expires[i]);
+    timerwheel_schedule(tw, &timers[i], expires[i]);
+  }
+  for (i = 0; i < n; i += 10) {
+    timerwheel_cancel(tw, &timers[i]);
+  }
+  printf("== Pending after cancelling a tenth (expect %d): %d\n",
+    n - n / 10, timerwheel_count(tw));
+
+  /*
+   * Advance one tick at a time for a while, then in big jumps; timers must
+   * fire on their exact tick either way.
+   */
+  for (now = 1000; now < 200000; now++) {
+    timerwheel_advance(tw, now);
+  }
+  printf("== Single-tick advance, early / late (expect 0 / 0): %d / %d\n",
+    early, late);
+  for (; now < 30000000; now += 4099) {
+    timerwheel_advance(tw, now);
+  }
+  timerwheel_advance(tw, now);
+  printf("== Fired (expect %d): %d\n", n - n / 10, fired);
+  printf("== Pending at end (expect 0): %d\n", timerwheel_count(tw));
+
+  int ok = early == 0 && fired == n - n / 10 && timerwheel_count(tw) == 0;
+  timerwheel_free(tw);
+
+  /*
+   * Advancing to timerwheel_next_expiry() each time, timers must still fire
+   * on their exact tick, with at most one advance per timer plus one per
+   * rotation of level 0 (256 ticks) crossed.
+   */
+  tw = timerwheel_create(1000);
+  early = late = fired = 0;
+  for (i = 0; i < 1000; i++) {
+    expires[i] = 1000 + (unsigned long long)rand() % (i % 2 ? 500 : 5000000);
+    timer_init(&timers[i], expire, &expires[i]);
+    timerwheel_schedule(tw, &timers[i], expires[i]);
+  }
+  int advances = 0;
+  while (timerwheel_count(tw) > 0) {
+    now = timerwheel_next_expiry(tw);
+    timerwheel_advance(tw, now);
+    advances++;
+  }
+  printf("== Advancing to the next expiry, early / late / fired "
+    "(expect 0 / 0 / 1000): %d / %d / %d\n", early, late, fired);
+  printf("== Advances (expect at most %d): %d\n", 1000 + 5000000 / 256 + 1,
+    advances);
+  ok = ok && early == 0 && late == 0 && fired == 1000 &&
+    advances <= 1000 + 5000000 / 256 + 1;
+  timerwheel_free(tw);
+  free(timers);
+  free(expires);
+  return ok ? 0 : 1;
+}
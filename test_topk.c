@@ -0,0 +1,89 @@
+/*
+ * This file contains executable code for testing the heavy-hitter tracker
+ * against exact counts, checking the guarantees of the Space-Saving
+ * algorithm.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "topk.h"
+
+#define KEYS 5000
+#define CALLS 200000
+#define COUNTERS 100
+
+int main(int argc, char** argv) {
+  struct topk* t = topk_create(COUNTERS);
+  struct topk_item top[COUNTERS];
+  long* exact = calloc(KEYS, sizeof(long));
+  char key[32];
+  int ok = 1, bad = 0;
+
+  /*
+   * Skewed keys: key u^4 * KEYS for uniform u, so the first few keys are
+   * far more frequent than the rest.
+   */
+  srand(5);
+  for (int i = 0; i < CALLS; i++) {
+    double u = (double)rand() / RAND_MAX;
+    int k = (int)(u * u * u * u * (KEYS - 1));
+    exact[k]++;
+    snprintf(key, sizeof(key), "reason %d", k);
+    topk_add(t, key);
+  }
+
+  /*
+   * Every count bounds the true count from both sides, and the list is in
+   * order.
+   */
+  int n = topk_top(t, COUNTERS, top);
+  for (int i = 0; i < n; i++) {
+    long truth = exact[atoi(top[i].key + 7)];
+    bad += truth > top[i].count || truth < top[i].count - top[i].error;
+    bad += i > 0 && top[i].count > top[i - 1].count;
+  }
+  printf("== Counters in use (expect %d): %d\n", COUNTERS, n);
+  printf("== Counts out of bounds or order (expect 0): %d\n", bad);
+  ok &= n == COUNTERS && bad == 0;
+
+  /*
+   * Every key with more than CALLS / COUNTERS occurrences is listed.
+   */
+  int missing = 0, frequent = 0;
+  for (int k = 0; k < KEYS; k++) {
+    if (exact[k] > CALLS / COUNTERS) {
+      int found = 0;
+      snprintf(key, sizeof(key), "reason %d", k);
+      for (int i = 0; i < n; i++) {
+        found |= strcmp(top[i].key, key) == 0;
+      }
+      frequent++;
+      missing += !found;
+    }
+  }
+  printf("== Frequent keys missing (expect 0 of %d): %d\n", frequent, missing);
+  ok &= missing == 0 && topk_total(t) == CALLS;
+
+  /*
+   * Long keys are cut short but still counted together.
+   */
+  struct topk* small = topk_create(2);
+  char long_key[300];
+  memset(long_key, 'x', sizeof(long_key) - 1);
+  long_key[sizeof(long_key) - 1] = '\0';
+  topk_add(small, long_key);
+  long_key[200] = 'y';
+  topk_add(small, long_key);
+  topk_add(small, "short");
+  n = topk_top(small, 2, top);
+  printf("== Long keys, top count / key length (expect 2 / %d): %ld / %d\n",
+    TOPK_KEY_MAX - 1, top[0].count, (int)strlen(top[0].key));
+  ok &= n == 2 && top[0].count == 2 && strlen(top[0].key) == TOPK_KEY_MAX - 1;
+
+  topk_free(small);
+  topk_free(t);
+  free(exact);
+  return ok ? 0 : 1;
+}
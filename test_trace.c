@@ -0,0 +1,188 @@
+/*
+ * This file contains executable code for testing trace reading and
+ * writing.  The same events are written in both formats and must read back
+ * the same, and malformed traces must be reported with where they go
+ * wrong.  tracegen, run twice with the same seed, must write the same
+ * trace byte for byte.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+#include "trace.h"
+
+#define TEXT_PATH "/tmp/test_trace.txt"
+#define BINARY_PATH "/tmp/test_trace.bin"
+#define GEN_PATH "/tmp/test_trace_gen"
+#define N 1000
+
+const char* names[3] = { "ann", "bob", "AVeryLongCallerNameThatGetsCutShort" };
+const char* reasons[2] = { "billing question", "password reset" };
+
+/*
+ * Writes the test events: calls cycling through the names and reasons, and
+ * an answer after every third call.
+ */
+void write_events(const char* path, int binary) {
+  struct trace_writer* w = trace_writer_open(path, binary);
+  for (int i = 0; i < N; i++) {
+    trace_write_call(w, i * 7, i % 3, names[i % 3], i % 2, reasons[i % 2]);
+    if (i % 3 == 2) {
+      trace_write_answer(w, i * 7 + 3);
+    }
+  }
+  trace_writer_close(w);
+}
+
+/*
+ * Reads the test events back and returns the number that don't match.
+ */
+int check_events(const char* path) {
+  struct trace_reader* r = trace_reader_open(path);
+  struct trace_event ev;
+  int bad = 0;
+  for (int i = 0; i < N; i++) {
+    bad += trace_read(r, &ev) != 1 || ev.type != TRACE_CALL ||
+      ev.t_ms != i * 7 || strncmp(ev.name, names[i % 3], 29) != 0 ||
+      strlen(ev.name) > 29 || strcmp(ev.reason, reasons[i % 2]) != 0;
+    if (i % 3 == 2) {
+      bad += trace_read(r, &ev) != 1 || ev.type != TRACE_ANSWER ||
+        ev.t_ms != i * 7 + 3;
+    }
+  }
+  bad += trace_read(r, &ev) != 0;
+  trace_reader_close(r);
+  return bad;
+}
+
+/*
+ * Writes `len` bytes to a file and returns what reading it fails with, or
+ * "" if it reads to the end.
+ */
+const char* read_error(const char* data, size_t len) {
+  static char error[128];
+  struct trace_event ev;
+  FILE* f = fopen(TEXT_PATH, "wb");
+  fwrite(data, 1, len, f);
+  fclose(f);
+  struct trace_reader* r = trace_reader_open(TEXT_PATH);
+  int got;
+  while ((got = trace_read(r, &ev)) > 0) {
+  }
+  snprintf(error, sizeof(error), "%s", got < 0 ? trace_reader_error(r) : "");
+  trace_reader_close(r);
+  return error;
+}
+
+/*
+ * Runs tracegen with the given seed, writing 20000 events to `path`.
+ * Returns 1 if it succeeded.
+ */
+int run_tracegen(const char* path, int seed, int binary) {
+  char seed_arg[32], output_arg[80];
+  snprintf(seed_arg, sizeof(seed_arg), "--seed=%d", seed);
+  snprintf(output_arg, sizeof(output_arg), "--output=%s", path);
+  pid_t child = fork();
+  if (child == 0) {
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDERR_FILENO); // Keep tracegen's summary out of the results
+    execl("./tracegen", "tracegen", seed_arg, "--events=20000",
+      "--burst-every=600", binary ? "--binary" : "--rate=10", output_arg,
+      (char*)NULL);
+    _exit(127);
+  }
+  int status;
+  return child > 0 && waitpid(child, &status, 0) == child &&
+    WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/*
+ * Returns 1 if two files hold the same bytes.
+ */
+int same_bytes(const char* path_a, const char* path_b) {
+  FILE* a = fopen(path_a, "rb");
+  FILE* b = fopen(path_b, "rb");
+  int same = a && b, c = 0;
+  while (same && c != EOF) {
+    c = getc(a);
+    same = c == getc(b);
+  }
+  if (a) {
+    fclose(a);
+  }
+  if (b) {
+    fclose(b);
+  }
+  return same;
+}
+
+/*
+ * Runs tracegen twice with one seed and once with another, and returns 1
+ * if the first two traces are identical and the third is not.
+ */
+int tracegen_repeats(int binary) {
+  int ran = run_tracegen(GEN_PATH ".1", 42, binary) &&
+    run_tracegen(GEN_PATH ".2", 42, binary) &&
+    run_tracegen(GEN_PATH ".3", 43, binary);
+  int repeats = ran && same_bytes(GEN_PATH ".1", GEN_PATH ".2") &&
+    !same_bytes(GEN_PATH ".1", GEN_PATH ".3");
+  remove(GEN_PATH ".1");
+  remove(GEN_PATH ".2");
+  remove(GEN_PATH ".3");
+  return repeats;
+}
+
+int main(int argc, char** argv) {
+  int ok = 1, bad;
+
+  write_events(TEXT_PATH, 0);
+  bad = check_events(TEXT_PATH);
+  printf("== Text events read back wrong (expect 0): %d\n", bad);
+  ok &= bad == 0;
+
+  write_events(BINARY_PATH, 1);
+  bad = check_events(BINARY_PATH);
+  printf("== Binary events read back wrong (expect 0): %d\n", bad);
+  ok &= bad == 0;
+
+  FILE* f = fopen(BINARY_PATH, "rb");
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fclose(f);
+  printf("== Binary trace, bytes per event (expect under 5): %.2f\n",
+    (double)size / (N + N / 3));
+  ok &= size < 5 * (N + N / 3);
+
+  const char* text = "# comment\n\n10 call ann billing\n5 answer\n";
+  const char* err = read_error(text, strlen(text));
+  printf("== Time going backwards (expect line 4: ...): %s\n", err);
+  ok &= strncmp(err, "line 4:", 7) == 0;
+  text = "10 hangup\n";
+  err = read_error(text, strlen(text));
+  printf("== Unknown event (expect line 1: unknown event): %s\n", err);
+  ok &= strcmp(err, "line 1: unknown event") == 0;
+
+  // A call record cut off after its name ID
+  const char binary[] = TRACE_MAGIC "\x02\x00\x03" "ann" "\x03\x00\x01" "x" "\x29\x00";
+  err = read_error(binary, sizeof(binary) - 1);
+  printf("== Truncated binary (expect byte 20: truncated record): %s\n", err);
+  ok &= strcmp(err, "byte 20: truncated record") == 0;
+  err = read_error(binary, sizeof(binary) - 3);
+  printf("== Binary cut between records reads cleanly (expect ''): '%s'\n", err);
+  ok &= strcmp(err, "") == 0;
+
+  int text_repeats = tracegen_repeats(0), binary_repeats = tracegen_repeats(1);
+  printf("== tracegen, same seed, same bytes (expect text 1, binary 1): "
+    "text %d, binary %d\n", text_repeats, binary_repeats);
+  ok &= text_repeats && binary_repeats;
+
+  remove(TEXT_PATH);
+  remove(BINARY_PATH);
+  return ok ? 0 : 1;
+}
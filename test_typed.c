@@ -0,0 +1,67 @@
+/*
+ * This file contains executable code for testing the typed queue and stack
+ * generated by DEFINE_QUEUE() and DEFINE_STACK().
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "call.h"
+#include "typed_queue.h"
+#include "typed_stack.h"
+
+DEFINE_QUEUE(call_queue, Call)
+DEFINE_STACK(int_stack, int)
+
+int main(int argc, char** argv) {
+  int i, n = 100, ok = 1;
+  struct call_queue* q = call_queue_create();
+  struct int_stack* s = int_stack_create();
+
+  /*
+   * Interleave enqueues and dequeues so the circular buffer wraps and grows.
+   */
+  int next_in = 0, next_out = 0;
+  for (i = 0; i < n; i++) {
+    Call c;
+    c.id = next_in++;
+    snprintf(c.caller_name, sizeof(c.caller_name), "caller%d", c.id);
+    call_queue_enqueue(q, c);
+    if (i % 3 == 2) {
+      Call out = call_queue_dequeue(q);
+      char expected[30];
+      snprintf(expected, sizeof(expected), "caller%d", next_out);
+      if (out.id != next_out++ || strcmp(out.caller_name, expected) != 0) {
+        ok = 0;
+      }
+    }
+  }
+  printf("== Queue size (expect %d): %d\n", next_in - next_out,
+    call_queue_size(q));
+  printf("== Queue front / get(0) (expect %d / %d): %d / %d\n", next_out,
+    next_out, call_queue_front(q).id, call_queue_get(q, 0)->id);
+  while (!call_queue_isempty(q)) {
+    if (call_queue_dequeue(q).id != next_out++) {
+      ok = 0;
+    }
+  }
+  printf("== Queue FIFO order kept (expect 1): %d\n", ok);
+
+  for (i = 0; i < n; i++) {
+    int_stack_push(s, i * i);
+  }
+  printf("== Stack size / top / get(1) (expect %d / %d / %d): %d / %d / %d\n",
+    n, (n - 1) * (n - 1), (n - 2) * (n - 2), int_stack_size(s),
+    int_stack_top(s), *int_stack_get(s, 1));
+  for (i = n - 1; i >= 0; i--) {
+    if (int_stack_pop(s) != i * i) {
+      ok = 0;
+    }
+  }
+  printf("== Stack LIFO order kept, now empty (expect 1): %d\n",
+    ok && int_stack_isempty(s));
+
+  call_queue_free(q);
+  int_stack_free(s);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+/*
+ * This file contains executable code for testing the sliding-window
+ * statistics.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "winstats.h"
+
+#define SEC 1000000000LL
+
+int main(int argc, char** argv) {
+  struct winstats* ws = winstats_create(20 * SEC, 5 * SEC);
+  struct winstats_window w;
+  int ok = 1;
+
+  /*
+   * One call received every second for 20 minutes, answered half a second
+   * later after a wait that alternates between 10 s and 30 s.
+   */
+  for (int s = 0; s < 1200; s++) {
+    long long t = 5 * SEC + s * SEC;
+    winstats_received(ws, t);
+    winstats_answered(ws, s % 2 ? 30 * SEC : 10 * SEC, t + SEC / 2);
+  }
+  long long end = 5 * SEC + 1199 * SEC + SEC / 2;
+  winstats_window(ws, 60, end, &w);
+  printf("== Last minute, received / answered / within (expect 60 / 60 / 30): "
+    "%ld / %ld / %ld\n", w.received, w.answered, w.within);
+  ok &= w.received == 60 && w.answered == 60 && w.within == 30;
+  winstats_window(ws, WINSTATS_SECONDS, end, &w);
+  printf("== Last 15 minutes, received (expect %d): %ld\n", WINSTATS_SECONDS,
+    w.received);
+  ok &= w.received == WINSTATS_SECONDS && w.seconds == WINSTATS_SECONDS;
+
+  /*
+   * After a quiet spell longer than the ring, nothing is left in any
+   * window, even though the buckets were never touched.
+   */
+  end += 1000 * SEC;
+  winstats_window(ws, WINSTATS_SECONDS, end, &w);
+  printf("== After 1000 quiet seconds, received (expect 0): %ld\n", w.received);
+  ok &= w.received == 0 && w.answered == 0;
+
+  /*
+   * An event after the gap lands in a stale bucket, which must be reset.
+   */
+  winstats_received(ws, end);
+  winstats_window(ws, 5, end, &w);
+  printf("== One new call, received (expect 1): %ld\n", w.received);
+  ok &= w.received == 1;
+  winstats_free(ws);
+
+  /*
+   * A window longer than the program has run is shortened to match.
+   */
+  ws = winstats_create(20 * SEC, 0);
+  winstats_received(ws, 2 * SEC);
+  winstats_window(ws, 60, 3 * SEC, &w);
+  printf("== Window 3 s into the run (expect 3.0 s, 1 received): %.1f s, %ld "
+    "received\n", w.seconds, w.received);
+  ok &= w.seconds == 3.0 && w.received == 1;
+  winstats_free(ws);
+
+  return ok ? 0 : 1;
+}
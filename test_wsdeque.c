@@ -0,0 +1,92 @@
+/*
+ * This file contains executable code for testing the work-stealing deque.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "wsdeque.h"
+
+#define N_THIEVES 3
+
+int n = 200000;
+int* seen;
+int owner_done = 0;
+struct wsdeque* dq;
+
+/*
+ * Thread body of a thief: steal until the owner is done and the deque is
+ * empty, marking every value seen.
+ */
+void* thief(void* arg) {
+  long stolen = 0;
+  while (!__atomic_load_n(&owner_done, __ATOMIC_ACQUIRE) || wsdeque_size(dq)) {
+    int* val = wsdeque_steal(dq);
+    if (val) {
+      __atomic_add_fetch(&seen[*val], 1, __ATOMIC_RELAXED);
+      stolen++;
+    }
+  }
+  return (void*)stolen;
+}
+
+int main(int argc, char** argv) {
+  int i, *test_data, ok;
+  pthread_t thieves[N_THIEVES];
+
+  /*
+   * Single-threaded: pop order is LIFO, steal order is FIFO.
+   */
+  test_data = malloc(n * sizeof(int));
+  for (i = 0; i < n; i++) {
+    test_data[i] = i;
+  }
+  dq = wsdeque_create();
+  for (i = 0; i < 8; i++) {
+    wsdeque_push(dq, &test_data[i]);
+  }
+  printf("== Size after 8 pushes (expect 8): %d\n", wsdeque_size(dq));
+  printf("== Pop / steal: %d / %d (expect 7 / 0)\n",
+    *(int*)wsdeque_pop(dq), *(int*)wsdeque_steal(dq));
+  while (wsdeque_pop(dq)) {}
+  printf("== Empty pop and steal return NULL (expect 1): %d\n",
+    wsdeque_pop(dq) == NULL && wsdeque_steal(dq) == NULL);
+
+  /*
+   * Concurrent: the owner pushes everything (forcing the buffer to grow) and
+   * pops some back while thieves steal.  Every value must be seen once.
+   */
+  seen = calloc(n, sizeof(int));
+  for (i = 0; i < N_THIEVES; i++) {
+    pthread_create(&thieves[i], NULL, thief, NULL);
+  }
+  for (i = 0; i < n; i++) {
+    wsdeque_push(dq, &test_data[i]);
+    if (i % 3 == 0) {
+      int* val = wsdeque_pop(dq);
+      if (val) {
+        seen[*val]++;
+      }
+    }
+  }
+  __atomic_store_n(&owner_done, 1, __ATOMIC_RELEASE);
+  for (i = 0; i < N_THIEVES; i++) {
+    pthread_join(thieves[i], NULL);
+  }
+
+  ok = 1;
+  for (i = 0; i < n; i++) {
+    if (seen[i] != 1) {
+      ok = 0;
+    }
+  }
+  printf("== Every value taken exactly once (expect 1): %d\n", ok);
+
+  wsdeque_free(dq);
+  free(seen);
+  free(test_data);
+  return ok ? 0 : 1;
+}
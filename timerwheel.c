@@ -0,0 +1,351 @@
+/*
+ * This file contains an implementation of a hierarchical timing wheel
+ * (Varghese and Lauck, "Hashed and Hierarchical Timing Wheels", SOSP 1987).
+ * Time is measured in integer ticks whose length is up to the caller.
+ *
+ * The wheel has TW_LEVELS levels of TW_SLOTS slots each.  Level 0 has one
+ * slot per tick; each slot of level k covers TW_SLOTS^k ticks.  A timer is
+ * filed in the lowest level whose span covers its distance from the current
+ * tick, and each slot is a doubly-linked list, so scheduling and cancelling
+ * are O(1).  Whenever level 0 wraps around, the next slot of level 1 is
+ * emptied and its timers are re-filed one level down (and likewise up the
+ * hierarchy), so a timer is touched at most once per level before it fires.
+ * Advancing never scans the pending timers: a bitmap of occupied level-0
+ * slots lets idle stretches be skipped a whole rotation at a time.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdint.h>
+
+#include "timerwheel.h"
+
+#define TW_BITS 8
+#define TW_SLOTS (1 << TW_BITS)
+#define TW_MASK (TW_SLOTS - 1)
+#define TW_LEVELS 4
+#define TW_MAX_DELTA ((1ULL << (TW_BITS * TW_LEVELS)) - 1)
+
+/*
+ * This structure is used to represent a timing wheel.  Each slot is the
+ * sentinel node of a circular list.  `current` is the next tick to be
+ * processed.
+ */
+struct timerwheel {
+  struct timer slots[TW_LEVELS][TW_SLOTS];
+  uint64_t occupied[TW_SLOTS / 64]; // Non-empty slots of level 0
+  unsigned long long current;
+  int count;
+};
+
+/*
+ * This function prepares a timer for use.  A timer must not be initialized
+ * again while it is pending.
+ *
+ * Params:
+ *   t - the timer to initialize.  May not be NULL.
+ *   fn - the function called with `t` and `ctx` when the timer expires.
+ *   ctx - passed through to `fn`.
+ */
+void timer_init(struct timer* t, void (*fn)(struct timer* t, void* ctx),
+    void* ctx) {
+  assert(t);
+  t->next = t->prev = NULL;
+  t->expires = 0;
+  t->fn = fn;
+  t->ctx = ctx;
+}
+
+/*
+ * This function returns 1 if a timer is scheduled and has neither expired
+ * nor been cancelled, and 0 otherwise.
+ */
+int timer_pending(struct timer* t) {
+  assert(t);
+  return t->next != NULL;
+}
+
+/*
+ * This function allocates and initializes a new, empty timing wheel and
+ * returns a pointer to it.
+ *
+ * Params:
+ *   now - the current tick.
+ */
+struct timerwheel* timerwheel_create(unsigned long long now) {
+  struct timerwheel* tw = malloc(sizeof(struct timerwheel));
+  assert(tw);
+  for (int l = 0; l < TW_LEVELS; l++) {
+    for (int s = 0; s < TW_SLOTS; s++) {
+      tw->slots[l][s].next = tw->slots[l][s].prev = &tw->slots[l][s];
+    }
+  }
+  for (int i = 0; i < TW_SLOTS / 64; i++) {
+    tw->occupied[i] = 0;
+  }
+  tw->current = now;
+  tw->count = 0;
+  return tw;
+}
+
+/*
+ * This function frees the memory associated with a timing wheel.  Any timers
+ * still pending are simply forgotten; use timerwheel_clear() first if they
+ * need cleaning up.
+ *
+ * Params:
+ *   tw - the timing wheel to be destroyed.  May not be NULL.
+ */
+void timerwheel_free(struct timerwheel* tw) {
+  assert(tw);
+  free(tw);
+}
+
+/*
+ * Auxilliary functions to link a timer into, and unlink it from, a slot.
+ */
+static void _slot_add(struct timerwheel* tw, int level, int slot,
+    struct timer* t) {
+  struct timer* head = &tw->slots[level][slot];
+  t->next = head;
+  t->prev = head->prev;
+  head->prev->next = t;
+  head->prev = t;
+  if (level == 0) {
+    tw->occupied[slot / 64] |= 1ULL << (slot % 64);
+  }
+}
+
+static void _unlink(struct timer* t) {
+  t->prev->next = t->next;
+  t->next->prev = t->prev;
+  t->next = t->prev = NULL;
+}
+
+/*
+ * Auxilliary function to file a timer in the slot matching its distance
+ * from the current tick.  Timers already due go in the slot for the current
+ * tick; timers beyond the wheel's range go in the farthest slot of the top
+ * level and are re-filed when it is cascaded.
+ */
+static void _file(struct timerwheel* tw, struct timer* t) {
+  unsigned long long expires = t->expires;
+  if (expires < tw->current) {
+    expires = tw->current;
+  } else if (expires - tw->current > TW_MAX_DELTA) {
+    expires = tw->current + TW_MAX_DELTA;
+  }
+
+  unsigned long long delta = expires - tw->current;
+  int level = 0;
+  while (level < TW_LEVELS - 1 && delta >= (1ULL << (TW_BITS * (level + 1)))) {
+    level++;
+  }
+  _slot_add(tw, level, (expires >> (TW_BITS * level)) & TW_MASK, t);
+}
+
+/*
+ * This function schedules a timer to expire at a given tick.  If the timer
+ * is already pending it is rescheduled.
+ *
+ * Params:
+ *   tw - the timing wheel.  May not be NULL.
+ *   t - the timer to schedule.  May not be NULL.
+ *   expires - the tick at which the timer should expire.  A tick that has
+ *     already passed makes the timer expire on the next advance.
+ */
+void timerwheel_schedule(struct timerwheel* tw, struct timer* t,
+    unsigned long long expires) {
+  assert(tw && t);
+  if (timer_pending(t)) {
+    _unlink(t);
+    tw->count--;
+  }
+  t->expires = expires;
+  _file(tw, t);
+  tw->count++;
+}
+
+/*
+ * This function cancels a pending timer.  Cancelling a timer that is not
+ * pending does nothing.
+ *
+ * Params:
+ *   tw - the timing wheel the timer was scheduled on.  May not be NULL.
+ *   t - the timer to cancel.  May not be NULL.
+ */
+void timerwheel_cancel(struct timerwheel* tw, struct timer* t) {
+  assert(tw && t);
+  if (timer_pending(t)) {
+    _unlink(t);
+    tw->count--;
+  }
+}
+
+/*
+ * Auxilliary function to empty one slot of a level above 0 and re-file its
+ * timers relative to the current tick.
+ */
+static void _cascade(struct timerwheel* tw, int level, int slot) {
+  struct timer* head = &tw->slots[level][slot];
+  struct timer* t = head->next;
+  head->next = head->prev = head;
+  while (t != head) {
+    struct timer* next = t->next;
+    _file(tw, t);
+    t = next;
+  }
+}
+
+/*
+ * Auxilliary function returning the first occupied level-0 slot at or after
+ * `slot`, or TW_SLOTS if there is none.
+ */
+static int _next_occupied(struct timerwheel* tw, int slot) {
+  for (int w = slot / 64; w < TW_SLOTS / 64; w++) {
+    uint64_t bits = tw->occupied[w];
+    if (w == slot / 64) {
+      bits &= ~0ULL << (slot % 64);
+    }
+    if (bits) {
+      return w * 64 + __builtin_ctzll(bits);
+    }
+  }
+  return TW_SLOTS;
+}
+
+/*
+ * This function advances a timing wheel up to and including a given tick,
+ * calling the function of every timer that expires on the way, in order of
+ * expiry.  A timer's function may schedule timers, including itself.
+ *
+ * Params:
+ *   tw - the timing wheel.  May not be NULL.
+ *   now - the tick to advance to.
+ *
+ * Return:
+ *   Returns the number of timers that expired.
+ */
+int timerwheel_advance(struct timerwheel* tw, unsigned long long now) {
+  assert(tw);
+  int fired = 0;
+
+  while (tw->current <= now) {
+    if (tw->count == 0) {
+      tw->current = now + 1;
+      break;
+    }
+
+    int slot = tw->current & TW_MASK;
+    if (slot == 0) {
+      for (int l = 1; l < TW_LEVELS; l++) {
+        int s = (tw->current >> (TW_BITS * l)) & TW_MASK;
+        _cascade(tw, l, s);
+        if (s != 0) {
+          break;
+        }
+      }
+    }
+
+    /*
+     * Skip straight to the next occupied slot of this rotation, or to the
+     * end of the rotation if there is none.
+     */
+    int next = _next_occupied(tw, slot);
+    unsigned long long tick = tw->current - slot + next;
+    if (next == TW_SLOTS || tick > now) {
+      unsigned long long end = tw->current - slot + TW_SLOTS;
+      tw->current = end < now + 1 ? end : now + 1;
+      continue;
+    }
+
+    /*
+     * Detach the slot before running anything, since timer functions may
+     * schedule new timers into it.  The slot may turn out to be empty if
+     * its timers were cancelled.
+     */
+    struct timer* head = &tw->slots[0][next];
+    struct timer* t = NULL;
+    if (head->next != head) {
+      t = head->next;
+      head->prev->next = NULL;
+      head->next = head->prev = head;
+    }
+    tw->occupied[next / 64] &= ~(1ULL << (next % 64));
+    tw->current = tick + 1;
+
+    while (t) {
+      struct timer* following = t->next;
+      t->next = t->prev = NULL;
+      tw->count--;
+      fired++;
+      t->fn(t, t->ctx);
+      t = following;
+    }
+  }
+  return fired;
+}
+
+/*
+ * This function returns the tick to advance a timing wheel to for the next
+ * timers to expire, without passing any: the tick of the next occupied
+ * level-0 slot of the current rotation, or else the first tick of the next
+ * rotation, since timers further off are only sorted into level 0 as a
+ * rotation starts.  Advancing to it may therefore fire no timers, but a caller
+ * looping on it moves through idle stretches a rotation at a time rather
+ * than a tick at a time.
+ *
+ * Params:
+ *   tw - the timing wheel.  May not be NULL, and must have timers pending.
+ *
+ * Return:
+ *   Returns a tick no later than the expiry of any pending timer, and no
+ *   earlier than the next tick to be processed.
+ */
+unsigned long long timerwheel_next_expiry(struct timerwheel* tw) {
+  assert(tw && tw->count > 0);
+  int slot = tw->current & TW_MASK;
+  if (slot == 0) {
+    return tw->current; // Level 0 is only filled once this tick cascades
+  }
+  int next = _next_occupied(tw, slot);
+  return tw->current - slot + next; // The next rotation if next == TW_SLOTS
+}
+
+/*
+ * This function cancels every pending timer in a timing wheel, passing each
+ * one to a given function, e.g. to free the object it is embedded in.
+ *
+ * Params:
+ *   tw - the timing wheel.  May not be NULL.
+ *   fn - called with each cancelled timer and `ctx`.  May be NULL.
+ *   ctx - passed through to `fn`.
+ */
+void timerwheel_clear(struct timerwheel* tw,
+    void (*fn)(struct timer* t, void* ctx), void* ctx) {
+  assert(tw);
+  for (int l = 0; l < TW_LEVELS; l++) {
+    for (int s = 0; s < TW_SLOTS; s++) {
+      struct timer* head = &tw->slots[l][s];
+      while (head->next != head) {
+        struct timer* t = head->next;
+        _unlink(t);
+        tw->count--;
+        if (fn) {
+          fn(t, ctx);
+        }
+      }
+    }
+  }
+  for (int i = 0; i < TW_SLOTS / 64; i++) {
+    tw->occupied[i] = 0;
+  }
+}
+
+/*
+ * This function returns the number of pending timers in a timing wheel.
+ */
+int timerwheel_count(struct timerwheel* tw) {
+  assert(tw);
+  return tw->count;
+}
@@ -0,0 +1,47 @@
+/*
+ * This file contains the definition of the interface for a hierarchical
+ * timing wheel.  You can find descriptions of the timing wheel functions,
+ * including their parameters and their return values, in timerwheel.c.
+ */
+
+#ifndef __TIMERWHEEL_H
+#define __TIMERWHEEL_H
+
+/*
+ * Structure used to represent a single timer.  Timers are allocated by the
+ * caller, typically embedded in the object they time, and must be set up
+ * with timer_init() before first use.  The fields are private to
+ * timerwheel.c.
+ */
+struct timer {
+  struct timer* next;
+  struct timer* prev;
+  unsigned long long expires;
+  void (*fn)(struct timer* t, void* ctx);
+  void* ctx;
+};
+
+/*
+ * Structure used to represent a timing wheel.
+ */
+struct timerwheel;
+
+/*
+ * Timing wheel interface function prototypes.  Refer to timerwheel.c for
+ * documentation about each of these functions.
+ */
+void timer_init(struct timer* t, void (*fn)(struct timer* t, void* ctx),
+    void* ctx);
+int timer_pending(struct timer* t);
+struct timerwheel* timerwheel_create(unsigned long long now);
+void timerwheel_free(struct timerwheel* tw);
+void timerwheel_schedule(struct timerwheel* tw, struct timer* t,
+    unsigned long long expires);
+void timerwheel_cancel(struct timerwheel* tw, struct timer* t);
+int timerwheel_advance(struct timerwheel* tw, unsigned long long now);
+unsigned long long timerwheel_next_expiry(struct timerwheel* tw);
+void timerwheel_clear(struct timerwheel* tw,
+    void (*fn)(struct timer* t, void* ctx), void* ctx);
+int timerwheel_count(struct timerwheel* tw);
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * This file contains a small wrapper around the system's monotonic clock,
+ * and a comparison function for sorting the times it gives.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+
+#include "timeutil.h"
+
+/*
+ * This function returns the current value of a monotonic clock in
+ * nanoseconds.  The value has no meaning on its own; only differences
+ * between two readings are meaningful.
+ */
+long long now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * This function compares two long longs, such as times or wait times, for
+ * sorting them in increasing order with qsort().
+ *
+ * Params:
+ *   a, b - pointers to the two values.
+ *
+ * Return:
+ *   Returns a negative value, 0 or a positive value as *a is less than,
+ *   equal to or greater than *b.
+ */
+int cmp_ll(const void* a, const void* b) {
+  long long x = *(const long long*)a, y = *(const long long*)b;
+  return (x > y) - (x < y);
+}
@@ -0,0 +1,13 @@
+/*
+ * This file contains the definition of the interface for reading the clock
+ * used to time calls and sorting the times taken.  You can find
+ * descriptions of the functions in timeutil.c.
+ */
+
+#ifndef __TIMEUTIL_H
+#define __TIMEUTIL_H
+
+long long now_ns();
+int cmp_ll(const void* a, const void* b);
+
+#endif
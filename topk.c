@@ -0,0 +1,330 @@
+/*
+ * This file contains an implementation of a heavy-hitter tracker using the
+ * Space-Saving algorithm.  The tracker has a fixed number of counters.  A
+ * key that already has a counter increments it; a new key takes a free
+ * counter if there is one, and otherwise takes over the counter with the
+ * smallest count, inheriting that count (recorded as its possible error)
+ * plus one.  Any key occurring more than total / capacity times is
+ * guaranteed to hold a counter, and counts are never too low.
+ *
+ * The counters are kept in a stream summary: a list of buckets in order of
+ * increasing count, each holding a list of the counters with that count.
+ * Incrementing a counter moves it to the next bucket up, creating that
+ * bucket if the count isn't there yet, so every update is O(1), and the
+ * smallest counter is always the first one of the first bucket.  Keys are
+ * found through an open-addressing hash table of counter indices.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "sketch.h"
+#include "topk.h"
+
+/*
+ * This structure is used to represent a counter.  Its count is the count of
+ * the bucket it is in.
+ */
+struct topk_counter {
+  uint64_t hash;
+  long error;
+  struct topk_bucket* bucket;
+  struct topk_counter* prev;
+  struct topk_counter* next;
+  char key[TOPK_KEY_MAX];
+};
+
+/*
+ * This structure is used to represent a bucket: every counter with a given
+ * count.
+ */
+struct topk_bucket {
+  long count;
+  struct topk_counter* first;
+  struct topk_bucket* prev;
+  struct topk_bucket* next;
+};
+
+/*
+ * This structure is used to represent a heavy-hitter tracker.  `min` and
+ * `max` are the first and last buckets.  There can't be more buckets than
+ * counters, so buckets come from a pool of `capacity`, with unused ones on
+ * a free list.  `table` holds counter indices, or -1 for an empty slot.
+ */
+struct topk {
+  int capacity;
+  int used;
+  long total;
+  struct topk_counter* counters;
+  struct topk_bucket* pool;
+  struct topk_bucket* free_buckets;
+  struct topk_bucket* min;
+  struct topk_bucket* max;
+  int* table;
+  uint64_t mask;
+};
+
+/*
+ * This function creates a heavy-hitter tracker.
+ *
+ * Params:
+ *   capacity - the number of counters.  More counters make the counts of
+ *     the top keys more accurate.  Must be positive.
+ *
+ * Return:
+ *   Returns a pointer to the new tracker.
+ */
+struct topk* topk_create(int capacity) {
+  assert(capacity > 0);
+  struct topk* t = malloc(sizeof(struct topk));
+  assert(t);
+  t->capacity = capacity;
+  t->used = 0;
+  t->total = 0;
+  t->counters = malloc(capacity * sizeof(struct topk_counter));
+  t->pool = malloc(capacity * sizeof(struct topk_bucket));
+  assert(t->counters && t->pool);
+  t->free_buckets = NULL;
+  for (int i = 0; i < capacity; i++) {
+    t->pool[i].next = t->free_buckets;
+    t->free_buckets = &t->pool[i];
+  }
+  t->min = t->max = NULL;
+
+  uint64_t size = 1;
+  while (size < 2 * (uint64_t)capacity) {
+    size *= 2; // At most half full
+  }
+  t->mask = size - 1;
+  t->table = malloc(size * sizeof(int));
+  assert(t->table);
+  memset(t->table, -1, size * sizeof(int));
+  return t;
+}
+
+/*
+ * This function frees the memory associated with a heavy-hitter tracker.
+ *
+ * Params:
+ *   t - the tracker to be destroyed.  May not be NULL.
+ */
+void topk_free(struct topk* t) {
+  assert(t);
+  free(t->counters);
+  free(t->pool);
+  free(t->table);
+  free(t);
+}
+
+/*
+ * Auxilliary function to find the hash table slot holding a key, or the
+ * empty slot where it would go.
+ */
+static uint64_t _topk_slot(struct topk* t, const char* key, uint64_t hash) {
+  uint64_t i = hash & t->mask;
+  while (t->table[i] >= 0) {
+    struct topk_counter* c = &t->counters[t->table[i]];
+    if (c->hash == hash && strcmp(c->key, key) == 0) {
+      break;
+    }
+    i = (i + 1) & t->mask;
+  }
+  return i;
+}
+
+/*
+ * Auxilliary function to empty a hash table slot, shifting later entries of
+ * the same probe run back so lookups never stop short at the gap.
+ */
+static void _topk_unslot(struct topk* t, uint64_t i) {
+  uint64_t j = i;
+  for (;;) {
+    j = (j + 1) & t->mask;
+    if (t->table[j] < 0) {
+      break;
+    }
+    uint64_t home = t->counters[t->table[j]].hash & t->mask;
+    // Move the entry at j back to i unless its home lies between them
+    if (((j - home) & t->mask) >= ((j - i) & t->mask)) {
+      t->table[i] = t->table[j];
+      i = j;
+    }
+  }
+  t->table[i] = -1;
+}
+
+/*
+ * Auxilliary functions to take a bucket from the pool and link it in after
+ * `prev` (at the front if `prev` is NULL), and to unlink an empty bucket and
+ * give it back.
+ */
+static struct topk_bucket* _topk_bucket_new(struct topk* t, long count,
+    struct topk_bucket* prev) {
+  struct topk_bucket* b = t->free_buckets;
+  assert(b);
+  t->free_buckets = b->next;
+  b->count = count;
+  b->first = NULL;
+  b->prev = prev;
+  b->next = prev ? prev->next : t->min;
+  if (b->next) {
+    b->next->prev = b;
+  } else {
+    t->max = b;
+  }
+  if (prev) {
+    prev->next = b;
+  } else {
+    t->min = b;
+  }
+  return b;
+}
+
+static void _topk_bucket_drop(struct topk* t, struct topk_bucket* b) {
+  if (b->prev) {
+    b->prev->next = b->next;
+  } else {
+    t->min = b->next;
+  }
+  if (b->next) {
+    b->next->prev = b->prev;
+  } else {
+    t->max = b->prev;
+  }
+  b->next = t->free_buckets;
+  t->free_buckets = b;
+}
+
+/*
+ * Auxilliary functions to put a counter into a bucket and to take it out.
+ */
+static void _topk_attach(struct topk_counter* c, struct topk_bucket* b) {
+  c->bucket = b;
+  c->prev = NULL;
+  c->next = b->first;
+  if (b->first) {
+    b->first->prev = c;
+  }
+  b->first = c;
+}
+
+static void _topk_detach(struct topk_counter* c) {
+  if (c->prev) {
+    c->prev->next = c->next;
+  } else {
+    c->bucket->first = c->next;
+  }
+  if (c->next) {
+    c->next->prev = c->prev;
+  }
+}
+
+/*
+ * Auxilliary function to add one to a counter by moving it to the next
+ * bucket up.
+ */
+static void _topk_increment(struct topk* t, struct topk_counter* c) {
+  struct topk_bucket* b = c->bucket;
+  struct topk_bucket* up = b->next;
+  if (!up || up->count != b->count + 1) {
+    if (b->first == c && c->next == NULL) {
+      b->count++; // Alone in its bucket, which can simply move up a count
+      return;
+    }
+    up = _topk_bucket_new(t, b->count + 1, b);
+  }
+  _topk_detach(c);
+  _topk_attach(c, up);
+  if (!b->first) {
+    _topk_bucket_drop(t, b);
+  }
+}
+
+/*
+ * This function counts one occurrence of a key.
+ *
+ * Params:
+ *   t - the tracker.  May not be NULL.
+ *   key - the key.  Copied, and cut to TOPK_KEY_MAX - 1 characters.  May
+ *     not be NULL.
+ */
+void topk_add(struct topk* t, const char* key) {
+  assert(t && key);
+  char cut[TOPK_KEY_MAX];
+  size_t len = strlen(key);
+  if (len >= TOPK_KEY_MAX) {
+    len = TOPK_KEY_MAX - 1;
+    memcpy(cut, key, len);
+    cut[len] = '\0';
+    key = cut;
+  }
+  uint64_t hash = sketch_hash(key, len);
+  uint64_t slot = _topk_slot(t, key, hash);
+  t->total++;
+
+  if (t->table[slot] >= 0) {
+    _topk_increment(t, &t->counters[t->table[slot]]);
+    return;
+  }
+
+  struct topk_counter* c;
+  if (t->used < t->capacity) {
+    /*
+     * A free counter starts at 1.
+     */
+    c = &t->counters[t->used++];
+    c->error = 0;
+    struct topk_bucket* b = t->min;
+    if (!b || b->count != 1) {
+      b = _topk_bucket_new(t, 1, NULL);
+    }
+    _topk_attach(c, b);
+  } else {
+    /*
+     * Take over a counter with the smallest count.
+     */
+    c = t->min->first;
+    _topk_unslot(t, _topk_slot(t, c->key, c->hash));
+    slot = _topk_slot(t, key, hash); // The shift may have moved the gap
+    c->error = c->bucket->count;
+    _topk_increment(t, c);
+  }
+  c->hash = hash;
+  memcpy(c->key, key, len + 1);
+  t->table[slot] = c - t->counters;
+}
+
+/*
+ * This function lists the most frequent keys, most frequent first.
+ *
+ * Params:
+ *   t - the tracker.  May not be NULL.
+ *   k - the most keys to list.
+ *   out - filled in with up to `k` keys.  May not be NULL.
+ *
+ * Return:
+ *   Returns the number of keys listed: `k`, or fewer if fewer keys have
+ *   been seen.
+ */
+int topk_top(struct topk* t, int k, struct topk_item* out) {
+  assert(t && out);
+  int n = 0;
+  for (struct topk_bucket* b = t->max; b && n < k; b = b->prev) {
+    for (struct topk_counter* c = b->first; c && n < k; c = c->next) {
+      out[n].key = c->key;
+      out[n].count = b->count;
+      out[n].error = c->error;
+      n++;
+    }
+  }
+  return n;
+}
+
+/*
+ * This function returns the number of keys counted so far.
+ */
+long topk_total(struct topk* t) {
+  assert(t);
+  return t->total;
+}
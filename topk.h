@@ -0,0 +1,42 @@
+/*
+ * This file contains the definition of the interface for a heavy-hitter
+ * tracker: it follows a stream of string keys in a fixed number of counters
+ * and reports the most frequent ones, using the Space-Saving algorithm.  You
+ * can find descriptions of the tracker functions, including their
+ * parameters and their return values, in topk.c.
+ */
+
+#ifndef __TOPK_H
+#define __TOPK_H
+
+/*
+ * Keys longer than this, counting the terminating null, are cut short.
+ */
+#define TOPK_KEY_MAX 100
+
+/*
+ * One of the most frequent keys, filled in by topk_top().  The key's true
+ * count lies between `count - error` and `count`.
+ */
+struct topk_item {
+  const char* key;  // Valid until the tracker next changes
+  long count;
+  long error;
+};
+
+/*
+ * Structure used to represent a heavy-hitter tracker.
+ */
+struct topk;
+
+/*
+ * Heavy-hitter tracker interface function prototypes.  Refer to topk.c for
+ * documentation about each of these functions.
+ */
+struct topk* topk_create(int capacity);
+void topk_free(struct topk* t);
+void topk_add(struct topk* t, const char* key);
+int topk_top(struct topk* t, int k, struct topk_item* out);
+long topk_total(struct topk* t);
+
+#endif
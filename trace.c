@@ -0,0 +1,548 @@
+/*
+ * This file contains an implementation of reading and writing call center
+ * traces.  Both formats hold the same events, in order, each at a time in
+ * milliseconds from the start of the trace; times may not go backwards.
+ *
+ * The text format has one event per line:
+ *
+ *   <ms> call <caller_name> <call reason...>   a new call comes in
+ *   <ms> answer                                an agent answers a call
+ *
+ * Blank lines and lines starting with '#' are skipped.  Caller names are a
+ * single word; the reason runs to the end of the line.
+ *
+ * The binary format starts with TRACE_MAGIC, followed by records.  Every
+ * record starts with an unsigned LEB128 varint holding the time since the
+ * previous record shifted left by 2, with the record kind in the low 2
+ * bits:
+ *
+ *   0  answer
+ *   1  call, followed by varints for the caller name ID and reason ID
+ *   2  name definition, followed by varints for the ID and the length,
+ *      and then that many bytes of name
+ *   3  reason definition, laid out like a name definition
+ *
+ * A name or reason is defined once, just before the first call using it,
+ * so the writer never needs the whole vocabulary up front and later calls
+ * cost 3 to 5 bytes.  IDs are small integers chosen by whoever writes the
+ * trace.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "trace.h"
+
+#define TRACE_LINE_MAX 256
+#define TRACE_NAME_MAX 30     // As in Call
+#define TRACE_REASON_MAX 100
+#define TRACE_ID_MAX (1 << 26)
+#define TRACE_BUF_SIZE (1 << 16)
+
+enum { REC_ANSWER, REC_CALL, REC_NAME, REC_REASON };
+
+/*
+ * A table of the names or reasons defined in a binary trace, by ID.
+ */
+struct trace_strings {
+  char** strs;
+  int cap;
+};
+
+/*
+ * This structure is used to represent a trace being read.
+ */
+struct trace_reader {
+  FILE* f;
+  int binary;
+  long long t_ms;             // Time of the last event
+  long line_no;               // Text: lines read so far
+  long long offset;           // Binary: bytes read so far
+  char line[TRACE_LINE_MAX];
+  char name[TRACE_NAME_MAX];
+  char reason[TRACE_REASON_MAX];
+  struct trace_strings names;
+  struct trace_strings reasons;
+  char error[128];
+};
+
+/*
+ * This structure is used to represent a trace being written.  `defined`
+ * marks, for the binary format, the IDs already defined: bit 0 of entry i
+ * for name i and bit 1 for reason i.
+ */
+struct trace_writer {
+  FILE* f;
+  int binary;
+  long long t_ms;             // Time of the last record written
+  unsigned char* buf;
+  int used;
+  long long bytes;            // Bytes flushed to the file so far
+  unsigned char* defined;
+  int defined_cap;
+  int failed;
+};
+
+/*
+ * This function opens a trace for reading, telling the format from its
+ * first bytes.
+ *
+ * Params:
+ *   path - the trace file, or "-" for standard input.  May not be NULL.
+ *
+ * Return:
+ *   Returns a pointer to the new reader, or NULL if the file could not be
+ *   opened.
+ */
+struct trace_reader* trace_reader_open(const char* path) {
+  assert(path);
+  FILE* f = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+  if (!f) {
+    return NULL;
+  }
+  struct trace_reader* r = calloc(1, sizeof(struct trace_reader));
+  assert(r);
+  r->f = f;
+
+  /*
+   * A text trace starts with a digit, '#' or white space, so one character
+   * is enough to tell, and is all ungetc() promises to put back.
+   */
+  int c = getc(f);
+  if (c == TRACE_MAGIC[0]) {
+    char magic[TRACE_MAGIC_LEN];
+    magic[0] = c;
+    if (fread(magic + 1, 1, TRACE_MAGIC_LEN - 1, f) != TRACE_MAGIC_LEN - 1 ||
+        memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_LEN) != 0) {
+      snprintf(r->error, sizeof(r->error), "not a trace");
+    }
+    r->binary = 1;
+    r->offset = TRACE_MAGIC_LEN;
+  } else if (c != EOF) {
+    ungetc(c, f);
+  }
+  return r;
+}
+
+/*
+ * Auxilliary function to record an error in reading a trace.  Returns -1,
+ * for trace_read() to return.
+ */
+static int _trace_fail(struct trace_reader* r, const char* what) {
+  if (r->binary) {
+    snprintf(r->error, sizeof(r->error), "byte %lld: %s", r->offset, what);
+  } else {
+    snprintf(r->error, sizeof(r->error), "line %ld: %s", r->line_no, what);
+  }
+  return -1;
+}
+
+/*
+ * Auxilliary functions to read the next text and binary events.  See
+ * trace_read().
+ */
+static int _trace_read_text(struct trace_reader* r, struct trace_event* ev) {
+  char event[16];
+  long long t_ms;
+  int consumed;
+
+  do {
+    if (!fgets(r->line, sizeof(r->line), r->f)) {
+      return 0;
+    }
+    r->line_no++;
+  } while (r->line[0] == '#' || r->line[strspn(r->line, " \t\r\n")] == '\0');
+
+  if (sscanf(r->line, "%lld %15s %n", &t_ms, event, &consumed) < 2 ||
+      t_ms < r->t_ms) {
+    return _trace_fail(r, "bad event or time going backwards");
+  }
+  ev->t_ms = r->t_ms = t_ms;
+  if (strcmp(event, "call") == 0) {
+    char* rest = r->line + consumed;
+    int name_len = strcspn(rest, " \t\r\n");
+    snprintf(r->name, sizeof(r->name), "%.*s", name_len, rest);
+    rest += name_len + strspn(rest + name_len, " \t");
+    snprintf(r->reason, sizeof(r->reason), "%.*s",
+      (int)strcspn(rest, "\r\n"), rest);
+    ev->type = TRACE_CALL;
+    ev->name = r->name;
+    ev->reason = r->reason;
+  } else if (strcmp(event, "answer") == 0) {
+    ev->type = TRACE_ANSWER;
+    ev->name = ev->reason = NULL;
+  } else {
+    return _trace_fail(r, "unknown event");
+  }
+  return 1;
+}
+
+/*
+ * Reads a varint into `out`.  Returns 1, 0 at a clean end of the trace, or
+ * -1 if the trace ends inside it or it is too long.
+ */
+static int _trace_varint(struct trace_reader* r, unsigned long long* out,
+    int at_start) {
+  unsigned long long v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int c = getc(r->f);
+    if (c == EOF) {
+      return at_start && shift == 0 ? 0 : _trace_fail(r, "truncated record");
+    }
+    r->offset++;
+    v |= (unsigned long long)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      *out = v;
+      return 1;
+    }
+  }
+  return _trace_fail(r, "bad varint");
+}
+
+/*
+ * Reads a definition record's ID and string into the given table.
+ */
+static int _trace_define(struct trace_reader* r, struct trace_strings* t,
+    int max_len) {
+  unsigned long long id, len;
+  if (_trace_varint(r, &id, 0) < 0 || _trace_varint(r, &len, 0) < 0) {
+    return -1;
+  }
+  if (id >= TRACE_ID_MAX || len >= (unsigned long long)max_len) {
+    return _trace_fail(r, "bad definition");
+  }
+  if ((int)id >= t->cap) {
+    int cap = t->cap ? t->cap : 1024;
+    while (cap <= (int)id) {
+      cap *= 2;
+    }
+    t->strs = realloc(t->strs, cap * sizeof(char*));
+    assert(t->strs);
+    memset(t->strs + t->cap, 0, (cap - t->cap) * sizeof(char*));
+    t->cap = cap;
+  }
+  char* s = realloc(t->strs[id], len + 1);
+  assert(s);
+  if (fread(s, 1, len, r->f) != len) {
+    free(s);
+    t->strs[id] = NULL;
+    return _trace_fail(r, "truncated record");
+  }
+  r->offset += len;
+  s[len] = '\0';
+  t->strs[id] = s;
+  return 1;
+}
+
+/*
+ * Looks up a defined name or reason.
+ */
+static const char* _trace_lookup(struct trace_strings* t,
+    unsigned long long id) {
+  return id < (unsigned long long)t->cap ? t->strs[id] : NULL;
+}
+
+static int _trace_read_binary(struct trace_reader* r, struct trace_event* ev) {
+  unsigned long long head, name_id, reason_id;
+  int got;
+
+  for (;;) {
+    if ((got = _trace_varint(r, &head, 1)) <= 0) {
+      return got;
+    }
+    r->t_ms += head >> 2;
+    switch (head & 3) {
+      case REC_ANSWER:
+        ev->t_ms = r->t_ms;
+        ev->type = TRACE_ANSWER;
+        ev->name = ev->reason = NULL;
+        return 1;
+      case REC_CALL:
+        if (_trace_varint(r, &name_id, 0) < 0 ||
+            _trace_varint(r, &reason_id, 0) < 0) {
+          return -1;
+        }
+        ev->t_ms = r->t_ms;
+        ev->type = TRACE_CALL;
+        ev->name = _trace_lookup(&r->names, name_id);
+        ev->reason = _trace_lookup(&r->reasons, reason_id);
+        if (!ev->name || !ev->reason) {
+          return _trace_fail(r, "call with an undefined name or reason");
+        }
+        return 1;
+      case REC_NAME:
+        if (_trace_define(r, &r->names, TRACE_NAME_MAX) < 0) {
+          return -1;
+        }
+        break;
+      case REC_REASON:
+        if (_trace_define(r, &r->reasons, TRACE_REASON_MAX) < 0) {
+          return -1;
+        }
+        break;
+    }
+  }
+}
+
+/*
+ * This function reads the next event from a trace.
+ *
+ * Params:
+ *   r - the trace reader.  May not be NULL.
+ *   ev - filled in with the event.  May not be NULL.
+ *
+ * Return:
+ *   Returns 1 if an event was read, 0 at the end of the trace, or -1 if
+ *   the trace is malformed (see trace_reader_error()).
+ */
+int trace_read(struct trace_reader* r, struct trace_event* ev) {
+  assert(r && ev);
+  if (r->error[0]) {
+    return -1;
+  }
+  return r->binary ? _trace_read_binary(r, ev) : _trace_read_text(r, ev);
+}
+
+/*
+ * This function describes why trace_read() last failed, with the line or
+ * byte offset it failed at.
+ */
+const char* trace_reader_error(struct trace_reader* r) {
+  assert(r);
+  return r->error;
+}
+
+/*
+ * This function returns 1 if a trace is in the binary format, or 0 if it
+ * is text.
+ */
+int trace_reader_binary(struct trace_reader* r) {
+  assert(r);
+  return r->binary;
+}
+
+/*
+ * Auxilliary function to free a table of defined strings.
+ */
+static void _trace_strings_free(struct trace_strings* t) {
+  for (int i = 0; i < t->cap; i++) {
+    free(t->strs[i]);
+  }
+  free(t->strs);
+}
+
+/*
+ * This function closes a trace being read and frees the reader.
+ *
+ * Params:
+ *   r - the trace reader.  May not be NULL.
+ */
+void trace_reader_close(struct trace_reader* r) {
+  assert(r);
+  if (r->f != stdin) {
+    fclose(r->f);
+  }
+  _trace_strings_free(&r->names);
+  _trace_strings_free(&r->reasons);
+  free(r);
+}
+
+/*
+ * Auxilliary function to write out a trace writer's buffer.
+ */
+static void _trace_flush(struct trace_writer* w) {
+  if (w->used > 0 && fwrite(w->buf, 1, w->used, w->f) != (size_t)w->used) {
+    w->failed = 1;
+  }
+  w->bytes += w->used;
+  w->used = 0;
+}
+
+/*
+ * Auxilliary functions to append bytes and varints to a trace writer's
+ * buffer.  Callers make room first; no single record needs more than
+ * TRACE_LINE_MAX bytes.
+ */
+static void _trace_reserve(struct trace_writer* w) {
+  if (w->used > TRACE_BUF_SIZE - TRACE_LINE_MAX) {
+    _trace_flush(w);
+  }
+}
+
+static void _trace_put_varint(struct trace_writer* w, unsigned long long v) {
+  while (v >= 0x80) {
+    w->buf[w->used++] = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  w->buf[w->used++] = (unsigned char)v;
+}
+
+static void _trace_put_str(struct trace_writer* w, const char* s, int max) {
+  int len = strlen(s);
+  if (len > max) {
+    len = max;
+  }
+  memcpy(w->buf + w->used, s, len);
+  w->used += len;
+}
+
+/*
+ * This function creates a trace file and writes its header.
+ *
+ * Params:
+ *   path - the file to write, or "-" for standard output.  May not be NULL.
+ *   binary - 1 to write the binary format, 0 for text.
+ *
+ * Return:
+ *   Returns a pointer to the new writer, or NULL if the file could not be
+ *   created.
+ */
+struct trace_writer* trace_writer_open(const char* path, int binary) {
+  assert(path);
+  FILE* f = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+  if (!f) {
+    return NULL;
+  }
+  struct trace_writer* w = calloc(1, sizeof(struct trace_writer));
+  assert(w);
+  w->f = f;
+  w->binary = binary;
+  w->buf = malloc(TRACE_BUF_SIZE);
+  assert(w->buf);
+  if (binary) {
+    memcpy(w->buf, TRACE_MAGIC, TRACE_MAGIC_LEN);
+    w->used = TRACE_MAGIC_LEN;
+  }
+  return w;
+}
+
+/*
+ * Auxilliary function to write `t_ms` in decimal.
+ */
+static void _trace_put_ms(struct trace_writer* w, long long t_ms) {
+  char digits[24];
+  int n = 0;
+  do {
+    digits[n++] = '0' + t_ms % 10;
+    t_ms /= 10;
+  } while (t_ms > 0);
+  while (n > 0) {
+    w->buf[w->used++] = digits[--n];
+  }
+}
+
+/*
+ * Auxilliary function to define a name or reason in a binary trace the
+ * first time it is used.  `bit` is 1 for names and 2 for reasons.
+ */
+static void _trace_define_once(struct trace_writer* w, int id, int bit,
+    int kind, const char* s, int max) {
+  if (id >= w->defined_cap) {
+    int cap = w->defined_cap ? w->defined_cap : 1024;
+    while (cap <= id) {
+      cap *= 2;
+    }
+    w->defined = realloc(w->defined, cap);
+    assert(w->defined);
+    memset(w->defined + w->defined_cap, 0, cap - w->defined_cap);
+    w->defined_cap = cap;
+  }
+  if (!(w->defined[id] & bit)) {
+    size_t len = strlen(s);
+    _trace_reserve(w);
+    _trace_put_varint(w, kind);
+    _trace_put_varint(w, id);
+    _trace_put_varint(w, len < (size_t)max ? (int)len : max);
+    _trace_put_str(w, s, max);
+    w->defined[id] |= bit;
+  }
+}
+
+/*
+ * This function writes a call to a trace.
+ *
+ * Params:
+ *   w - the trace writer.  May not be NULL.
+ *   t_ms - the time of the call.  Must not be before the last event.
+ *   name_id, name - the caller's name, and an ID for it that always goes
+ *     with the same name.  The name must be a single word, and is cut to
+ *     29 characters.
+ *   reason_id, reason - the call reason and its ID, likewise.  The reason
+ *     is cut to 99 characters.
+ */
+void trace_write_call(struct trace_writer* w, long long t_ms, int name_id,
+    const char* name, int reason_id, const char* reason) {
+  assert(w && t_ms >= w->t_ms && name_id >= 0 && reason_id >= 0);
+  assert(name_id < TRACE_ID_MAX && reason_id < TRACE_ID_MAX);
+  if (w->binary) {
+    _trace_define_once(w, name_id, 1, REC_NAME, name, TRACE_NAME_MAX - 1);
+    _trace_define_once(w, reason_id, 2, REC_REASON, reason,
+      TRACE_REASON_MAX - 1);
+    _trace_reserve(w);
+    _trace_put_varint(w, (unsigned long long)(t_ms - w->t_ms) << 2 | REC_CALL);
+    _trace_put_varint(w, name_id);
+    _trace_put_varint(w, reason_id);
+  } else {
+    _trace_reserve(w);
+    _trace_put_ms(w, t_ms);
+    memcpy(w->buf + w->used, " call ", 6);
+    w->used += 6;
+    _trace_put_str(w, name, TRACE_NAME_MAX - 1);
+    w->buf[w->used++] = ' ';
+    _trace_put_str(w, reason, TRACE_REASON_MAX - 1);
+    w->buf[w->used++] = '\n';
+  }
+  w->t_ms = t_ms;
+}
+
+/*
+ * This function writes an answer to a trace.
+ *
+ * Params:
+ *   w - the trace writer.  May not be NULL.
+ *   t_ms - the time of the answer.  Must not be before the last event.
+ */
+void trace_write_answer(struct trace_writer* w, long long t_ms) {
+  assert(w && t_ms >= w->t_ms);
+  _trace_reserve(w);
+  if (w->binary) {
+    _trace_put_varint(w, (unsigned long long)(t_ms - w->t_ms) << 2 | REC_ANSWER);
+  } else {
+    _trace_put_ms(w, t_ms);
+    memcpy(w->buf + w->used, " answer\n", 8);
+    w->used += 8;
+  }
+  w->t_ms = t_ms;
+}
+
+/*
+ * This function returns the number of bytes written to a trace so far.
+ */
+long long trace_writer_bytes(struct trace_writer* w) {
+  assert(w);
+  return w->bytes + w->used;
+}
+
+/*
+ * This function finishes writing a trace and frees the writer.
+ *
+ * Params:
+ *   w - the trace writer.  May not be NULL.
+ *
+ * Return:
+ *   Returns 0 if the whole trace was written, or -1 on a write error.
+ */
+int trace_writer_close(struct trace_writer* w) {
+  assert(w);
+  _trace_flush(w);
+  int failed = w->failed || fflush(w->f) != 0;
+  if (w->f != stdout && fclose(w->f) != 0) {
+    failed = 1;
+  }
+  free(w->buf);
+  free(w->defined);
+  free(w);
+  return failed ? -1 : 0;
+}
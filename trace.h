@@ -0,0 +1,54 @@
+/*
+ * This file contains the definition of the interface for reading and
+ * writing call center traces: timed sequences of calls coming in and
+ * agents answering, as replayed by `callcenter --replay` and produced by
+ * tracegen.  Traces come in a text format and a compact binary one; both
+ * are described in trace.c, along with the functions below.
+ */
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+/*
+ * The first bytes of a binary trace.  A trace starting with anything else
+ * is read as text.
+ */
+#define TRACE_MAGIC "CCTRACE\001"
+#define TRACE_MAGIC_LEN 8
+
+/*
+ * Structures used to represent a trace being read or written.
+ */
+struct trace_reader;
+struct trace_writer;
+
+enum trace_type { TRACE_CALL, TRACE_ANSWER };
+
+/*
+ * One event read from a trace.  `name` and `reason` are set for calls and
+ * stay valid until the next event is read.
+ */
+struct trace_event {
+  long long t_ms;         // Milliseconds from the start of the trace
+  enum trace_type type;
+  const char* name;
+  const char* reason;
+};
+
+/*
+ * Trace interface function prototypes.  Refer to trace.c for documentation
+ * about each of these functions.
+ */
+struct trace_reader* trace_reader_open(const char* path);
+int trace_read(struct trace_reader* r, struct trace_event* ev);
+const char* trace_reader_error(struct trace_reader* r);
+int trace_reader_binary(struct trace_reader* r);
+void trace_reader_close(struct trace_reader* r);
+struct trace_writer* trace_writer_open(const char* path, int binary);
+void trace_write_call(struct trace_writer* w, long long t_ms, int name_id,
+  const char* name, int reason_id, const char* reason);
+void trace_write_answer(struct trace_writer* w, long long t_ms);
+long long trace_writer_bytes(struct trace_writer* w);
+int trace_writer_close(struct trace_writer* w);
+
+#endif
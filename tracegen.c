@@ -0,0 +1,403 @@
+/*
+ * This file contains a generator of synthetic call center traces for
+ * `callcenter --replay` and the benchmarks.  Calls arrive as a Poisson
+ * process whose rate follows a daily curve (a cosine peaking at a set hour,
+ * held for a minute at a time) and is modulated by a two-state Markov
+ * chain, so the trace has bursts: normal periods and bursts of a higher
+ * rate alternate, each lasting an exponentially distributed time.  Agents
+ * answer as another Poisson process following the same daily curve, as if
+ * staffed to it.  Caller names and
+ * call reasons are drawn from Zipf distributions, so a few callers call
+ * again and again and a few reasons dominate.
+ *
+ * The trace starts at midnight.  Everything is drawn from one seeded
+ * generator, so the same options and seed always give the same trace.
+ *
+ * Usage: ./tracegen [options] > TRACE
+ *
+ *   --seed=N               seed for the random numbers (default 1)
+ *   --events=N             events to write (default 1000000)
+ *   --duration=SECONDS     stop at this trace time, if sooner (default none)
+ *   --rate=CALLS_PER_S     calls per second, averaged over a day (default 10)
+ *   --answer-rate=N        answers per second, averaged over a day
+ *                          (default 1.05 times the call rate, bursts
+ *                          included)
+ *   --diurnal=AMPLITUDE    swing of the daily curve, 0 to 1 (default 0.6)
+ *   --peak-hour=H          hour of the daily peak (default 14)
+ *   --burst=FACTOR         call rate multiplier during bursts (default 3,
+ *                          1 for none)
+ *   --burst-every=SECONDS  mean time between bursts (default 3600)
+ *   --burst-length=SECONDS mean length of a burst (default 300)
+ *   --callers=N            distinct callers (default 100000)
+ *   --caller-skew=S        Zipf exponent for callers (default 1.0)
+ *   --reasons=N            distinct call reasons (default 200)
+ *   --reason-skew=S        Zipf exponent for reasons (default 1.2)
+ *   --binary               write the binary format (see trace.c)
+ *   --output=PATH          file to write (default standard output)
+ *
+ * A summary, with the time taken, goes to standard error.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "timeutil.h"
+#include "trace.h"
+
+#define PI 3.14159265358979323846
+
+/*
+ * State of the random number generator: xoshiro256**, seeded through
+ * splitmix64.
+ */
+uint64_t rng[4];
+
+uint64_t rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+uint64_t next64() {
+  uint64_t result = rotl(rng[1] * 5, 7) * 9;
+  uint64_t t = rng[1] << 17;
+  rng[2] ^= rng[0];
+  rng[3] ^= rng[1];
+  rng[1] ^= rng[2];
+  rng[0] ^= rng[3];
+  rng[2] ^= t;
+  rng[3] = rotl(rng[3], 45);
+  return result;
+}
+
+void seed_rng(uint64_t seed) {
+  for (int i = 0; i < 4; i++) {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    rng[i] = z ^ (z >> 31);
+  }
+}
+
+/*
+ * Returns a uniform double in [0, 1).
+ */
+double uniform() {
+  return (next64() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * Returns an exponentially distributed time with the given rate.
+ */
+double exponential(double rate) {
+  return -log1p(-uniform()) / rate;
+}
+
+/*
+ * A Zipf distribution over 0 to n - 1, where i has weight 1 / (i + 1)^s,
+ * sampled in O(1) time with Vose's alias method.
+ */
+struct zipf {
+  int n;
+  double* prob;
+  int* alias;
+};
+
+void zipf_init(struct zipf* z, int n, double s) {
+  double* w = malloc(n * sizeof(double));
+  int* small = malloc(n * sizeof(int));
+  int* large = malloc(n * sizeof(int));
+  int n_small = 0, n_large = 0;
+  double sum = 0;
+
+  z->n = n;
+  z->prob = malloc(n * sizeof(double));
+  z->alias = malloc(n * sizeof(int));
+  for (int i = 0; i < n; i++) {
+    w[i] = pow(i + 1, -s);
+    sum += w[i];
+  }
+  for (int i = 0; i < n; i++) {
+    w[i] *= n / sum;
+    if (w[i] < 1) {
+      small[n_small++] = i;
+    } else {
+      large[n_large++] = i;
+    }
+  }
+  while (n_small > 0 && n_large > 0) {
+    int lo = small[--n_small], hi = large[n_large - 1];
+    z->prob[lo] = w[lo];
+    z->alias[lo] = hi;
+    w[hi] -= 1 - w[lo];
+    if (w[hi] < 1) {
+      n_large--;
+      small[n_small++] = hi;
+    }
+  }
+  while (n_large > 0) {
+    z->prob[large[--n_large]] = 1;
+  }
+  while (n_small > 0) {
+    z->prob[small[--n_small]] = 1; // Rounding leftovers
+  }
+  free(w);
+  free(small);
+  free(large);
+}
+
+int zipf_sample(struct zipf* z) {
+  uint64_t u = next64();
+  int i = (int)(((u >> 32) * (uint64_t)z->n) >> 32);
+  return (uint32_t)u * (1.0 / 4294967296.0) < z->prob[i] ? i : z->alias[i];
+}
+
+/*
+ * Words caller names and call reasons are made from.
+ */
+const char* first_names[32] = {
+  "Maria", "James", "Wei", "Aisha", "Carlos", "Yuki", "Olga", "Ahmed",
+  "Priya", "John", "Fatima", "Lucas", "Mei", "David", "Sofia", "Kwame",
+  "Anna", "Omar", "Elena", "Raj", "Grace", "Ivan", "Lena", "Diego",
+  "Hana", "Peter", "Zara", "Tom", "Nina", "Ali", "Rosa", "Ken"
+};
+const char* last_names[32] = {
+  "Garcia", "Smith", "Wang", "Khan", "Silva", "Tanaka", "Ivanova", "Ali",
+  "Patel", "Brown", "Hassan", "Martin", "Chen", "Jones", "Rossi", "Mensah",
+  "Novak", "Farouk", "Popescu", "Kumar", "Kim", "Petrov", "Weber", "Lopez",
+  "Sato", "Miller", "Ahmed", "Nguyen", "Berg", "Yilmaz", "Costa", "Ito"
+};
+const char* reason_words[32] = {
+  "Billing question", "Password reset", "Cancel subscription",
+  "Upgrade plan", "Refund request", "Delivery delayed", "Damaged item",
+  "Change address", "Technical problem", "Account locked",
+  "Update payment method", "Report outage", "Order status",
+  "Warranty claim", "Complaint", "Return an item", "Activate service",
+  "Slow connection", "Wrong charge", "Close account", "New customer",
+  "Loyalty points", "Appointment booking", "Lost card", "Fraud report",
+  "Contract renewal", "Invoice copy", "Installation help",
+  "Device not working", "Promotion inquiry", "Speak to a manager",
+  "Other"
+};
+
+/*
+ * Fills in the name of caller `id`, unique for each ID.
+ */
+void caller_name(int id, char* out, size_t size) {
+  const char* first = first_names[id % 32];
+  const char* last = last_names[id / 32 % 32];
+  if (id < 1024) {
+    snprintf(out, size, "%s%s", first, last);
+  } else {
+    snprintf(out, size, "%s%s%d", first, last, id / 1024);
+  }
+}
+
+/*
+ * Fills in call reason `id`, unique for each ID.
+ */
+void call_reason(int id, char* out, size_t size) {
+  if (id < 32) {
+    snprintf(out, size, "%s", reason_words[id]);
+  } else {
+    snprintf(out, size, "%s, case %d", reason_words[id % 32], id / 32);
+  }
+}
+
+/*
+ * Options, with their defaults.
+ */
+long long max_events = 1000000;
+double duration_s = 0;
+double call_rate = 10, answer_rate = 0;
+double diurnal = 0.6, peak_hour = 14;
+double burst = 3, burst_every_s = 3600, burst_length_s = 300;
+
+/*
+ * The daily curve: a rate multiplier for each minute of the day, averaging
+ * 1 over the day.  Holding the rate for a minute at a time lets arrivals be
+ * drawn directly, one exponential gap each, rather than by thinning.
+ */
+double daily[1440];
+
+void init_daily() {
+  for (int m = 0; m < 1440; m++) {
+    daily[m] = 1 + diurnal * cos(2 * PI * ((m + 0.5) / 60 - peak_hour) / 24);
+  }
+}
+
+/*
+ * Returns the time of the next arrival after `t` for a process with rate
+ * `rate` times the daily curve, in seconds, unless that falls on or after
+ * `until`; then returns `until`.  Gaps that run past the end of a minute
+ * are drawn again from there at the next minute's rate, which the
+ * memorylessness of the process allows.
+ */
+double next_arrival(double t, double rate, double until) {
+  for (;;) {
+    double minute = floor(t / 60);
+    double end = (minute + 1) * 60 < until ? (minute + 1) * 60 : until;
+    t += exponential(rate * daily[(long long)minute % 1440]);
+    if (t < end) {
+      return t;
+    }
+    if (end == until) {
+      return until;
+    }
+    t = end;
+  }
+}
+
+/*
+ * State of the call arrival process: the time of the last call, whether a
+ * burst is on, and when that changes.
+ */
+double call_t = 0, switch_t = 0;
+int bursting = 0;
+
+/*
+ * Returns the time of the next call, in seconds.  When the burst state
+ * changes first, drawing starts afresh from that moment at the new rate.
+ */
+double next_call() {
+  for (;;) {
+    double until = burst > 1 ? switch_t : INFINITY;
+    call_t = next_arrival(call_t, call_rate * (bursting ? burst : 1), until);
+    if (call_t < until) {
+      return call_t;
+    }
+    bursting = !bursting;
+    switch_t += exponential(1 / (bursting ? burst_length_s : burst_every_s));
+  }
+}
+
+int main(int argc, char** argv) {
+  uint64_t seed = 1;
+  int callers = 100000, reasons = 200, binary = 0;
+  double caller_skew = 1.0, reason_skew = 1.2;
+  const char* output = "-";
+
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--seed=", 7) == 0) {
+      seed = strtoull(argv[i] + 7, NULL, 10);
+    } else if (strncmp(argv[i], "--events=", 9) == 0) {
+      max_events = atoll(argv[i] + 9);
+    } else if (strncmp(argv[i], "--duration=", 11) == 0) {
+      duration_s = atof(argv[i] + 11);
+    } else if (strncmp(argv[i], "--rate=", 7) == 0) {
+      call_rate = atof(argv[i] + 7);
+    } else if (strncmp(argv[i], "--answer-rate=", 14) == 0) {
+      answer_rate = atof(argv[i] + 14);
+    } else if (strncmp(argv[i], "--diurnal=", 10) == 0) {
+      diurnal = atof(argv[i] + 10);
+    } else if (strncmp(argv[i], "--peak-hour=", 12) == 0) {
+      peak_hour = atof(argv[i] + 12);
+    } else if (strncmp(argv[i], "--burst=", 8) == 0) {
+      burst = atof(argv[i] + 8);
+    } else if (strncmp(argv[i], "--burst-every=", 14) == 0) {
+      burst_every_s = atof(argv[i] + 14);
+    } else if (strncmp(argv[i], "--burst-length=", 15) == 0) {
+      burst_length_s = atof(argv[i] + 15);
+    } else if (strncmp(argv[i], "--callers=", 10) == 0) {
+      callers = atoi(argv[i] + 10);
+    } else if (strncmp(argv[i], "--caller-skew=", 14) == 0) {
+      caller_skew = atof(argv[i] + 14);
+    } else if (strncmp(argv[i], "--reasons=", 10) == 0) {
+      reasons = atoi(argv[i] + 10);
+    } else if (strncmp(argv[i], "--reason-skew=", 14) == 0) {
+      reason_skew = atof(argv[i] + 14);
+    } else if (strcmp(argv[i], "--binary") == 0) {
+      binary = 1;
+    } else if (strncmp(argv[i], "--output=", 9) == 0) {
+      output = argv[i] + 9;
+    } else {
+      fprintf(stderr, "Unknown option %s; see tracegen.c for usage\n", argv[i]);
+      return 1;
+    }
+  }
+  if (answer_rate <= 0) {
+    // Bursts add to the average call rate; keep up with that
+    double mean = burst > 1 ? (burst_every_s + burst * burst_length_s) /
+      (burst_every_s + burst_length_s) : 1;
+    answer_rate = 1.05 * call_rate * mean;
+  }
+  if (call_rate <= 0 || callers < 1 || reasons < 1 || diurnal < 0 ||
+      diurnal >= 1 || burst_every_s <= 0 || burst_length_s <= 0) {
+    fprintf(stderr, "Rates, callers and reasons must be positive, and the "
+      "daily swing between 0 and 1\n");
+    return 1;
+  }
+
+  struct trace_writer* w = trace_writer_open(output, binary);
+  if (!w) {
+    perror(output);
+    return 1;
+  }
+
+  /*
+   * Names and reasons are made once up front; the trace refers to them by
+   * their rank in popularity.
+   */
+  char (*names)[30] = malloc((size_t)callers * 30);
+  char (*reason_strs)[100] = malloc((size_t)reasons * 100);
+  for (int i = 0; i < callers; i++) {
+    caller_name(i, names[i], 30);
+  }
+  for (int i = 0; i < reasons; i++) {
+    call_reason(i, reason_strs[i], 100);
+  }
+  init_daily();
+  seed_rng(seed);
+  struct zipf caller_dist, reason_dist;
+  zipf_init(&caller_dist, callers, caller_skew);
+  zipf_init(&reason_dist, reasons, reason_skew);
+
+  long long start = now_ns();
+  long long events = 0, calls = 0;
+  switch_t = exponential(1 / burst_every_s);
+  double call_at = next_call();
+  double answer_at = next_arrival(0, answer_rate, INFINITY);
+  double end_t = duration_s > 0 ? duration_s : INFINITY, last_t = 0;
+  while (events < max_events) {
+    if (call_at <= answer_at) {
+      if (call_at >= end_t) {
+        break;
+      }
+      int name = zipf_sample(&caller_dist), reason = zipf_sample(&reason_dist);
+      trace_write_call(w, (long long)(call_at * 1000), name, names[name],
+        reason, reason_strs[reason]);
+      last_t = call_at;
+      call_at = next_call();
+      calls++;
+    } else {
+      if (answer_at >= end_t) {
+        break;
+      }
+      trace_write_answer(w, (long long)(answer_at * 1000));
+      last_t = answer_at;
+      answer_at = next_arrival(answer_at, answer_rate, INFINITY);
+    }
+    events++;
+  }
+
+  long long bytes = trace_writer_bytes(w);
+  if (trace_writer_close(w) != 0) {
+    perror(output);
+    return 1;
+  }
+  double elapsed = (now_ns() - start) / 1e9;
+  fprintf(stderr, "%lld events (%lld calls, %lld answers) over %.1f hours "
+    "of trace, %s, %.1f MB (%.1f bytes per event)\n", events, calls,
+    events - calls, last_t / 3600,
+    binary ? "binary" : "text", bytes / 1e6, (double)bytes / events);
+  fprintf(stderr, "Generated in %.2f s, %.1f M events/s\n", elapsed,
+    events / elapsed / 1e6);
+  free(names);
+  free(reason_strs);
+  free(caller_dist.prob);
+  free(caller_dist.alias);
+  free(reason_dist.prob);
+  free(reason_dist.alias);
+  return 0;
+}
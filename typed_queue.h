@@ -0,0 +1,103 @@
+/*
+ * This file contains a macro that generates a queue specialized for one
+ * element type.  Unlike the queue in queue.h, which stores void pointers,
+ * a generated queue stores its elements by value in a circular buffer, so
+ * enqueueing an int or a Call needs no allocation of its own and reading
+ * one needs no extra pointer dereference.  All functions are static inline
+ * so the compiler can inline them into the caller.
+ *
+ * For example,
+ *
+ *   DEFINE_QUEUE(call_queue, Call)
+ *
+ * defines `struct call_queue` along with call_queue_create(),
+ * call_queue_free(), call_queue_isempty(), call_queue_size(),
+ * call_queue_enqueue(), call_queue_front(), call_queue_dequeue() and
+ * call_queue_get(), which behave like their counterparts in queue.c but take
+ * and return `Call` values.  The generated functions for an empty queue
+ * (front, dequeue) must not be called; check *_isempty() first.
+ */
+
+#ifndef __TYPED_QUEUE_H
+#define __TYPED_QUEUE_H
+
+#include <stdlib.h>
+#include <assert.h>
+
+#define TYPED_QUEUE_INIT_CAPACITY 16
+
+#define DEFINE_QUEUE(name, T)                                                 \
+                                                                              \
+struct name {                                                                 \
+  T* data;                                                                    \
+  int size;                                                                   \
+  int capacity; /* Always a power of two, so indexing can use a mask */      \
+  int start;                                                                  \
+};                                                                            \
+                                                                              \
+static inline struct name* name##_create() {                                  \
+  struct name* q = malloc(sizeof(struct name));                               \
+  assert(q);                                                                  \
+  q->data = malloc(TYPED_QUEUE_INIT_CAPACITY * sizeof(T));                    \
+  assert(q->data);                                                            \
+  q->size = 0;                                                                \
+  q->capacity = TYPED_QUEUE_INIT_CAPACITY;                                    \
+  q->start = 0;                                                               \
+  return q;                                                                   \
+}                                                                             \
+                                                                              \
+static inline void name##_free(struct name* q) {                              \
+  assert(q);                                                                  \
+  free(q->data);                                                              \
+  free(q);                                                                    \
+}                                                                             \
+                                                                              \
+static inline int name##_isempty(struct name* q) {                            \
+  return q->size == 0;                                                        \
+}                                                                             \
+                                                                              \
+static inline int name##_size(struct name* q) {                               \
+  return q->size;                                                             \
+}                                                                             \
+                                                                              \
+/* Kept out of line: it is the slow path of enqueue. */                       \
+static void name##_grow(struct name* q) {                                     \
+  T* data = malloc(2 * q->capacity * sizeof(T));                              \
+  assert(data);                                                               \
+  for (int i = 0; i < q->size; i++) {                                         \
+    data[i] = q->data[(q->start + i) & (q->capacity - 1)];                    \
+  }                                                                           \
+  free(q->data);                                                              \
+  q->data = data;                                                             \
+  q->capacity *= 2;                                                           \
+  q->start = 0;                                                               \
+}                                                                             \
+                                                                              \
+static inline void name##_enqueue(struct name* q, T val) {                    \
+  if (q->size == q->capacity) {                                               \
+    name##_grow(q);                                                           \
+  }                                                                           \
+  q->data[(q->start + q->size) & (q->capacity - 1)] = val;                    \
+  q->size++;                                                                  \
+}                                                                             \
+                                                                              \
+static inline T name##_front(struct name* q) {                                \
+  assert(q->size > 0);                                                        \
+  return q->data[q->start];                                                   \
+}                                                                             \
+                                                                              \
+static inline T name##_dequeue(struct name* q) {                              \
+  assert(q->size > 0);                                                        \
+  T val = q->data[q->start];                                                  \
+  q->start = (q->start + 1) & (q->capacity - 1);                              \
+  q->size--;                                                                  \
+  return val;                                                                 \
+}                                                                             \
+                                                                              \
+/* Returns a pointer to the idx-th element from the front. */                 \
+static inline T* name##_get(struct name* q, int idx) {                        \
+  assert(idx >= 0 && idx < q->size);                                          \
+  return &q->data[(q->start + idx) & (q->capacity - 1)];                      \
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * This file contains a macro that generates a stack specialized for one
+ * element type.  Unlike the stack in stack.h, which keeps void pointers in
+ * a linked list, a generated stack stores its elements by value in a
+ * growable array, so pushing needs no per-element allocation.  All
+ * functions are static inline so the compiler can inline them into the
+ * caller.
+ *
+ * For example,
+ *
+ *   DEFINE_STACK(int_stack, int)
+ *
+ * defines `struct int_stack` along with int_stack_create(),
+ * int_stack_free(), int_stack_isempty(), int_stack_size(), int_stack_push(),
+ * int_stack_top(), int_stack_pop() and int_stack_get(), which behave like
+ * their counterparts in stack.c but take and return `int` values.  The
+ * generated functions for an empty stack (top, pop) must not be called;
+ * check *_isempty() first.
+ */
+
+#ifndef __TYPED_STACK_H
+#define __TYPED_STACK_H
+
+#include <stdlib.h>
+#include <assert.h>
+
+#define TYPED_STACK_INIT_CAPACITY 16
+
+#define DEFINE_STACK(name, T)                                                 \
+                                                                              \
+struct name {                                                                 \
+  T* data;                                                                    \
+  int size;                                                                   \
+  int capacity;                                                               \
+};                                                                            \
+                                                                              \
+static inline struct name* name##_create() {                                  \
+  struct name* s = malloc(sizeof(struct name));                               \
+  assert(s);                                                                  \
+  s->data = malloc(TYPED_STACK_INIT_CAPACITY * sizeof(T));                    \
+  assert(s->data);                                                            \
+  s->size = 0;                                                                \
+  s->capacity = TYPED_STACK_INIT_CAPACITY;                                    \
+  return s;                                                                   \
+}                                                                             \
+                                                                              \
+static inline void name##_free(struct name* s) {                              \
+  assert(s);                                                                  \
+  free(s->data);                                                              \
+  free(s);                                                                    \
+}                                                                             \
+                                                                              \
+static inline int name##_isempty(struct name* s) {                            \
+  return s->size == 0;                                                        \
+}                                                                             \
+                                                                              \
+static inline int name##_size(struct name* s) {                               \
+  return s->size;                                                             \
+}                                                                             \
+                                                                              \
+/* Kept out of line: it is the slow path of push. */                          \
+static void name##_grow(struct name* s) {                                     \
+  T* data = realloc(s->data, 2 * s->capacity * sizeof(T));                    \
+  assert(data);                                                               \
+  s->data = data;                                                             \
+  s->capacity *= 2;                                                           \
+}                                                                             \
+                                                                              \
+static inline void name##_push(struct name* s, T val) {                       \
+  if (s->size == s->capacity) {                                               \
+    name##_grow(s);                                                           \
+  }                                                                           \
+  s->data[s->size++] = val;                                                   \
+}                                                                             \
+                                                                              \
+static inline T name##_top(struct name* s) {                                  \
+  assert(s->size > 0);                                                        \
+  return s->data[s->size - 1];                                                \
+}                                                                             \
+                                                                              \
+static inline T name##_pop(struct name* s) {                                  \
+  assert(s->size > 0);                                                        \
+  return s->data[--s->size];                                                  \
+}                                                                             \
+                                                                              \
+/* Returns a pointer to the idx-th element from the top. */                   \
+static inline T* name##_get(struct name* s, int idx) {                        \
+  assert(idx >= 0 && idx < s->size);                                          \
+  return &s->data[s->size - 1 - idx];                                         \
+}
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * This file contains an implementation of sliding-window statistics.
+ * Events are counted in a ring of one-second buckets covering the last
+ * WINSTATS_SECONDS seconds.  Each bucket remembers which second it holds,
+ * so a bucket left over from a previous lap of the ring is recognized as
+ * stale and reset by the first event that lands in it: counting an event
+ * is a division and an increment, whatever the gap since the last one.
+ * Reading a window sums the buckets it covers that are still current.
+ *
+ * Time is passed in by the caller, in nanoseconds, so the statistics work
+ * the same on the real clock and on a replayed trace.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "winstats.h"
+
+/*
+ * This structure is used to represent the events counted in one second.
+ * `second` is the second since `start` the counts belong to, or -1 if the
+ * bucket has never been used.
+ */
+struct winstats_bucket {
+  long long second;
+  long received;
+  long answered;
+  long within;
+};
+
+/*
+ * This structure is used to represent a set of sliding-window statistics.
+ */
+struct winstats {
+  long long target_ns;  // Service-level target for answering a call
+  long long start;      // Time of second 0
+  struct winstats_bucket buckets[WINSTATS_SECONDS];
+};
+
+/*
+ * This function creates a set of sliding-window statistics with no events.
+ *
+ * Params:
+ *   target_ns - calls answered after waiting no longer than this count as
+ *     answered within the service-level target.
+ *   now - the current time in nanoseconds.
+ *
+ * Return:
+ *   Returns a pointer to the new statistics.
+ */
+struct winstats* winstats_create(long long target_ns, long long now) {
+  struct winstats* ws = calloc(1, sizeof(struct winstats));
+  assert(ws);
+  ws->target_ns = target_ns;
+  ws->start = now;
+  for (int i = 0; i < WINSTATS_SECONDS; i++) {
+    ws->buckets[i].second = -1;
+  }
+  return ws;
+}
+
+/*
+ * This function frees the memory associated with a set of statistics.
+ *
+ * Params:
+ *   ws - the statistics to be destroyed.  May not be NULL.
+ */
+void winstats_free(struct winstats* ws) {
+  assert(ws);
+  free(ws);
+}
+
+/*
+ * Auxilliary function to return the bucket for the given time, resetting it
+ * first if it still holds counts from an earlier lap of the ring.
+ */
+static struct winstats_bucket* _winstats_bucket(struct winstats* ws,
+    long long now) {
+  long long second = now > ws->start ? (now - ws->start) / 1000000000LL : 0;
+  struct winstats_bucket* b = &ws->buckets[second % WINSTATS_SECONDS];
+  if (b->second != second) {
+    b->second = second;
+    b->received = 0;
+    b->answered = 0;
+    b->within = 0;
+  }
+  return b;
+}
+
+/*
+ * This function counts a call received.
+ *
+ * Params:
+ *   ws - the statistics.  May not be NULL.
+ *   now - the current time in nanoseconds.  Must not be earlier than the
+ *     time of any event already counted.
+ */
+void winstats_received(struct winstats* ws, long long now) {
+  assert(ws);
+  _winstats_bucket(ws, now)->received++;
+}
+
+/*
+ * This function counts a call answered.
+ *
+ * Params:
+ *   ws - the statistics.  May not be NULL.
+ *   wait_ns - how long the call waited before it was answered.
+ *   now - the current time in nanoseconds.  Must not be earlier than the
+ *     time of any event already counted.
+ */
+void winstats_answered(struct winstats* ws, long long wait_ns, long long now) {
+  assert(ws);
+  struct winstats_bucket* b = _winstats_bucket(ws, now);
+  b->answered++;
+  b->within += wait_ns <= ws->target_ns;
+}
+
+/*
+ * This function sums the events counted over the last `seconds` seconds,
+ * including the current, partly elapsed second.
+ *
+ * Params:
+ *   ws - the statistics.  May not be NULL.
+ *   seconds - the length of the window.  Must be between 1 and
+ *     WINSTATS_SECONDS.
+ *   now - the current time in nanoseconds.
+ *   out - filled in with the counts.  `out->seconds` is shortened to the
+ *     time since the statistics were created, if that is less, so rates
+ *     aren't understated early on, but never below one second.  May not be
+ *     NULL.
+ */
+void winstats_window(struct winstats* ws, int seconds, long long now,
+    struct winstats_window* out) {
+  assert(ws && out && seconds >= 1 && seconds <= WINSTATS_SECONDS);
+  long long elapsed = now > ws->start ? now - ws->start : 0;
+  long long current = elapsed / 1000000000LL;
+
+  out->received = out->answered = out->within = 0;
+  for (long long s = current - seconds + 1; s <= current; s++) {
+    if (s < 0) {
+      continue;
+    }
+    struct winstats_bucket* b = &ws->buckets[s % WINSTATS_SECONDS];
+    if (b->second == s) {
+      out->received += b->received;
+      out->answered += b->answered;
+      out->within += b->within;
+    }
+  }
+  out->seconds = elapsed / 1e9 < seconds ? elapsed / 1e9 : seconds;
+  if (out->seconds < 1) {
+    out->seconds = 1; // Don't turn a call or two into a huge rate
+  }
+}
@@ -0,0 +1,45 @@
+/*
+ * This file contains the definition of the interface for sliding-window
+ * statistics: how many calls were received and answered over the last few
+ * minutes, and how many of the answered calls were answered within a
+ * service-level target.  You can find descriptions of the statistics
+ * functions, including their parameters and their return values, in
+ * winstats.c.
+ */
+
+#ifndef __WINSTATS_H
+#define __WINSTATS_H
+
+/*
+ * Number of one-second buckets kept, and so the longest window that can be
+ * asked for: 15 minutes.
+ */
+#define WINSTATS_SECONDS 900
+
+/*
+ * Statistics for one window, filled in by winstats_window().
+ */
+struct winstats_window {
+  double seconds;  // Length of the window, or less if the program is younger
+  long received;   // Calls received
+  long answered;   // Calls answered
+  long within;     // Calls answered within the service-level target
+};
+
+/*
+ * Structure used to represent a set of sliding-window statistics.
+ */
+struct winstats;
+
+/*
+ * Windowed statistics interface function prototypes.  Refer to winstats.c
+ * for documentation about each of these functions.
+ */
+struct winstats* winstats_create(long long target_ns, long long now);
+void winstats_free(struct winstats* ws);
+void winstats_received(struct winstats* ws, long long now);
+void winstats_answered(struct winstats* ws, long long wait_ns, long long now);
+void winstats_window(struct winstats* ws, int seconds, long long now,
+  struct winstats_window* out);
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * This file contains an implementation of the Chase-Lev work-stealing deque.
+ * The owning thread pushes and pops at the bottom end without taking any
+ * lock; other threads steal from the top end with a single compare-and-swap.
+ * Memory ordering follows Lê, Pop, Cohen and Zappa Nardelli, "Correct and
+ * Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013), written with
+ * the GCC __atomic builtins so the file still builds as C99.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "wsdeque.h"
+
+#define WSDEQUE_INIT_CAPACITY 64
+
+/*
+ * This structure is used to represent the circular buffer behind a deque.
+ * When the buffer grows, the old one is kept on the `prev` chain until the
+ * deque is freed, since a concurrent thief may still be reading from it.
+ */
+struct wsarray {
+  long capacity;
+  void** buf;
+  struct wsarray* prev;
+};
+
+/*
+ * This structure is used to represent a single deque.  `top` is written by
+ * thieves and `bottom` by the owner, so they are kept on separate cache
+ * lines.
+ */
+struct wsdeque {
+  long top;
+  char pad1[64 - sizeof(long)];
+  long bottom;
+  struct wsarray* array;
+  char pad2[64 - sizeof(long) - sizeof(struct wsarray*)];
+};
+
+/*
+ * Auxilliary function to allocate a circular buffer with the given capacity,
+ * which must be a power of two.
+ */
+static struct wsarray* _wsarray_create(long capacity) {
+  struct wsarray* a = malloc(sizeof(struct wsarray));
+  assert(a);
+  a->buf = malloc(capacity * sizeof(void*));
+  assert(a->buf);
+  a->capacity = capacity;
+  a->prev = NULL;
+  return a;
+}
+
+/*
+ * This function allocates and initializes a new, empty deque and returns a
+ * pointer to it.
+ */
+struct wsdeque* wsdeque_create() {
+  struct wsdeque* dq = malloc(sizeof(struct wsdeque));
+  assert(dq);
+  dq->top = 0;
+  dq->bottom = 0;
+  dq->array = _wsarray_create(WSDEQUE_INIT_CAPACITY);
+  return dq;
+}
+
+/*
+ * This function frees the memory associated with a deque, including every
+ * buffer it has grown out of.  Freeing any memory associated with values
+ * still stored in the deque is the responsibility of the caller.  No other
+ * thread may be using the deque when it is freed.
+ *
+ * Params:
+ *   dq - the deque to be destroyed.  May not be NULL.
+ */
+void wsdeque_free(struct wsdeque* dq) {
+  assert(dq);
+  struct wsarray* next, * curr = dq->array;
+  while (curr) {
+    next = curr->prev;
+    free(curr->buf);
+    free(curr);
+    curr = next;
+  }
+  free(dq);
+}
+
+/*
+ * Auxilliary function to double the capacity of a deque's buffer.  Only the
+ * owner calls this, so only the live range [top, bottom) needs copying.
+ */
+static struct wsarray* _wsdeque_grow(struct wsdeque* dq, struct wsarray* a,
+    long top, long bottom) {
+  struct wsarray* bigger = _wsarray_create(2 * a->capacity);
+  for (long i = top; i < bottom; i++) {
+    bigger->buf[i & (bigger->capacity - 1)] = a->buf[i & (a->capacity - 1)];
+  }
+  bigger->prev = a;
+  __atomic_store_n(&dq->array, bigger, __ATOMIC_RELEASE);
+  return bigger;
+}
+
+/*
+ * This function pushes a new value onto the bottom of a deque.  It may only
+ * be called by the deque's owner.
+ *
+ * Params:
+ *   dq - the deque onto which to push a value.  May not be NULL.
+ *   val - the value to be pushed.  May not be NULL, since NULL is used to
+ *     signal an empty deque.
+ */
+void wsdeque_push(struct wsdeque* dq, void* val) {
+  assert(dq && val);
+  long b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED);
+  long t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+  struct wsarray* a = __atomic_load_n(&dq->array, __ATOMIC_RELAXED);
+
+  if (b - t > a->capacity - 1) {
+    a = _wsdeque_grow(dq, a, t, b);
+  }
+
+  __atomic_store_n(&a->buf[b & (a->capacity - 1)], val, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * This function removes and returns the value at the bottom of a deque (the
+ * most recently pushed one).  It may only be called by the deque's owner.
+ *
+ * Params:
+ *   dq - the deque from which to pop a value.  May not be NULL.
+ *
+ * Return:
+ *   Returns the popped value, or NULL if the deque was empty or its last
+ *   value was taken by a thief.
+ */
+void* wsdeque_pop(struct wsdeque* dq) {
+  assert(dq);
+  long b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED) - 1;
+  struct wsarray* a = __atomic_load_n(&dq->array, __ATOMIC_RELAXED);
+  __atomic_store_n(&dq->bottom, b, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  long t = __atomic_load_n(&dq->top, __ATOMIC_RELAXED);
+
+  void* val = NULL;
+  if (t <= b) {
+    val = __atomic_load_n(&a->buf[b & (a->capacity - 1)], __ATOMIC_RELAXED);
+    if (t == b) {
+      /*
+       * This was the last value, so race any thieves for it.
+       */
+      if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1, 0,
+            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        val = NULL;
+      }
+      __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+  } else {
+    __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+  }
+  return val;
+}
+
+/*
+ * This function removes and returns the value at the top of a deque (the
+ * oldest one).  It may be called by any thread.
+ *
+ * Params:
+ *   dq - the deque from which to steal a value.  May not be NULL.
+ *
+ * Return:
+ *   Returns the stolen value, or NULL if the deque was empty or another
+ *   thread won the race for the top value.
+ */
+void* wsdeque_steal(struct wsdeque* dq) {
+  assert(dq);
+  long t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  long b = __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE);
+
+  if (t >= b) {
+    return NULL;
+  }
+
+  struct wsarray* a = __atomic_load_n(&dq->array, __ATOMIC_ACQUIRE);
+  void* val = __atomic_load_n(&a->buf[t & (a->capacity - 1)],
+      __ATOMIC_RELAXED);
+  if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1, 0, __ATOMIC_SEQ_CST,
+        __ATOMIC_RELAXED)) {
+    return NULL;
+  }
+  return val;
+}
+
+/*
+ * This function returns an estimate of the number of values in a deque.  The
+ * value is exact when no other thread is using the deque.
+ */
+int wsdeque_size(struct wsdeque* dq) {
+  assert(dq);
+  long b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED);
+  long t = __atomic_load_n(&dq->top, __ATOMIC_RELAXED);
+  return b > t ? (int)(b - t) : 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * This file contains the definition of the interface for a work-stealing
+ * deque.  You can find descriptions of the deque functions, including their
+ * parameters and their return values, in wsdeque.c.
+ */
+
+#ifndef __WSDEQUE_H
+#define __WSDEQUE_H
+
+/*
+ * Structure used to represent a work-stealing deque.
+ */
+struct wsdeque;
+
+/*
+ * Work-stealing deque interface function prototypes.  wsdeque_push() and
+ * wsdeque_pop() may only be called by the thread that owns the deque;
+ * wsdeque_steal() may be called by any thread.
+ */
+struct wsdeque* wsdeque_create();
+void wsdeque_free(struct wsdeque* dq);
+void wsdeque_push(struct wsdeque* dq, void* val);
+void* wsdeque_pop(struct wsdeque* dq);
+void* wsdeque_steal(struct wsdeque* dq);
+int wsdeque_size(struct wsdeque* dq);
+
+#endif